@@ -27,6 +27,7 @@ namespace linter {
     spdlog::info("\tenable step summary: {}", ctx.enable_step_summary);
     spdlog::info("\tenable update issue comment: {}", ctx.enable_comment_on_issue);
     spdlog::info("\tenable pull request review: {}", ctx.enable_pull_request_review);
+    spdlog::info("\tenable check run: {}", ctx.enable_check_run);
     spdlog::info("\tenable action outptu: {}", ctx.enable_action_output);
     spdlog::info("\trepository path: {}", ctx.repo_path);
     spdlog::info("\trepository: {}", ctx.repo_pair);
@@ -35,6 +36,23 @@ namespace linter {
     spdlog::info("\trepository target: {}", ctx.target);
     spdlog::info("\trepository source: {}", ctx.source);
     spdlog::info("\trepository pull-request number: {}", ctx.pr_number);
+    spdlog::info("\tgithub timeout: {}s", ctx.github_timeout);
+    spdlog::info("\tgithub max retries: {}", ctx.github_max_retries);
+    spdlog::info("\tgithub compression: {}", ctx.github_compression);
+    spdlog::info("\tresult cache directory: {}", ctx.cache_dir);
+    spdlog::info("\ttrace file: {}", ctx.trace_file);
+    spdlog::info("\tresult file: {} ({})",
+                 ctx.result_file,
+                 magic_enum::enum_name(ctx.result_file_format));
+    spdlog::info("\tshard: {}/{}", ctx.shard_index + 1, ctx.shard_count);
+    spdlog::info("\tmax memory: {}MiB", ctx.max_memory);
+    spdlog::info("\ttimeout: {}s", ctx.timeout);
+    spdlog::info("\tallow timed out: {}", ctx.allow_timed_out);
+    spdlog::info("\tfail fast: {}", ctx.fail_fast);
+    spdlog::info("\twatch: {}", ctx.watch);
+    spdlog::info("\tstaged: {}", ctx.staged);
+    spdlog::info("\tshard result file: {}", ctx.shard_result_file);
+    spdlog::info("\tmerged shard results: {}", ctx.merged_shard_results.size());
     spdlog::info("\tcurrent operating system: {}", magic_enum::enum_name(ctx.os));
     spdlog::info("\tcurrent archecture: {}", magic_enum::enum_name(ctx.arch));
     spdlog::info("\tchanged files:");
@@ -17,11 +17,16 @@
 
 #include <cstdint>
 #include <git2/repository.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
+#include "github/annotation.h"
+#include "tools/result_stream.h"
 #include "utils/git_utils.h"
+#include "utils/patch_set.h"
 #include "utils/platform.h"
+#include "utils/repo_pool.h"
 
 namespace linter {
   /// The runtime context for all tools.
@@ -31,6 +36,7 @@ namespace linter {
     bool enable_step_summary        = false;
     bool enable_comment_on_issue    = false;
     bool enable_pull_request_review = false;
+    bool enable_check_run           = false;
     bool enable_action_output       = false;
 
     std::string repo_path;
@@ -41,16 +47,86 @@ namespace linter {
     std::string source;
     std::int32_t pr_number = -1;
 
+    // The timeout in seconds and the number of retries of each Github request.
+    // Responses are accepted in gzip if github_compression is true.
+    std::uint32_t github_timeout     = 30;
+    std::uint32_t github_max_retries = 3;
+    bool github_compression          = true;
+
+    // The directory of the per file result cache. Empty means disabled.
+    std::string cache_dir;
+
+    // The file to write Chrome trace events of all phases. Empty means disabled.
+    std::string trace_file;
+
+    // Only the tasks of the given shard are checked if shard_count > 1.
+    std::uint32_t shard_index = 0;
+    std::uint32_t shard_count = 1;
+
+    // The memory budget in MiB of tasks running at the same time, learned from
+    // the peak memory of their child processes in former runs. 0 means unlimited.
+    std::uint32_t max_memory = 0;
+
+    // The seconds the whole check may take. Tool processes still running then
+    // are killed and their files are reported as timed out. 0 means unlimited.
+    std::uint32_t timeout = 0;
+
+    // Whether the check passes though some files timed out. They fail it by
+    // default since they weren't completely checked.
+    bool allow_timed_out = false;
+
+    // Receives the annotations of failed files while checking if check run is
+    // enabled.
+    std::shared_ptr<github::annotation_sink> annotations;
+
+    // The file to write the result of each file as soon as it's checked, in
+    // the given format. Empty means disabled.
+    std::string result_file;
+    tool::result_stream::format_t result_file_format = tool::result_stream::format_t::jsonl;
+
+    // Receives the results of files while checking if result_file is given.
+    std::shared_ptr<tool::result_stream> results;
+
+    // Stop all tools once any file fails. Tools are run one by one from the
+    // cheapest rather than concurrently then.
+    bool fail_fast = false;
+
+    // The global options of libgit2 applied before the repository is opened.
+    git::tuning git_tuning;
+
+    // Keep running on local and re-check files each time they're saved.
+    bool watch = false;
+
+    // Check the staged changes on local, e.g. by a pre-commit hook. Source
+    // revision is a commit made of the index then.
+    bool staged = false;
+
+    // The file to write the results of this shard. Empty means disabled.
+    std::string shard_result_file;
+
+    // The result files of shards to be merged and reported. No check is done
+    // if it isn't empty.
+    std::vector<std::string> merged_shard_results;
+
     operating_system_t os = operating_system_t::ubuntu;
     arch_t arch           = arch_t::x86_64;
 
     std::vector<std::string> changed_files;
+
+    // Only used by the main thread. Tools and reporters running on several
+    // threads lease their own handles from repos instead, which is null if the
+    // repository isn't opened.
     git::repo_ptr repo{nullptr, ::git_repository_free};
     git::commit_ptr target_commit{nullptr, ::git_commit_free};
     git::commit_ptr source_commit{nullptr, ::git_commit_free};
+    std::unique_ptr<git::repo_pool> repos;
 
     // The diff patches of source revision to target revision.
-    std::unordered_map<std::string, git::patch_ptr> patches;
+    git::patch_set patches;
+
+    // The contents of files in source revision restored from result files,
+    // used instead of the repository which isn't opened when merging them.
+    std::unordered_map<std::string, std::string> source_contents;
   };
 
   void print_context(const runtime_context &ctx);
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace linter::github {
+  /// An annotation of a Github check run, which is shown on the line of the
+  /// file it points to, however far the line is from diff hunks.
+  /// https://docs.github.com/en/rest/checks/runs#update-a-check-run
+  struct annotation {
+    std::string path;
+    std::uint32_t start_line = 0;
+    std::uint32_t end_line   = 0;
+    /// One of notice, warning and failure.
+    std::string annotation_level;
+    std::string title;
+    std::string message;
+    std::string raw_details;
+  };
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    annotation, path, start_line, end_line, annotation_level, title, message, raw_details)
+
+  using annotations = std::vector<annotation>;
+
+  /// Receives the annotations of each file as soon as its check finishes. It's
+  /// called by several tasks concurrently.
+  struct annotation_sink {
+    virtual ~annotation_sink() = default;
+
+    virtual void add(annotations values) = 0;
+
+    /// Called once after all checks finished, with the conclusion of them and
+    /// a markdown summary.
+    virtual void finish(bool passed, const std::string &summary) = 0;
+  };
+
+} // namespace linter::github
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "github/check_run.h"
+
+#include <algorithm>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "utils/util.h"
+
+namespace linter::github {
+  namespace {
+    // Each shard has its own check run.
+    auto make_name(const runtime_context &ctx) -> std::string {
+      if (ctx.shard_count <= 1) {
+        return "cpp-linter";
+      }
+      return std::format("cpp-linter ({}/{})", ctx.shard_index + 1, ctx.shard_count);
+    }
+
+    auto make_key(const annotation &value) -> std::string {
+      return std::format(
+        "{}\n{}\n{}\n{}", value.path, value.start_line, value.title, value.message);
+    }
+  } // namespace
+
+  check_run::check_run(const runtime_context &ctx, std::string head_sha)
+    : ctx_(ctx)
+    , head_sha_(std::move(head_sha))
+    , client_(session::shared(ctx))
+    , uploader_([this] { upload_loop(); }) {
+  }
+
+  check_run::~check_run() {
+    {
+      auto lock = std::scoped_lock{mutex_};
+      stopping_ = true;
+    }
+    cv_.notify_one();
+    if (uploader_.joinable()) {
+      uploader_.join();
+    }
+  }
+
+  void check_run::add(annotations values) {
+    auto full = false;
+    {
+      auto lock = std::scoped_lock{mutex_};
+      for (auto &value: values) {
+        if (added_.insert(make_key(value)).second) {
+          pending_.push_back(std::move(value));
+        }
+      }
+      full = pending_.size() >= max_annotations;
+    }
+    if (full) {
+      cv_.notify_one();
+    }
+  }
+
+  auto check_run::make_output(const std::string &summary, annotations batch) const
+    -> nlohmann::json {
+    auto title = std::format("{} annotations", uploaded_ + batch.size());
+    return {
+      {"title",       std::move(title)},
+      {"summary",     summary         },
+      {"annotations", std::move(batch)}
+    };
+  }
+
+  void check_run::upload_loop() {
+    try {
+      auto body = nlohmann::json{
+        {"name",     make_name(ctx_)},
+        {"head_sha", head_sha_      },
+        {"status",   "in_progress"  }
+      };
+      id_ = client_.create_check_run(ctx_, body);
+    } catch (const std::exception &err) {
+      spdlog::error("Failed to create check run: {}", err.what());
+      auto lock = std::scoped_lock{mutex_};
+      error_    = err.what();
+      return;
+    }
+
+    auto lock = std::unique_lock{mutex_};
+    while (true) {
+      cv_.wait(lock, [&] { return stopping_ || pending_.size() >= max_annotations; });
+      // The remaining ones are uploaded by finish with the conclusion.
+      if (pending_.size() < max_annotations) {
+        return;
+      }
+      auto end   = pending_.begin() + static_cast<std::ptrdiff_t>(max_annotations);
+      auto batch = annotations(std::make_move_iterator(pending_.begin()),
+                               std::make_move_iterator(end));
+      pending_.erase(pending_.begin(), end);
+      auto output  = make_output("Checking", std::move(batch));
+      uploaded_   += max_annotations;
+      lock.unlock();
+
+      try {
+        client_.update_check_run(ctx_, id_, {{"output", std::move(output)}});
+      } catch (const std::exception &err) {
+        spdlog::error("Failed to upload annotations of check run {}: {}", id_, err.what());
+        lock.lock();
+        error_ = err.what();
+        return;
+      }
+      lock.lock();
+    }
+  }
+
+  void check_run::finish(bool passed, const std::string &summary) {
+    {
+      auto lock = std::scoped_lock{mutex_};
+      stopping_ = true;
+    }
+    cv_.notify_one();
+    if (uploader_.joinable()) {
+      uploader_.join();
+    }
+    throw_unless(error_.empty(), std::format("check run isn't completed since: {}", error_));
+
+    // Less than a batch remains, since the uploader drains full batches
+    // before it stops.
+    auto output = make_output(summary, std::move(pending_));
+    auto body   = nlohmann::json{
+      {"status",     "completed"                   },
+      {"conclusion", passed ? "success" : "failure"},
+      {"output",     std::move(output)             }
+    };
+    client_.update_check_run(ctx_, id_, body);
+    spdlog::info("Successfully completed check run {}", id_);
+  }
+
+} // namespace linter::github
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+#include <nlohmann/json.hpp>
+
+#include "context.h"
+#include "github/annotation.h"
+#include "github/client.h"
+
+namespace linter::github {
+  /// Publish annotations as a Github check run rather than a pull request
+  /// review, so diagnostics aren't limited to diff hunks. The check run is
+  /// created and annotations are uploaded by a background thread while files
+  /// are still being checked, each time a batch of the most annotations
+  /// Github accepts by one update is full.
+  class check_run : public annotation_sink {
+  public:
+    check_run(const runtime_context &ctx, std::string head_sha);
+    ~check_run() override;
+
+    check_run(const check_run &)            = delete;
+    check_run &operator=(const check_run &) = delete;
+
+    /// Annotations added before are dropped.
+    void add(annotations values) override;
+
+    /// Upload the remaining annotations and complete the check run. Throw if
+    /// any upload failed.
+    void finish(bool passed, const std::string &summary) override;
+
+    static constexpr auto max_annotations = std::size_t{50};
+
+  private:
+    void upload_loop();
+
+    auto make_output(const std::string &summary, annotations batch) const -> nlohmann::json;
+
+    const runtime_context &ctx_;
+    std::string head_sha_;
+    client client_;
+    std::int64_t id_ = -1;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    annotations pending_;
+    std::unordered_set<std::string> added_;
+    std::size_t uploaded_ = 0;
+    bool stopping_        = false;
+    std::string error_;
+    std::thread uploader_;
+  };
+
+} // namespace linter::github
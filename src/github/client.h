@@ -17,9 +17,11 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <format>
 #include <print>
 #include <string>
 #include <sys/types.h>
+#include <thread>
 #include <utility>
 
 #include <httplib.h>
@@ -27,7 +29,10 @@
 #include <spdlog/spdlog.h>
 
 #include "common.h"
+#include "session.h"
 #include "context.h"
+#include "utils/json_cache.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace linter::github {
@@ -35,7 +40,15 @@ namespace linter::github {
 
   class client {
   public:
+    /// All requests of one run go to the same host, so clients share the
+    /// connection of the session.
+    explicit client(session &session)
+      : session_(session) {
+    }
+
     static void check_http_response(const httplib::Result &response) {
+      throw_unless(static_cast<bool>(response),
+                   std::format("http request error: {}", httplib::to_string(response.error())));
       auto code          = response->status / 100;
       const auto &reason = response->reason;
       throw_unless(code == 1 || code == 2,
@@ -59,61 +72,87 @@ namespace linter::github {
       return name == our_name;
     }
 
+    /// Find the comment of cpp-linter on the pull request. Pages of comments
+    /// are walked by the Link header until our comment is found. The ETag and
+    /// the outcome of each page are cached, so an unchanged page only costs a
+    /// 304 response which doesn't count against the rate limit.
     void get_issue_comment_id(const runtime_context &ctx) {
       spdlog::info("Start to get issue comment id for pull request: {}.", ctx.pr_number);
       assert(std::ranges::contains(github_events_support_comments, ctx.event_name));
 
-      auto path    = std::format("/repos/{}/issues/{}/comments", ctx.repo_pair, ctx.pr_number);
-      auto headers = httplib::Headers{
-        {"Accept", "application/vnd.github+json"},
-        {"Authorization", std::format("token {}", ctx.token)}
-      };
-      spdlog::info("Http request path: {}", path);
+      auto repo_name = ctx.repo_pair;
+      std::ranges::replace(repo_name, '/', '-');
+      auto cache     = json_cache{ctx.cache_dir, "github"};
+      auto cache_key = std::format("issue-comments-{}-{}", repo_name, ctx.pr_number);
+      auto pages     = cache.load(cache_key).value_or(nlohmann::json::object());
 
-      auto response = client.Get(path, headers);
+      auto path = std::format("/repos/{}/issues/{}/comments?per_page=100",
+                              ctx.repo_pair,
+                              ctx.pr_number);
+      while (true) {
+        auto headers = session_.json_headers();
+        auto &page = pages[path];
+        if (page.contains("etag")) {
+          headers.emplace("If-None-Match", page["etag"].get<std::string>());
+        }
+        spdlog::info("Http request path: {}", path);
 
-      check_http_response(response);
-      spdlog::trace("Get github response body: {}", response->body);
+        auto response = send(path, [&](httplib::Client &http) { return http.Get(path, headers); });
+        if (response && response->status == 304) {
+          spdlog::debug("The comments page {} is unchanged", path);
+        } else {
+          check_http_response(response);
+          spdlog::trace("Get github response body: {}", response->body);
+          page = make_comments_page(*response);
+        }
 
-      // data type check
-      auto comments = nlohmann::json::parse(response->body);
-      if (comments.is_null()) {
-        spdlog::info("The pull request number {} doesn't have any comments yet", ctx.pr_number);
-        return;
+        if (page["comment_id"].get<std::int64_t>() != -1) {
+          page["comment_id"].get_to(comment_id_);
+          comment_hash_ = page.value("hash", "");
+          spdlog::info("Successfully got comment id {} of pr {}", comment_id_, ctx.pr_number);
+          break;
+        }
+        if (page["next"].get_ref<const std::string &>().empty()) {
+          spdlog::info("The cpp-lint doesn't comments on pull request number {} yet",
+                       ctx.pr_number);
+          break;
+        }
+        path = page["next"].get<std::string>();
       }
-      throw_unless(comments.is_array(), "issue comments are not an array");
-      if (comments.empty()) {
-        spdlog::info("The pull request number {} doesn't have any comments yet", ctx.pr_number);
-        return;
-      }
-
-      auto comment = std::ranges::find_if(comments, is_our_comment);
-      if (comment == comments.end()) {
-        spdlog::info("The cpp-lint doesn't comments on pull request number {} yet", ctx.pr_number);
-        return;
-      }
-
-      (*comment)["id"].get_to(comment_id_);
-      spdlog::info("Successfully got comment id {} of pr {}", comment_id_, ctx.pr_number);
+      cache.store(cache_key, pages);
     }
 
     void add_issue_comment(const runtime_context &ctx, const std::string &body) {
       spdlog::info("Start to add issue comment for pr {}", ctx.pr_number);
 
-      const auto path    = std::format("/repos/{}/issues/{}/comments", ctx.repo_pair, ctx.pr_number);
-      const auto headers = httplib::Headers{
-        {"Accept", "application/vnd.github.use_diff"},
-        {"Authorization", std::format("token {}", ctx.token)}
-      };
+      const auto path =
+        std::format("/repos/{}/issues/{}/comments", ctx.repo_pair, ctx.pr_number);
+      const auto &headers = session_.diff_headers();
       spdlog::info("Http request path: {}", path);
 
       auto json_body    = nlohmann::json{};
       json_body["body"] = body;
       spdlog::trace("Http request body:\n{}", json_body.dump());
 
-      auto response = client.Post(path, headers, json_body.dump(), "text/plain");
-      spdlog::trace("Get github response body: {}", response->body);
+      auto post = [&](httplib::Client &http) {
+        return http.Post(path, headers, json_body.dump(), "text/plain");
+      };
+      auto response = send(path, post, idempotency_t::non_idempotent);
+      if (!response) {
+        // The comment may have been created though no response came back, so
+        // it's looked up by our marker before being posted again.
+        spdlog::warn("No response of adding issue comment, look it up before retrying");
+        get_issue_comment_id(ctx);
+        if (comment_id_ != -1) {
+          if (comment_hash_ != parse_comment_marker(body).value_or("")) {
+            update_issue_comment(ctx, body);
+          }
+          return;
+        }
+        response = send(path, post, idempotency_t::non_idempotent);
+      }
       check_http_response(response);
+      spdlog::trace("Get github response body: {}", response->body);
 
       auto comment = nlohmann::json::parse(response->body);
       throw_unless(comment.is_object(), "comment isn't object");
@@ -130,49 +169,103 @@ namespace linter::github {
       throw_if(ctx.pr_number == -1, "the context doesn't have pr-number yet");
       spdlog::info("Start to update issue comment");
 
-      const auto path    = std::format("/repos/{}/issues/comments/{}", ctx.repo_pair, comment_id_);
-      const auto headers = httplib::Headers{
-        {"Accept", "application/vnd.github.use_diff"},
-        {"Authorization", std::format("token {}", ctx.token)}
-      };
+      const auto path     = std::format("/repos/{}/issues/comments/{}", ctx.repo_pair, comment_id_);
+      const auto &headers = session_.diff_headers();
       spdlog::info("Http request path: {}", path);
 
       auto json_body    = nlohmann::json{};
       json_body["body"] = body;
       spdlog::trace("Http request body:\n{}", json_body.dump());
 
-      auto response = client.Post(path, headers, json_body.dump(), "text/plain");
-      spdlog::trace("Get github response body: {}", response->body);
+      auto response = send(path, [&](httplib::Client &http) {
+        return http.Patch(path, headers, json_body.dump(), "text/plain");
+      });
       check_http_response(response);
+      spdlog::trace("Get github response body: {}", response->body);
       spdlog::info("Successfully updated comment {} of pr {}", comment_id_, ctx.pr_number);
     }
 
+    /// The hash of body is embedded into the comment as a hidden marker. The
+    /// update is skipped if our comment already has the same hash, so re-runs
+    /// on the same commit neither cost quota nor notify anyone.
     void add_or_update_issue_comment(const runtime_context &ctx, const std::string &body) {
+      auto hash = hash_comment_body(body);
       if (comment_id_ == -1) {
-        add_issue_comment(ctx, body);
+        add_issue_comment(ctx, body + make_comment_marker(hash));
+      } else if (comment_hash_ == hash) {
+        spdlog::info("Comment {} of pr {} is unchanged, skip updating it",
+                     comment_id_,
+                     ctx.pr_number);
       } else {
-        update_issue_comment(ctx, body);
+        update_issue_comment(ctx, body + make_comment_marker(hash));
       }
     }
 
     void post_pull_request_review(const runtime_context &ctx, const std::string &body) {
       spdlog::info("Start to post pull request review for pr number {}", ctx.pr_number);
 
-      const auto path    = std::format("/repos/{}/pulls/{}/reviews", ctx.repo_pair, ctx.pr_number);
-      const auto headers = httplib::Headers{
-        {"Accept", "application/vnd.github.use_diff"},
-        {"Authorization", std::format("token {}", ctx.token)}
-      };
+      const auto path     = std::format("/repos/{}/pulls/{}/reviews", ctx.repo_pair, ctx.pr_number);
+      const auto &headers = session_.diff_headers();
       spdlog::info("Http request path: {}", path);
       spdlog::trace("Http request body:\n{}", body);
 
-      auto response = client.Post(path, headers, body, "text/plain");
-      spdlog::trace("Get github response body: {}", response->body);
+      // A review isn't marked to be found again, so it's never resent.
+      auto response = send(
+        path,
+        [&](httplib::Client &http) { return http.Post(path, headers, body, "text/plain"); },
+        idempotency_t::non_idempotent);
       check_http_response(response);
+      spdlog::trace("Get github response body: {}", response->body);
 
       spdlog::info("Successfully post pull_request_review for pull-request {}", ctx.pr_number);
     }
 
+    /// Create a check run and return its id.
+    /// https://docs.github.com/en/rest/checks/runs#create-a-check-run
+    auto create_check_run(const runtime_context &ctx, const nlohmann::json &body) -> std::int64_t {
+      spdlog::info("Start to create check run on {}", ctx.repo_pair);
+
+      const auto path     = std::format("/repos/{}/check-runs", ctx.repo_pair);
+      const auto &headers = session_.json_headers();
+      spdlog::info("Http request path: {}", path);
+      spdlog::trace("Http request body:\n{}", body.dump());
+
+      auto response = send(
+        path,
+        [&](httplib::Client &http) {
+          return http.Post(path, headers, body.dump(), "application/json");
+        },
+        idempotency_t::non_idempotent);
+      check_http_response(response);
+      spdlog::trace("Get github response body: {}", response->body);
+
+      auto check_run = nlohmann::json::parse(response->body);
+      throw_unless(check_run.is_object() && check_run.contains("id"), "check run has no id");
+      auto id = check_run["id"].get<std::int64_t>();
+      spdlog::info("Successfully created check run {}", id);
+      return id;
+    }
+
+    /// Update a check run. Annotations in the output are appended to the ones
+    /// given before, at most 50 of them each time.
+    /// https://docs.github.com/en/rest/checks/runs#update-a-check-run
+    void update_check_run(const runtime_context &ctx, std::int64_t id, const nlohmann::json &body) {
+      const auto path     = std::format("/repos/{}/check-runs/{}", ctx.repo_pair, id);
+      const auto &headers = session_.json_headers();
+      spdlog::info("Http request path: {}", path);
+      spdlog::trace("Http request body:\n{}", body.dump());
+
+      // Annotations are appended, so the update isn't resent either.
+      auto response = send(
+        path,
+        [&](httplib::Client &http) {
+          return http.Patch(path, headers, body.dump(), "application/json");
+        },
+        idempotency_t::non_idempotent);
+      check_http_response(response);
+      spdlog::trace("Get github response body: {}", response->body);
+    }
+
     // TODO: support multiple pages.
     // void remove_old_pr_reviews() {
     //   spdlog::info("Start to remove old pr reviews");
@@ -214,7 +307,76 @@ namespace linter::github {
     // }
 
   private:
+    /// Extract the ETag, the path of next page and the id of our comment from
+    /// a page of issue comments. The comment_id is -1 if not found.
+    static auto make_comments_page(const httplib::Response &response) -> nlohmann::json {
+      auto comments = nlohmann::json::parse(response.body);
+      if (comments.is_null()) {
+        comments = nlohmann::json::array();
+      }
+      throw_unless(comments.is_array(), "issue comments are not an array");
+
+      auto page          = nlohmann::json::object();
+      page["etag"]       = response.get_header_value("ETag");
+      page["next"]       = parse_next_link(response.get_header_value("Link")).value_or("");
+      page["comment_id"] = -1;
+      auto comment       = std::ranges::find_if(comments, is_our_comment);
+      if (comment != comments.end()) {
+        page["comment_id"] = (*comment)["id"];
+        if (comment->contains("body") && (*comment)["body"].is_string()) {
+          auto hash = parse_comment_marker((*comment)["body"].get_ref<const std::string &>());
+          page["hash"] = hash.value_or("");
+        }
+      }
+      if (page["etag"].get_ref<const std::string &>().empty()) {
+        page.erase("etag");
+      }
+      return page;
+    }
+
+    /// Send a request and retry it if rejected by the Github rate limit, which
+    /// means it isn't applied. Each request is delayed when the remaining quota
+    /// becomes low. Idempotent requests without response are retried by the
+    /// session. Throw if the rate limit asks to wait longer than
+    /// max_rate_limit_wait.
+    template <class Request>
+    auto send(const std::string &path,
+              Request &&request,
+              idempotency_t idempotency = idempotency_t::idempotent) -> httplib::Result {
+      auto scope = trace::scope{"http", path};
+      for (auto attempt = std::size_t{0};; ++attempt) {
+        if (auto delay = throttle_delay(limits_); delay.count() != 0) {
+          spdlog::info("Only {} Github requests remain, wait {}s",
+                       limits_.remaining,
+                       delay.count());
+          std::this_thread::sleep_for(delay);
+        }
+
+        auto response = session_.send(request, idempotency);
+        if (!response) {
+          return response;
+        }
+        limits_ = parse_rate_limit_headers(response->headers);
+        if (!is_rate_limited(*response, limits_) || attempt == max_retries) {
+          return response;
+        }
+        auto delay = retry_delay(limits_, attempt);
+        throw_if(delay > max_rate_limit_wait,
+                 std::format("Github rate limit exceeded for {}, it resets in {}s which is longer "
+                             "than the maximum wait of {}s",
+                             path,
+                             delay.count(),
+                             max_rate_limit_wait.count()));
+        spdlog::warn("Github rate limit exceeded, retry after {}s", delay.count());
+        std::this_thread::sleep_for(delay);
+      }
+    }
+
+    static constexpr auto max_retries = std::size_t{5};
+
     std::uint32_t comment_id_ = -1;
-    httplib::Client client{github_api};
+    std::string comment_hash_;
+    rate_limit_headers limits_;
+    session &session_;
   };
 } // namespace linter::github
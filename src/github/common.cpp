@@ -16,6 +16,12 @@
 #include "common.h"
 
 #include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string_view>
 
 #include "utils/env_manager.h"
 #include "utils/util.h"
@@ -29,8 +35,129 @@ namespace linter::github {
       throw_if(parts.size() != 4, std::format("ref_name format error: {}", ref_name));
       return std::stoi(parts[2]);
     }
+
+    auto parse_header(const httplib::Headers &headers, const std::string &key)
+      -> std::optional<std::size_t> {
+      auto iter = headers.find(key);
+      if (iter == headers.end()) {
+        return std::nullopt;
+      }
+      const auto &value = iter->second;
+      auto number       = std::size_t{0};
+      auto [ptr, ec]    = std::from_chars(value.data(), value.data() + value.size(), number);
+      if (ec != std::errc{}) {
+        return std::nullopt;
+      }
+      return number;
+    }
+
+    auto seconds_until(std::size_t epoch_seconds) -> std::chrono::seconds {
+      auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count();
+      auto reset = static_cast<std::int64_t>(epoch_seconds);
+      return std::chrono::seconds{std::max<std::int64_t>(reset - now, 0)};
+    }
+
+    constexpr auto comment_marker_prefix = std::string_view{"\n<!-- cpp-linter-hash: "};
+    constexpr auto comment_marker_suffix = std::string_view{" -->"};
+
+    // Start to spread requests once fewer than this number of requests remain.
+    constexpr auto throttle_watermark = std::size_t{10};
+    constexpr auto max_retry_delay    = std::chrono::seconds{60};
+    // Requests are only spread over this, the quota isn't used up before it.
+    constexpr auto max_throttle_delay = std::chrono::seconds{60};
   } // namespace
 
+  auto parse_next_link(std::string_view link) -> std::optional<std::string> {
+    // Links are separated by commas, each one is like <url>; rel="next".
+    for (auto part: std::views::split(link, ',')) {
+      auto item  = std::string_view{part.begin(), part.end()};
+      auto open  = item.find('<');
+      auto close = item.find('>', open);
+      if (open == std::string_view::npos || close == std::string_view::npos) {
+        continue;
+      }
+      if (item.find(R"(rel="next")", close) == std::string_view::npos) {
+        continue;
+      }
+      auto url = item.substr(open + 1, close - open - 1);
+      if (url.starts_with(github_api)) {
+        url.remove_prefix(std::string_view{github_api}.size());
+      }
+      return std::string{url};
+    }
+    return std::nullopt;
+  }
+
+  auto hash_comment_body(std::string_view body) -> std::string {
+    // FNV-1a
+    auto hash = std::uint64_t{14695981039346656037ULL};
+    for (auto c: body) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ULL;
+    }
+    return std::format("{:016x}", hash);
+  }
+
+  auto make_comment_marker(std::string_view hash) -> std::string {
+    return std::format("{}{}{}", comment_marker_prefix, hash, comment_marker_suffix);
+  }
+
+  auto parse_comment_marker(std::string_view body) -> std::optional<std::string> {
+    auto begin = body.rfind(comment_marker_prefix);
+    if (begin == std::string_view::npos) {
+      return std::nullopt;
+    }
+    begin    += comment_marker_prefix.size();
+    auto end  = body.find(comment_marker_suffix, begin);
+    if (end == std::string_view::npos) {
+      return std::nullopt;
+    }
+    return std::string{body.substr(begin, end - begin)};
+  }
+
+  auto parse_rate_limit_headers(const httplib::Headers &headers) -> rate_limit_headers {
+    auto limits = rate_limit_headers{};
+    if (auto reset = parse_header(headers, "X-RateLimit-Reset")) {
+      limits.reset = *reset;
+    }
+    if (auto remaining = parse_header(headers, "X-RateLimit-Remaining")) {
+      limits.remaining = *remaining;
+    }
+    if (auto retry = parse_header(headers, "Retry-After")) {
+      limits.retry = *retry;
+    }
+    return limits;
+  }
+
+  auto is_rate_limited(const httplib::Response &response,
+                       const rate_limit_headers &limits) -> bool {
+    if (response.status == 429) {
+      return true;
+    }
+    return response.status == 403 && (limits.remaining == 0 || limits.retry != 0);
+  }
+
+  auto retry_delay(const rate_limit_headers &limits, std::size_t attempt) -> std::chrono::seconds {
+    if (limits.retry != 0) {
+      return std::chrono::seconds{limits.retry};
+    }
+    if (limits.remaining == 0 && limits.reset != 0) {
+      return seconds_until(limits.reset) + std::chrono::seconds{1};
+    }
+    auto delay = std::chrono::seconds{std::int64_t{1} << std::min<std::size_t>(attempt, 6)};
+    return std::min(delay, max_retry_delay);
+  }
+
+  auto throttle_delay(const rate_limit_headers &limits) -> std::chrono::seconds {
+    if (limits.remaining >= throttle_watermark || limits.reset == 0) {
+      return std::chrono::seconds{0};
+    }
+    auto delay = seconds_until(limits.reset) / static_cast<std::int64_t>(limits.remaining + 1);
+    return std::min(delay, max_throttle_delay);
+  }
+
   auto read_env() -> github_env {
     spdlog::trace("read_github_env");
     auto env            = github_env{};
@@ -15,9 +15,14 @@
  */
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <cstdlib>
+#include <limits>
+#include <optional>
 #include <print>
+#include <string>
+#include <string_view>
 
 #include <httplib.h>
 #include <nlohmann/json.hpp>
@@ -27,12 +32,50 @@
 #include "utils/env_manager.h"
 
 namespace linter::github {
+  /// The rate limit headers of a Github response. The remaining is the max
+  /// value of std::size_t if Github doesn't tell it.
   struct rate_limit_headers {
     std::size_t reset     = 0;
-    std::size_t remaining = 0;
+    std::size_t remaining = std::numeric_limits<std::size_t>::max();
     std::size_t retry     = 0;
   };
 
+  /// Parse the path of next page from a Link header, such as
+  /// <https://api.github.com/repositories/1/issues/1/comments?page=2>; rel="next".
+  /// Return std::nullopt if this is the last page.
+  auto parse_next_link(std::string_view link) -> std::optional<std::string>;
+
+  /// Return a hash of comment body which is stable across runs.
+  auto hash_comment_body(std::string_view body) -> std::string;
+
+  /// Make a hidden marker which carries the hash of comment body.
+  auto make_comment_marker(std::string_view hash) -> std::string;
+
+  /// Parse the hash from the marker of comment body.
+  auto parse_comment_marker(std::string_view body) -> std::optional<std::string>;
+
+  /// Parse X-RateLimit-Reset, X-RateLimit-Remaining and Retry-After headers.
+  auto parse_rate_limit_headers(const httplib::Headers &headers) -> rate_limit_headers;
+
+  /// Whether the request is rejected by the primary or secondary rate limit.
+  auto is_rate_limited(const httplib::Response &response,
+                       const rate_limit_headers &limits) -> bool;
+
+  /// The longest delay to wait for a rate limited request. The request fails
+  /// if Github asks for a longer one, e.g. the primary limit resets in an hour.
+  constexpr auto max_rate_limit_wait = std::chrono::seconds{300};
+
+  /// The delay before retrying a rate limited request. Use Retry-After or the
+  /// time until reset if given, otherwise grow exponentially with attempts.
+  /// The delay isn't capped by max_rate_limit_wait.
+  auto retry_delay(const rate_limit_headers &limits, std::size_t attempt) -> std::chrono::seconds;
+
+  /// The delay before sending next request. Requests are spread over the time
+  /// until reset when only a few remain, so that we don't run out of quota
+  /// shared with other workflows using the same token. The delay is at most a
+  /// minute, since the remaining requests could still be sent.
+  auto throttle_delay(const rate_limit_headers &limits) -> std::chrono::seconds;
+
   constexpr auto our_name                         = "emmett2020"; // For test
   constexpr auto github_api                       = "https://api.github.com";
   constexpr auto github_event_push                = "push";
@@ -16,6 +16,23 @@
 #include "review_comment.h"
 
 namespace linter::github {
+  void to_json(nlohmann::json &json, const review_comment &comment) {
+    json = {
+      {"path", comment.path},
+      {"body", comment.body}
+    };
+    if (comment.line == 0) {
+      json["position"] = comment.position;
+      return;
+    }
+    json["line"] = comment.line;
+    json["side"] = comment.side;
+    if (comment.start_line != 0 && comment.start_line != comment.line) {
+      json["start_line"] = comment.start_line;
+      json["start_side"] = comment.start_side;
+    }
+  }
+
   auto make_review_str(const review_comments &comments) -> std::string {
     auto res        = nlohmann::json{};
     res["body"]     = "cpp-linter suggestion";
@@ -24,4 +41,26 @@ namespace linter::github {
     return res.dump();
   }
 
+  auto make_review_strs(const review_comments &comments,
+                        std::size_t max_comments,
+                        std::size_t max_bytes) -> std::vector<std::string> {
+    auto reviews = std::vector<std::string>{};
+    auto batch   = review_comments{};
+    auto bytes   = std::size_t{0};
+    for (const auto &comment: comments) {
+      auto size = nlohmann::json(comment).dump().size();
+      if (!batch.empty() && (batch.size() == max_comments || bytes + size > max_bytes)) {
+        reviews.push_back(make_review_str(batch));
+        batch.clear();
+        bytes = 0;
+      }
+      batch.push_back(comment);
+      bytes += size;
+    }
+    if (!batch.empty() || reviews.empty()) {
+      reviews.push_back(make_review_str(batch));
+    }
+    return reviews;
+  }
+
 } // namespace linter::github
@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -24,17 +25,29 @@ namespace linter::github {
   // A class represent Github pull request review comment.
   struct review_comment {
     std::string path;
-    std::size_t position;
+    /// The position in the diff, used unless line is given.
+    std::size_t position = 0;
     std::string body;
-    std::size_t line;
+    /// The last row of the commented lines, 0 to comment on position.
+    std::size_t line = 0;
     std::string side;
-    std::size_t start_line;
+    /// The first row of the commented lines, 0 if only one line is commented.
+    std::size_t start_line = 0;
     std::string start_side;
   };
-  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(review_comment, path, position, body)
 
+  /// Github rejects comments with both position and line, so only the used
+  /// ones are serialized.
+  void to_json(nlohmann::json &json, const review_comment &comment);
 
   using review_comments = std::vector<review_comment>;
 
   auto make_review_str(const review_comments &comments) -> std::string;
+
+  /// Github rejects or times out on very large reviews, so comments are split
+  /// into several reviews bounded by both the number of comments and the size
+  /// of serialized comments. At least one review is returned.
+  auto make_review_strs(const review_comments &comments,
+                        std::size_t max_comments = 50,
+                        std::size_t max_bytes    = 64 * 1024) -> std::vector<std::string>;
 } // namespace linter::github
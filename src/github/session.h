@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <httplib.h>
+#include <spdlog/spdlog.h>
+
+#include "common.h"
+#include "context.h"
+
+namespace linter::github {
+  /// Whether sending a request again can't apply it twice. A request without
+  /// response may still have been applied, e.g. a comment created before the
+  /// connection was reset, so only idempotent ones are resent blindly.
+  enum class idempotency_t : std::uint8_t {
+    idempotent,
+    non_idempotent,
+  };
+
+  /// The connections to the Github API shared by all clients of one run, so
+  /// the TLS handshake is done once however many requests are sent. The
+  /// common headers are also made once.
+  class session {
+  public:
+    explicit session(const runtime_context &ctx)
+      : timeout_(ctx.github_timeout)
+      , max_retries_(ctx.github_max_retries)
+      , compression_(ctx.github_compression) {
+      auto authorization = std::format("token {}", ctx.token);
+      json_headers_      = httplib::Headers{
+        {"Accept", "application/vnd.github+json"},
+        {"Authorization", authorization}
+      };
+      diff_headers_ = httplib::Headers{
+        {"Accept", "application/vnd.github.use_diff"},
+        {"Authorization", authorization}
+      };
+    }
+
+    session(const session &)                     = delete;
+    auto operator=(const session &) -> session & = delete;
+
+    /// The session of this run, made by the first call.
+    static auto shared(const runtime_context &ctx) -> session & {
+      static auto instance = session{ctx};
+      return instance;
+    }
+
+    [[nodiscard]] auto json_headers() const -> const httplib::Headers & {
+      return json_headers_;
+    }
+
+    [[nodiscard]] auto diff_headers() const -> const httplib::Headers & {
+      return diff_headers_;
+    }
+
+    /// Send a request by an idle connection and retry it if no response is
+    /// received, e.g. the connection is reset or timed out. The delay doubles
+    /// on each retry. Non-idempotent requests are sent only once, the caller
+    /// decides whether to send them again.
+    template <class Request>
+    auto send(Request &&request, idempotency_t idempotency) -> httplib::Result {
+      auto client  = acquire();
+      auto delay   = std::chrono::seconds{1};
+      auto retries = idempotency == idempotency_t::idempotent ? max_retries_ : 0;
+      for (auto attempt = std::size_t{0};; ++attempt) {
+        auto response = request(*client);
+        if (response || attempt == retries) {
+          release(std::move(client));
+          return response;
+        }
+        spdlog::warn("Github request failed since {}, retry after {}s",
+                     httplib::to_string(response.error()),
+                     delay.count());
+        std::this_thread::sleep_for(delay);
+        delay *= 2;
+      }
+    }
+
+  private:
+    // A connection serves one request at a time, so reports written
+    // concurrently each take their own and put it back for reuse.
+    auto acquire() -> std::unique_ptr<httplib::Client> {
+      auto lock = std::lock_guard{mutex_};
+      if (!idle_.empty()) {
+        auto client = std::move(idle_.back());
+        idle_.pop_back();
+        return client;
+      }
+      auto client = std::make_unique<httplib::Client>(github_api);
+      client->set_keep_alive(true);
+      client->set_connection_timeout(timeout_);
+      client->set_read_timeout(timeout_);
+      client->set_write_timeout(timeout_);
+      // Accept gzip responses, which matters for large comment lists.
+      client->set_decompress(compression_);
+      return client;
+    }
+
+    void release(std::unique_ptr<httplib::Client> client) {
+      auto lock = std::lock_guard{mutex_};
+      idle_.push_back(std::move(client));
+    }
+
+    std::chrono::seconds timeout_;
+    std::size_t max_retries_;
+    bool compression_;
+    httplib::Headers json_headers_;
+    httplib::Headers diff_headers_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<httplib::Client>> idle_;
+  };
+} // namespace linter::github
@@ -14,9 +14,13 @@
  * limitations under the License.
  */
 #include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <future>
 #include <git2/oid.h>
 #include <memory>
 #include <print>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -25,6 +29,7 @@
 
 #include "configs/version.h"
 #include "context.h"
+#include "github/check_run.h"
 #include "github/common.h"
 #include "program_options.h"
 #include "tools/base_creator.h"
@@ -32,8 +37,15 @@
 #include "tools/base_tool.h"
 #include "tools/clang_format/clang_format.h"
 #include "tools/clang_tidy/clang_tidy.h"
+#include "tools/result_stream.h"
+#include "tools/shard_result.h"
 #include "utils/env_manager.h"
+#include "utils/file_watcher.h"
 #include "utils/git_utils.h"
+#include "utils/log.h"
+#include "utils/shell.h"
+#include "utils/string_pool.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 using namespace linter; // NOLINT
@@ -59,7 +71,7 @@ namespace {
   }
 
   auto print_changed_files(const std::vector<std::string> &files) {
-    spdlog::info("Got {} changed files. File list:\n{}", files.size(), concat(files));
+    LINTER_INFO("Got {} changed files. File list:\n{}", files.size(), concat(files));
   }
 
   void print_version() {
@@ -69,6 +81,67 @@ namespace {
                cpp_linter_VERSION_PATCH);
   }
 
+  // Diff the saved files in the working tree against target revision, so the
+  // changes reported on are those of the saved contents.
+  auto diff_saved_files(const runtime_context &context, std::vector<std::string> &files)
+    -> git::patch_set {
+    auto paths = std::vector<char *>{};
+    for (auto &file: files) {
+      paths.push_back(file.data());
+    }
+    auto opts      = git::diff::init_option();
+    opts.flags    |= GIT_DIFF_DISABLE_PATHSPEC_MATCH;
+    opts.pathspec  = {.strings = paths.data(), .count = paths.size()};
+    auto tree      = git::commit::tree(context.target_commit.get());
+    return git::patch_set{git::diff::tree_to_workdir(context.repo.get(), tree.get(), &opts)};
+  }
+
+  // Check the files saved in the working tree again and again until killed.
+  // The repository, the resolved tool binaries and the process runner are
+  // kept warm, so only the saved files are paid for each time.
+  [[noreturn]] void watch(const std::vector<tool::creator_base_ptr> &creators,
+                          runtime_context &context) {
+    auto watcher = file_watcher{context.repo_path, {".git"}};
+    std::println("Watching {} for saved files", context.repo_path);
+    while (true) {
+      auto files = watcher.wait(std::chrono::milliseconds{100});
+      std::erase_if(files, [&](const std::string &file) {
+        return !std::filesystem::is_regular_file(std::filesystem::path{context.repo_path} / file);
+      });
+      if (files.empty()) {
+        continue;
+      }
+
+      // The results of the former check are never used again, so the strings
+      // they refer to are dropped rather than growing the pool on each check.
+      string_pool::instance().clear();
+      auto start = std::chrono::steady_clock::now();
+      if (context.timeout != 0) {
+        shell::runner::instance().set_deadline(start + std::chrono::seconds{context.timeout});
+      }
+      try {
+        context.patches       = diff_saved_files(context, files);
+        context.changed_files = context.patches.files();
+
+        auto tools     = tool::create_enabled_tools(creators, context);
+        auto reporters = tool::check_then_get_reporters(tools, context);
+        for (const auto &reporter: reporters) {
+          auto [passed, num_passed, num_failed, num_ignored] = reporter->get_brief_result();
+          std::println("{}: {} passed, {} failed", reporter->tool_name(), num_passed, num_failed);
+          if (!passed) {
+            std::print("{}", reporter->make_issue_comment(context));
+          }
+        }
+      } catch (const std::exception &err) {
+        // A file may be saved again while it's being checked.
+        std::println("Failed to check saved files: {}", err.what());
+      }
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+      std::println("Checked {} files in {}", context.changed_files.size(), elapsed);
+    }
+  }
+
   auto collect_tool_creators() -> std::vector<tool::creator_base_ptr> {
     auto ret = std::vector<tool::creator_base_ptr>{};
     ret.push_back(std::make_unique<tool::clang_format::creator>());
@@ -98,6 +171,9 @@ auto main(int argc, char **argv) -> int {
   auto context = runtime_context{};
   fill_context_by_program_options(user_options, context);
   set_log_level(context.log_level);
+  if (!context.trace_file.empty()) {
+    trace::enable();
+  }
 
   // Fill runtime context by environment variables.
   if (!context.use_on_local) {
@@ -106,31 +182,105 @@ auto main(int argc, char **argv) -> int {
     github::fill_context_by_env(env, context);
   }
 
-  // Fill runtime context by git repositofy informations.
-  git::setup();
-  context.repo          = git::repo::open(context.repo_path);
-  context.target_commit = git::revparse::commit(*context.repo, context.target);
-  context.source_commit = git::revparse::commit(*context.repo, context.source);
-  auto diff       = git::diff::get(*context.repo, *context.target_commit, *context.source_commit);
-  context.patches = git::patch::create_from_diff(*diff);
-  context.changed_files = git::patch::changed_files(context.patches);
-  print_context(context);
+  if (context.timeout != 0) {
+    shell::runner::instance().set_deadline(std::chrono::steady_clock::now()
+                                           + std::chrono::seconds{context.timeout});
+  }
 
+  // Tools don't depend on the diff, so they're created first and warmed up,
+  // e.g. their binaries are resolved, while the diff is computed. Then the
+  // first tool process starts as soon as the changed files are known.
   tool::create_tool_options(tool_creators, user_options);
-  auto tools     = tool::create_enabled_tools(tool_creators, context);
-  auto reporters = tool::check_then_get_reporters(tools, context);
+  auto tools   = tool::create_enabled_tools(tool_creators, context);
+  auto warm_up = std::future<void>{};
+  if (context.merged_shard_results.empty()) {
+    warm_up = std::async(std::launch::async, [&] {
+      auto scope = trace::scope{"check", "warm up"};
+      tool::warm_up_tools(tools, context);
+    });
+  }
 
-  if (context.enable_action_output) {
-    write_to_github_action_output(context, reporters);
+  // Fill runtime context by git repositofy informations. The results to be
+  // merged carry what reporters need, so the repository isn't opened then.
+  git::setup(context.git_tuning);
+  if (context.merged_shard_results.empty()) {
+    auto scope            = trace::scope{"git", "diff"};
+    context.repo          = git::repo::open(context.repo_path);
+    context.target_commit = git::revparse::commit(*context.repo, context.target);
+    if (context.staged) {
+      // The staged commit is only needed by this run, so it isn't written to
+      // the object database of the user.
+      git::repo::use_memory_odb(context.repo.get());
+      context.source_commit = git::commit::create_staged(context.repo.get());
+    } else {
+      context.source_commit = git::revparse::commit(*context.repo, context.source);
+    }
+    context.repos = std::make_unique<git::repo_pool>(
+      context.repo_path,
+      *git::commit::id(context.target_commit.get()),
+      *git::commit::id(context.source_commit.get()),
+      context.staged);
+    auto diff = git::diff::get(*context.repo, *context.target_commit, *context.source_commit);
+
+    // Detect renames, so files moved without content changes could be dropped
+    // together with deleted and binary files before any tool runs. Copies
+    // aren't detected, which would leave only the lines changed from their
+    // sources in the patches.
+    auto find_opts = git::diff::init_find_option(GIT_DIFF_FIND_RENAMES);
+    git::diff::find_similar(diff.get(), find_opts);
+    // Deltas are filtered by several threads, so each looks up blobs by its
+    // own repository leased from the pool rather than the shared one.
+    context.patches = git::patch_set{std::move(diff), [&](const git::diff_delta &delta) {
+                                       auto handle = context.repos->acquire();
+                                       return git::needs_check(handle->repo.get(), delta);
+                                     }};
+    context.changed_files = context.patches.files();
+
+    // Created before checking, so annotations are uploaded as files fail.
+    if (context.enable_check_run) {
+      context.annotations = std::make_shared<github::check_run>(
+        context, git::commit::id_str(context.source_commit.get()));
+    }
   }
-  if (context.enable_step_summary) {
-    write_to_github_step_summary(context, reporters);
+  if (warm_up.valid()) {
+    warm_up.get();
   }
-  if (context.enable_comment_on_issue) {
-    comment_on_github_issue(context, reporters);
+
+  auto reporters = std::vector<tool::reporter_base_ptr>{};
+  if (context.merged_shard_results.empty()) {
+    print_context(context);
+    if (!context.result_file.empty()) {
+      context.results = std::make_shared<tool::result_stream>(context.result_file,
+                                                              context.result_file_format);
+    }
+    auto scope = trace::scope{"check", "all tools"};
+    reporters  = tool::check_then_get_reporters(tools, context);
+    if (context.results != nullptr) {
+      context.results->close();
+    }
+  } else {
+    auto scope = trace::scope{"check", "merge shard results"};
+    tool::merge_shard_results(context, tools, context.merged_shard_results);
+    print_context(context);
+    reporters = tool::get_reporters(tools);
+  }
+  // libgit2 doesn't count cache hits, so how full its cache is shows whether
+  // it's large enough.
+  if (trace::enabled()) {
+    auto usage = git::cached_memory();
+    trace::set_counter("git_cached_bytes", usage.current);
+    trace::set_counter("git_cache_max_bytes", usage.allowed);
+  }
+  if (!context.shard_result_file.empty()) {
+    tool::write_shard_result(context, tools, reporters, context.shard_result_file);
+  }
+
+  write_reports(context, reporters);
+  if (!context.trace_file.empty()) {
+    trace::write_chrome_trace(context.trace_file);
   }
-  if (context.enable_pull_request_review) {
-    comment_on_github_pull_request_review(context, reporters);
+  if (context.watch) {
+    watch(tool_creators, context);
   }
 
   git::shutdown();
@@ -24,6 +24,7 @@
 
 #include "github/common.h"
 #include "github/github.h"
+#include "tools/result_stream.h"
 #include "utils/util.h"
 
 namespace linter {
@@ -43,7 +44,33 @@ namespace linter {
     constexpr auto enable_step_summary        = "enable-step-summary";
     constexpr auto enable_comment_on_issue    = "enable-comment-on-issue";
     constexpr auto enable_pull_request_review = "enable-pull-request-review";
+    constexpr auto enable_check_run           = "enable-check-run";
     constexpr auto enable_action_output       = "enable-action-output";
+    constexpr auto github_timeout             = "github-timeout";
+    constexpr auto github_max_retries         = "github-max-retries";
+    constexpr auto github_compression         = "github-compression";
+    constexpr auto cache_dir                  = "cache-dir";
+    constexpr auto trace_file                 = "trace-file";
+    constexpr auto result_file                = "result-file";
+    constexpr auto result_file_format         = "result-file-format";
+    constexpr auto shard_index                = "shard-index";
+    constexpr auto shard_count                = "shard-count";
+    constexpr auto shard_result_file          = "shard-result-file";
+    constexpr auto max_memory                 = "max-memory";
+    constexpr auto timeout                    = "timeout";
+    constexpr auto allow_timed_out            = "allow-timed-out";
+    constexpr auto fail_fast                  = "fail-fast";
+    constexpr auto git_cache_max_size         = "git-cache-max-size";
+    constexpr auto git_blob_cache_limit       = "git-blob-cache-limit";
+    constexpr auto git_tree_cache_limit       = "git-tree-cache-limit";
+    constexpr auto git_commit_cache_limit     = "git-commit-cache-limit";
+    constexpr auto git_mwindow_size           = "git-mwindow-size";
+    constexpr auto git_mwindow_mapped_limit   = "git-mwindow-mapped-limit";
+    constexpr auto git_mwindow_file_limit     = "git-mwindow-file-limit";
+    constexpr auto git_strict_hash            = "git-strict-hash-verification";
+    constexpr auto watch                      = "watch";
+    constexpr auto staged                     = "staged";
+    constexpr auto merge_shard_results        = "merge-shard-results";
 
     // Theses options work both on local and CI.
     void check_and_fill_context_common(const program_options::variables_map &variables,
@@ -56,16 +83,107 @@ namespace linter {
                      std::format("unsupported log level: {}", level));
       }
 
-      auto must_specify_option = {target};
-      must_specify("use cpp-linter on local or CI", variables, must_specify_option);
+      // The revisions are unused if results are merged rather than checked.
+      // Staged changes are checked against HEAD by default.
+      if (!variables.contains(merge_shard_results) && !variables.contains(staged)) {
+        auto must_specify_option = {target};
+        must_specify("use cpp-linter on local or CI", variables, must_specify_option);
+      }
+      if (variables.contains(target)) {
+        ctx.target = variables[target].as<std::string>();
+      }
 
-      ctx.target = variables[target].as<std::string>();
+      if (variables.contains(github_timeout)) {
+        ctx.github_timeout = variables[github_timeout].as<std::uint32_t>();
+        throw_if(ctx.github_timeout == 0, "github-timeout must be greater than 0");
+      }
+      if (variables.contains(github_max_retries)) {
+        ctx.github_max_retries = variables[github_max_retries].as<std::uint32_t>();
+      }
+      if (variables.contains(github_compression)) {
+        ctx.github_compression = variables[github_compression].as<bool>();
+      }
+      if (variables.contains(cache_dir)) {
+        ctx.cache_dir = variables[cache_dir].as<std::string>();
+      }
+      if (variables.contains(trace_file)) {
+        ctx.trace_file = variables[trace_file].as<std::string>();
+      }
+      if (variables.contains(result_file)) {
+        ctx.result_file = variables[result_file].as<std::string>();
+      }
+      if (variables.contains(result_file_format)) {
+        must_specify("specify result file format", variables, {result_file});
+        ctx.result_file_format = tool::parse_result_format(
+          boost::algorithm::to_lower_copy(variables[result_file_format].as<std::string>()));
+      }
+
+      if (variables.contains(shard_count)) {
+        ctx.shard_count = variables[shard_count].as<std::uint32_t>();
+        throw_if(ctx.shard_count == 0, "shard-count must be greater than 0");
+      }
+      if (variables.contains(shard_index)) {
+        ctx.shard_index = variables[shard_index].as<std::uint32_t>();
+        throw_unless(ctx.shard_index < ctx.shard_count,
+                     std::format("shard-index must be less than shard-count {}", ctx.shard_count));
+      }
+      if (variables.contains(max_memory)) {
+        ctx.max_memory = variables[max_memory].as<std::uint32_t>();
+      }
+      if (variables.contains(timeout)) {
+        ctx.timeout = variables[timeout].as<std::uint32_t>();
+      }
+      if (variables.contains(allow_timed_out)) {
+        ctx.allow_timed_out = variables[allow_timed_out].as<bool>();
+      }
+      if (variables.contains(fail_fast)) {
+        ctx.fail_fast = variables[fail_fast].as<bool>();
+      }
+      if (variables.contains(shard_result_file)) {
+        ctx.shard_result_file = variables[shard_result_file].as<std::string>();
+      }
+
+      constexpr auto mib = std::size_t{1024} * 1024;
+      auto &tuning       = ctx.git_tuning;
+      if (variables.contains(git_cache_max_size)) {
+        tuning.cache_max_size = variables[git_cache_max_size].as<std::uint32_t>() * mib;
+      }
+      if (variables.contains(git_blob_cache_limit)) {
+        tuning.blob_cache_limit = variables[git_blob_cache_limit].as<std::uint32_t>();
+      }
+      if (variables.contains(git_tree_cache_limit)) {
+        tuning.tree_cache_limit = variables[git_tree_cache_limit].as<std::uint32_t>();
+      }
+      if (variables.contains(git_commit_cache_limit)) {
+        tuning.commit_cache_limit = variables[git_commit_cache_limit].as<std::uint32_t>();
+      }
+      if (variables.contains(git_mwindow_size)) {
+        tuning.mwindow_size = variables[git_mwindow_size].as<std::uint32_t>() * mib;
+        throw_if(tuning.mwindow_size == 0, "git-mwindow-size must be greater than 0");
+      }
+      if (variables.contains(git_mwindow_mapped_limit)) {
+        tuning.mwindow_mapped_limit = variables[git_mwindow_mapped_limit].as<std::uint32_t>() * mib;
+      }
+      if (variables.contains(git_mwindow_file_limit)) {
+        tuning.mwindow_file_limit = variables[git_mwindow_file_limit].as<std::uint32_t>();
+      }
+      if (variables.contains(git_strict_hash)) {
+        tuning.strict_hash_verification = variables[git_strict_hash].as<bool>();
+      }
+      if (variables.contains(merge_shard_results)) {
+        ctx.merged_shard_results = variables[merge_shard_results].as<std::vector<std::string>>();
+        throw_if(ctx.shard_count > 1,
+                 "specify both merge-shard-results and shard-count is ambiguous");
+        // Results are written while files are checked.
+        must_not_specify("merge shard results", variables, {result_file});
+      }
     }
 
     void check_and_fill_context_on_ci(const program_options::variables_map &variables,
                                       runtime_context &ctx) {
       spdlog::trace("Enter check_and_fill_context_on_ci");
-      auto must_not_specify_option = {repo_path, repo, source, event_name, pr_number};
+      auto must_not_specify_option = {
+        repo_path, repo, source, event_name, pr_number, watch, staged};
       must_not_specify("use cpp-linter on CI", variables, must_not_specify_option);
 
       if (variables.contains(enable_step_summary)) {
@@ -80,20 +198,42 @@ namespace linter {
       if (variables.contains(enable_action_output)) {
         ctx.enable_action_output = variables[enable_action_output].as<bool>();
       }
+      if (variables.contains(enable_check_run)) {
+        ctx.enable_check_run = variables[enable_check_run].as<bool>();
+      }
     }
 
     void check_and_fill_context_on_local(const program_options::variables_map &variables,
                                          runtime_context &ctx) {
       spdlog::trace("Enter check_and_fill_context_on_local");
-      auto must_specify_option = {repo_path, source, event_name};
-      must_specify("use cpp-linter on local", variables, must_specify_option);
+      if (variables.contains(staged)) {
+        ctx.staged = variables[staged].as<bool>();
+      }
+      if (ctx.staged) {
+        // Fast enough for a pre-commit hook, which has no Github event.
+        must_specify("check staged changes", variables, {repo_path});
+        auto must_not_specify_option = {source, merge_shard_results, watch};
+        must_not_specify("check staged changes", variables, must_not_specify_option);
+        ctx.repo_path  = variables[repo_path].as<std::string>();
+        ctx.event_name = variables.contains(event_name) ? variables[event_name].as<std::string>()
+                                                        : std::string{github::github_event_push};
+        if (!variables.contains(target)) {
+          ctx.target = "HEAD";
+        }
+      } else if (variables.contains(merge_shard_results)) {
+        must_specify("merge shard results on local", variables, {event_name});
+        ctx.event_name = variables[event_name].as<std::string>();
+      } else {
+        auto must_specify_option = {repo_path, source, event_name};
+        must_specify("use cpp-linter on local", variables, must_specify_option);
+        ctx.repo_path  = variables[repo_path].as<std::string>();
+        ctx.source     = variables[source].as<std::string>();
+        ctx.event_name = variables[event_name].as<std::string>();
+      }
 
-      auto must_not_specify_option = {enable_step_summary, enable_action_output};
+      auto must_not_specify_option = {enable_step_summary, enable_action_output, enable_check_run};
       must_not_specify("use cpp-linter on local", variables, must_not_specify_option);
 
-      ctx.repo_path  = variables[repo_path].as<std::string>();
-      ctx.source     = variables[source].as<std::string>();
-      ctx.event_name = variables[event_name].as<std::string>();
       throw_unless(std::ranges::contains(github::all_github_events, ctx.event_name),
                    std::format("unsupported event name: {}", ctx.event_name));
 
@@ -119,6 +259,19 @@ namespace linter {
       if (variables.contains(enable_pull_request_review)) {
         ctx.enable_pull_request_review = variables[enable_pull_request_review].as<bool>();
       }
+
+      if (variables.contains(watch)) {
+        ctx.watch = variables[watch].as<bool>();
+      }
+      if (ctx.watch) {
+        auto forbidden = {merge_shard_results,
+                          shard_count,
+                          shard_result_file,
+                          result_file,
+                          enable_comment_on_issue,
+                          enable_pull_request_review};
+        must_not_specify("watch files on local", variables, forbidden);
+      }
     }
 
   } // namespace
@@ -144,6 +297,78 @@ namespace linter {
       (enable_pull_request_review,  value<bool>(),     "Enable Github pull-request reivew comment")
       (enable_step_summary,         value<bool>(),     "Enable write step summary to Github action")
       (enable_action_output,        value<bool>(),     "Enable write output to Github action")
+      (enable_check_run,            value<bool>(),     "Enable publish diagnostics as annotations of a Github check "
+                                                       "run, which are uploaded while files are being checked. "
+                                                       "Requires the checks write permission")
+      (github_timeout,              value<uint32_t>(), "Set the timeout in seconds of each Github API request. "
+                                                       "Default to 30")
+      (github_max_retries,          value<uint32_t>(), "Set the number of retries of a Github API request without "
+                                                       "response, e.g. timed out. Default to 3")
+      (github_compression,          value<bool>(),     "Accept compressed Github API responses. Default to true")
+      (cache_dir,                   value<string>(),   "Set the directory to cache the check result of each file. "
+                                                       "Keep it between runs, e.g. by actions/cache, to skip "
+                                                       "checking unchanged files")
+      (trace_file,                  value<string>(),   "Write the time of each phase and each tool invocation to "
+                                                       "the given file as Chrome trace events. A timing summary "
+                                                       "is also added to the step summary")
+      (result_file,                 value<string>(),   "Write the result of each file and its diagnostics to the "
+                                                       "given file as soon as the file is checked, so it could be "
+                                                       "read during long runs")
+      (result_file_format,          value<string>(),   "Set the format of result-file, one of jsonl and sarif. "
+                                                       "JSON Lines has a record per checked file and per diagnostic. "
+                                                       "SARIF has diagnostics only and is completed after the "
+                                                       "check. Default to jsonl")
+      (shard_index,                 value<uint32_t>(), "Set the index of this shard, starting from 0. Requires "
+                                                       "shard-count")
+      (shard_count,                 value<uint32_t>(), "Split the check into the given number of shards, each run "
+                                                       "by one cpp-linter with a different shard-index. Tasks are "
+                                                       "balanced by the durations kept in cache-dir, so restore "
+                                                       "the same cache in all shards. Default to 1")
+      (max_memory,                  value<uint32_t>(), "Set the memory budget in MiB of checks running at the same "
+                                                       "time. A check is started only if its peak memory measured "
+                                                       "in former runs fits, so keep cache-dir between runs. "
+                                                       "Default to 0, unlimited")
+      (timeout,                     value<uint32_t>(), "Set the seconds the whole check may take. Tool processes "
+                                                       "still running then are killed and their files are reported "
+                                                       "as timed out. Default to 0, unlimited")
+      (allow_timed_out,             value<bool>(),     "Pass the check though some files timed out, e.g. killed by "
+                                                       "timeout or a tool timeout. Default to false, they fail it")
+      (fail_fast,                   value<bool>(),     "Stop all tools as soon as any file fails. Tools are run one "
+                                                       "after another from the cheapest, e.g. clang-format before "
+                                                       "clang-tidy, and files not checked by then are skipped. "
+                                                       "Reports are made of the checked files")
+      (git_cache_max_size,          value<uint32_t>(), "Set the maximum MiB of git objects cached in memory. "
+                                                       "Default to 256 of libgit2")
+      (git_blob_cache_limit,        value<uint32_t>(), "Set the maximum bytes of a blob cached in memory. Blobs "
+                                                       "aren't cached by default of libgit2, so files read by "
+                                                       "several tools are read from packfiles each time")
+      (git_tree_cache_limit,        value<uint32_t>(), "Set the maximum bytes of a tree cached in memory. Default "
+                                                       "to 4096 of libgit2")
+      (git_commit_cache_limit,      value<uint32_t>(), "Set the maximum bytes of a commit cached in memory. "
+                                                       "Default to 4096 of libgit2")
+      (git_mwindow_size,            value<uint32_t>(), "Set the MiB of each window mapped on packfiles. Default to "
+                                                       "1024 of libgit2 on 64-bit platforms")
+      (git_mwindow_mapped_limit,    value<uint32_t>(), "Set the maximum MiB mapped on packfiles at the same time. "
+                                                       "Default to 8192 of libgit2 on 64-bit platforms")
+      (git_mwindow_file_limit,      value<uint32_t>(), "Set the maximum number of packfiles opened at the same "
+                                                       "time. Default to 0 of libgit2, unlimited")
+      (git_strict_hash,             value<bool>(),     "Verify the hash of each git object read. Objects are read "
+                                                       "faster without it. Default to true")
+      (staged,                      value<bool>(),     "Check the staged changes against target revision, which "
+                                                       "is HEAD by default, e.g. by a pre-commit hook. Staged "
+                                                       "contents are checked rather than the working tree. "
+                                                       "Only on local")
+      (watch,                       value<bool>(),     "Keep running on local after the check, and check files again "
+                                                       "each time they're saved. Results are printed, and saved "
+                                                       "files are read from the working tree rather than git")
+      (shard_result_file,           value<string>(),   "Write the results of this run to the given file, to be "
+                                                       "merged by merge-shard-results")
+      (merge_shard_results,         value<std::vector<string>>()->multitoken(),
+                                                       "Merge the results written by shard-result-file of all "
+                                                       "shards and report them once rather than checking. Given "
+                                                       "one file, reports of a former run are made again. The "
+                                                       "repository isn't needed. Run with the same tool options "
+                                                       "as shards")
     ;
     // clang-format on
     return desc;
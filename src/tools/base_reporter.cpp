@@ -16,13 +16,26 @@
 
 #include "tools/base_reporter.h"
 
-#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <ranges>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <spdlog/spdlog.h>
 
 #include "context.h"
 #include "github/github.h"
+#include "tools/scheduler.h"
 #include "utils/env_manager.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace linter::tool {
@@ -49,15 +62,44 @@ namespace linter::tool {
   bool all_passed(const std::vector<reporter_base_ptr> &reporters) {
     for (const auto &reporter: reporters) {
       auto [is_passed, successed, failed, ignored] = reporter->get_brief_result();
-      if (is_passed) {
+      if (!is_passed) {
         return false;
       }
     }
     return true;
   }
 
+  bool all_passed(const std::vector<rendered_report> &reports) {
+    return std::ranges::all_of(reports, &rendered_report::passed);
+  }
+
+  auto render_reports(const runtime_context &context,
+                      const std::vector<reporter_base_ptr> &reporters)
+    -> std::vector<rendered_report> {
+    auto scope   = trace::scope{"report", "render"};
+    auto reports = std::vector<rendered_report>{};
+    for (const auto &reporter: reporters) {
+      auto &report = reports.emplace_back();
+      std::tie(report.passed, report.num_passed, report.num_failed, report.num_ignored) =
+        reporter->get_brief_result();
+      report.tool_name = reporter->tool_name();
+      if (context.enable_comment_on_issue && !report.passed) {
+        report.issue_comment = reporter->make_issue_comment(context);
+      }
+      // Reporters are asked even if all passed, since a summary may carry more
+      // than failures, e.g. the clang-tidy check profile.
+      if (context.enable_step_summary) {
+        report.step_summary = reporter->make_step_summary(context);
+      }
+      if (context.enable_pull_request_review) {
+        report.review_comments = reporter->make_review_comment(context);
+      }
+    }
+    return reports;
+  }
+
   void write_to_github_step_summary(const runtime_context &context,
-                                    const std::vector<reporter_base_ptr> &reporters) {
+                                    const std::vector<rendered_report> &reports) {
     auto summary_file = env::get(github::github_step_summary);
     auto file         = std::fstream{summary_file, std::ios::app};
     throw_unless(file.is_open(), "failed to open step summary file to write");
@@ -66,21 +108,18 @@ namespace linter::tool {
     static const auto hint_pass = ":rocket: All checks on all file passed."s;
     static const auto hint_fail = ":warning: Some files didn't pass the cpp-linter checks\n"s;
 
-    if (all_passed(reporters)) {
-      file << (title + hint_pass);
-      return;
-    }
-
+    // The timing summary is only available when tracing is enabled.
+    auto timing  = trace::enabled() ? "\n" + trace::make_summary() : ""s;
     auto summary = std::string{};
-    for (const auto &reporter: reporters) {
-      summary += reporter->make_step_summary(context) + "\n";
+    for (const auto &report: reports) {
+      summary += report.step_summary + "\n";
     }
-    file << (title + hint_fail + summary);
+    file << (title + (all_passed(reports) ? hint_pass : hint_fail) + summary + timing);
   }
 
   void comment_on_github_issue(const runtime_context &context,
-                               const std::vector<reporter_base_ptr> &reporters) {
-    auto github_client = github::client{};
+                               const std::vector<rendered_report> &reports) {
+    auto github_client = github::client{github::session::shared(context)};
     github_client.get_issue_comment_id(context);
 
     constexpr auto website = "";
@@ -94,14 +133,15 @@ namespace linter::tool {
     auto table_rows = ""s;
     auto details = ""s;
 
-    for (const auto &reporter: reporters) {
-      auto [is_passed, successed, failed, ignored] = reporter->get_brief_result();
-      auto tool_name = reporter->tool_name();
-      table_rows += std::format(table_row_fmt, tool_name, successed, failed, ignored);
-      if (!is_passed) {
+    for (const auto &report: reports) {
+      const auto &tool_name = report.tool_name;
+      const auto failed     = report.num_failed;
+      table_rows +=
+        std::format(table_row_fmt, tool_name, report.num_passed, failed, report.num_ignored);
+      if (!report.passed) {
         assert(failed != 0);
         auto summary = std::format(summary_fmt, failed, failed == 1 ? "file" : "files", tool_name);
-        auto tool_detail = reporter->make_issue_comment(context) + "\n";
+        auto tool_detail = report.issue_comment + "\n";
         details += std::format(details_fmt, summary + tool_detail);
       }
     }
@@ -116,14 +156,77 @@ namespace linter::tool {
   }
 
   void comment_on_github_pull_request_review(const runtime_context &context,
-                                             const std::vector<reporter_base_ptr> &reporters) {
-    auto github_client = github::client{};
+                                             const std::vector<rendered_report> &reports) {
+    auto github_client = github::client{github::session::shared(context)};
     auto comments      = github::review_comments{};
-    for (const auto &reporter: reporters) {
-      auto ret = reporter->make_review_comment(context);
-      comments.insert(comments.end(), ret.begin(), ret.end());
+    for (const auto &report: reports) {
+      comments.insert(comments.end(), report.review_comments.begin(), report.review_comments.end());
+    }
+    auto reviews = github::make_review_strs(comments);
+    for (const auto &body: reviews) {
+      github_client.post_pull_request_review(context, body);
+    }
+  }
+
+  void complete_github_check_run(const runtime_context &context,
+                                 const std::vector<rendered_report> &reports) {
+    auto summary  = std::string{"| Tool Name | Successed | Failed | Ignored |\n"};
+    summary      += "|-----------|-----------|--------|---------|\n";
+    for (const auto &report: reports) {
+      summary += std::format("| **{}** | {} | {} | {} |\n",
+                             report.tool_name,
+                             report.num_passed,
+                             report.num_failed,
+                             report.num_ignored);
+    }
+    context.annotations->finish(all_passed(reports), summary);
+  }
+
+  void write_reports(const runtime_context &context,
+                     const std::vector<reporter_base_ptr> &reporters) {
+    const auto reports = render_reports(context, reporters);
+
+    auto mutex  = std::mutex{};
+    auto errors = std::vector<std::string>{};
+    auto write  = [&](const std::string &name, const auto &output) {
+      try {
+        auto scope = trace::scope{"report", name};
+        output();
+      } catch (const std::exception &err) {
+        spdlog::error("Failed to write {} since: {}", name, err.what());
+        auto lock = std::lock_guard{mutex};
+        errors.push_back(std::format("{}: {}", name, err.what()));
+      }
+    };
+
+    auto tasks = std::vector<tool_task>{};
+    auto add   = [&](bool enabled, std::string name, std::function<void()> output) {
+      if (enabled) {
+        tasks.push_back({.cost = 0, .name = name, .run = [&write, name, output = std::move(output)] {
+                           write(name, output);
+                         }});
+      }
+    };
+    add(context.enable_action_output, "action output", [&] {
+      write_to_github_action_output(context, reporters);
+    });
+    add(context.enable_comment_on_issue, "issue comment", [&] {
+      comment_on_github_issue(context, reports);
+    });
+    add(context.enable_pull_request_review, "pull request review", [&] {
+      comment_on_github_pull_request_review(context, reports);
+    });
+    add(context.annotations != nullptr, "check run", [&] {
+      complete_github_check_run(context, reports);
+    });
+    auto num_tasks = tasks.size();
+    run_tasks(std::move(tasks), num_tasks);
+
+    // Written last so the timing summary covers the other reports.
+    if (context.enable_step_summary) {
+      write("step summary", [&] { write_to_github_step_summary(context, reports); });
     }
-    auto body = github::make_review_str(comments);
-    github_client.post_pull_request_review(context, body);
+    auto errors_str = errors | std::views::join_with("; "sv) | std::ranges::to<std::string>();
+    throw_unless(errors.empty(), std::format("failed to write reports: {}", errors_str));
   }
 } // namespace linter::tool
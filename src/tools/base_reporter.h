@@ -15,7 +15,9 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #include "context.h"
 #include "github/review_comment.h"
@@ -39,21 +41,64 @@ namespace linter::tool {
 
     // Used for show in result
     virtual auto tool_name() -> std::string = 0;
+
+    /// The files whose diff hunks are used by review comments. Their hunks are
+    /// saved in result files, so reports could be made without the diff.
+    virtual auto reviewed_files() -> std::vector<std::string> {
+      return {};
+    }
+
+    /// The files whose contents in source revision are used by review comments.
+    /// They're saved in result files as well.
+    virtual auto read_files() -> std::vector<std::string> {
+      return {};
+    }
   };
 
   using reporter_base_ptr = std ::unique_ptr<reporter_base>;
 
+  /// What a reporter renders once and shares by all outputs.
+  struct rendered_report {
+    std::string tool_name;
+    bool passed             = true;
+    std::size_t num_passed  = 0;
+    std::size_t num_failed  = 0;
+    std::size_t num_ignored = 0;
+    std::string issue_comment;
+    std::string step_summary;
+    github::review_comments review_comments;
+  };
+
+  /// Render what's needed by the outputs enabled in context.
+  auto render_reports(const runtime_context &context,
+                      const std::vector<reporter_base_ptr> &reporters)
+    -> std::vector<rendered_report>;
+
   void write_to_github_action_output(const runtime_context &context,
                                      const std::vector<reporter_base_ptr> &reporters);
 
   void write_to_github_step_summary(const runtime_context &context,
-                                    const std::vector<reporter_base_ptr> &reporters);
+                                    const std::vector<rendered_report> &reports);
 
   void comment_on_github_issue(const runtime_context &context,
-                               const std::vector<reporter_base_ptr> &reporters);
+                               const std::vector<rendered_report> &reports);
 
   void comment_on_github_pull_request_review(const runtime_context &context,
-                                             const std::vector<reporter_base_ptr> &reporters);
+                                             const std::vector<rendered_report> &reports);
+
+  /// Upload the remaining annotations and complete the check run by the
+  /// conclusion of all reports.
+  void complete_github_check_run(const runtime_context &context,
+                                 const std::vector<rendered_report> &reports);
+
+  /// Write all outputs enabled in context. The action output, the issue
+  /// comment and the pull request review are written concurrently, since two
+  /// of them are Github round trips. A failed output doesn't stop the others,
+  /// all errors are thrown together after the step summary is written.
+  void write_reports(const runtime_context &context,
+                     const std::vector<reporter_base_ptr> &reporters);
 
   bool all_passed(const std::vector<reporter_base_ptr> &reporters);
+
+  bool all_passed(const std::vector<rendered_report> &reports);
 } // namespace linter::tool
@@ -15,11 +15,14 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include <nlohmann/json.hpp>
+
 namespace linter::tool {
 
   struct per_file_result_base {
@@ -37,8 +40,66 @@ namespace linter::tool {
     bool fastly_exited = false;
 
     std::vector<std::string> ignored;
+    // The files whose check was killed since it didn't finish in time. They
+    // neither pass nor fail.
+    std::vector<std::string> timed_out;
     std::unordered_map<std::string, PerFileResult> passes;
     std::unordered_map<std::string, PerFileResult> fails;
   };
 
+  // Used by sharded checks, whose results are written to files and merged by
+  // another run.
+  template <class PerFileResult>
+  void to_json(nlohmann::json &json, const multi_files_result_base<PerFileResult> &result) {
+    json = {
+      {"final_passed",  result.final_passed },
+      {"fastly_exited", result.fastly_exited},
+      {"ignored",       result.ignored      },
+      {"timed_out",     result.timed_out    },
+      {"passes",        result.passes       },
+      {"fails",         result.fails        }
+    };
+  }
+
+  template <class PerFileResult>
+  void from_json(const nlohmann::json &json, multi_files_result_base<PerFileResult> &result) {
+    json.at("final_passed").get_to(result.final_passed);
+    json.at("fastly_exited").get_to(result.fastly_exited);
+    json.at("ignored").get_to(result.ignored);
+    json.at("timed_out").get_to(result.timed_out);
+    json.at("passes").get_to(result.passes);
+    json.at("fails").get_to(result.fails);
+  }
+
+  /// Whether all files pass. Timed out files weren't completely checked, so
+  /// they fail the result unless allowed.
+  template <class PerFileResult>
+  auto is_passed(const multi_files_result_base<PerFileResult> &result, bool allow_timed_out)
+    -> bool {
+    return result.fails.empty() && !result.fastly_exited
+        && (allow_timed_out || result.timed_out.empty());
+  }
+
+  /// Merge the result of another shard into the given result. Files checked by
+  /// several shards, e.g. loaded from the result cache, have the same result.
+  template <class PerFileResult>
+  void merge_results(multi_files_result_base<PerFileResult> &result,
+                     multi_files_result_base<PerFileResult> other,
+                     bool allow_timed_out) {
+    result.fastly_exited = result.fastly_exited || other.fastly_exited;
+    for (auto &file: other.ignored) {
+      if (std::ranges::find(result.ignored, file) == result.ignored.end()) {
+        result.ignored.push_back(std::move(file));
+      }
+    }
+    for (auto &file: other.timed_out) {
+      if (std::ranges::find(result.timed_out, file) == result.timed_out.end()) {
+        result.timed_out.push_back(std::move(file));
+      }
+    }
+    result.passes.merge(std::move(other.passes));
+    result.fails.merge(std::move(other.fails));
+    result.final_passed = is_passed(result, allow_timed_out);
+  }
+
 } // namespace linter::tool
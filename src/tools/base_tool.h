@@ -15,12 +15,26 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <ranges>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
 
 #include "context.h"
 #include "tools/base_reporter.h"
+#include "tools/path_filter.h"
+#include "tools/result_cache.h"
+#include "tools/scheduler.h"
+#include "utils/shell.h"
 
 namespace linter::tool {
   /// This is a base class represents linter tools. All specified tools should be
@@ -37,18 +51,193 @@ namespace linter::tool {
     /// Return version of this tool.
     virtual auto version() -> std::string_view = 0;
 
-    /// Apply this tool to a single file.
-    virtual void check(const runtime_context &context) = 0;
+    /// Do the work of prepare which doesn't depend on the changed files ahead,
+    /// e.g. resolving the binary. It's called while the diff is computed, so
+    /// it mustn't read the diff. Errors are left to prepare to report, since
+    /// the tool may have nothing to check.
+    virtual void warm_up([[maybe_unused]] const runtime_context &context) {
+    }
+
+    /// Return the iregex of files to be checked by this tool.
+    virtual auto source_filter_iregex() -> const std::string & = 0;
+
+    /// Split the check into tasks, so that tasks of several tools could be run
+    /// by a shared pool. The tasks may reference this tool and the context.
+    /// The changed files are classified by source_filter_iregex.
+    virtual auto prepare(const runtime_context &context, const classified_files &files)
+      -> std::vector<tool_task> = 0;
+
+    /// Merge the results of tasks. Called after all tasks of this tool finished.
+    virtual void finalize(const runtime_context &context) = 0;
+
+    /// Whether any file failed so far. It's called while tasks are running.
+    virtual auto failed() -> bool {
+      return false;
+    }
+
+    /// Return the maximum number of tasks of this tool to be run concurrently.
+    virtual auto jobs() -> std::size_t {
+      return std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    /// Apply this tool to all changed files.
+    virtual void check(const runtime_context &context) {
+      auto classes = classify_files(context.changed_files, {source_filter_iregex()});
+      run_tasks(prepare(context, classes.front()), jobs());
+      finalize(context);
+    }
 
     virtual auto get_reporter() -> reporter_base_ptr = 0;
+
+    /// Return the result of the check, so results of shards could be merged
+    /// by another run.
+    virtual auto dump_result() -> nlohmann::json = 0;
+
+    /// Merge a result returned by dump_result into the result of this tool.
+    virtual void merge_result(const runtime_context &context, const nlohmann::json &value) = 0;
   };
 
   /// An unique pointer for base tool.
   using tool_base_ptr = std::unique_ptr<tool_base>;
 
+  /// Warm up all tools concurrently.
+  inline void warm_up_tools(const std::vector<tool_base_ptr> &tools,
+                            const runtime_context &context) {
+    auto tasks = std::vector<tool_task>{};
+    for (const auto &tool: tools) {
+      tasks.push_back({.cost = 0, .name = std::format("warm up {}", tool->name()), .run = [&] {
+                         try {
+                           tool->warm_up(context);
+                         } catch (const std::exception &err) {
+                           spdlog::debug("Failed to warm up {}: {}", tool->name(), err.what());
+                         }
+                       }});
+    }
+    auto num_tasks = tasks.size();
+    run_tasks(std::move(tasks), num_tasks);
+  }
+
+  /// Run the tasks of tools one tool after another, the cheapest tool by the
+  /// estimated costs first, e.g. clang-format before clang-tidy. No more task
+  /// of any tool is started once a file fails, and the child processes still
+  /// running are killed, so the results are partial.
+  inline auto run_tasks_fail_fast(const std::vector<tool_base_ptr> &tools,
+                                  std::vector<tool_task> tasks,
+                                  std::uint64_t max_memory) -> task_measures {
+    auto stages = std::vector<std::vector<tool_task>>(tools.size());
+    auto costs  = std::vector<std::uint64_t>(tools.size(), 0);
+    auto failed = std::atomic<bool>{false};
+    for (auto &task: tasks) {
+      auto &tool = *tools[task.owner];
+      costs[task.owner] += task.cost;
+      task.run = [&failed, &tool, run = std::move(task.run)] {
+        run();
+        if (tool.failed() && !failed.exchange(true)) {
+          shell::runner::instance().kill_all();
+        }
+      };
+      stages[task.owner].push_back(std::move(task));
+    }
+
+    auto order = std::views::iota(std::size_t{0}, tools.size()) | std::ranges::to<std::vector>();
+    std::ranges::stable_sort(order, {}, [&](std::size_t idx) { return costs[idx]; });
+
+    auto measures = task_measures{};
+    for (auto idx: order) {
+      if (failed.load()) {
+        spdlog::info("Skip {} since a file failed and fail fast is enabled", tools[idx]->name());
+        for (auto &task: stages[idx]) {
+          if (task.skip) {
+            task.skip();
+          }
+        }
+        continue;
+      }
+      auto stage = run_tasks(std::move(stages[idx]), tools[idx]->jobs(), max_memory, &failed);
+      measures.durations.merge(stage.durations);
+      measures.memories.merge(stage.memories);
+    }
+    return measures;
+  }
+
+  /// Check by all tools. The tasks of all tools are run by one pool, so checks
+  /// of different tools overlap with each other unless fail fast is enabled.
+  /// If the check is sharded, each tool only prepares the files of the current
+  /// shard, see select_shard_files.
   inline void do_check(const std::vector<tool_base_ptr> &tools, const runtime_context &context) {
+    // Changed files are classified for all tools at once, each filter is
+    // compiled once however many files there are.
+    auto iregexes = tools
+                  | std::views::transform([](const auto &tool) -> std::string {
+                      return tool->source_filter_iregex();
+                    })
+                  | std::ranges::to<std::vector>();
+    auto classes  = classify_files(context.changed_files, iregexes);
+
+    // The pool is as large as the most parallel tool, while each tool still
+    // runs no more tasks at a time than its own jobs.
+    auto tasks       = std::vector<tool_task>{};
+    auto num_threads = std::size_t{1};
+    auto owner_jobs  = std::vector<std::size_t>{};
+    for (auto idx = std::size_t{0}; idx < tools.size(); ++idx) {
+      for (auto &task: tools[idx]->prepare(context, classes[idx])) {
+        task.owner = idx;
+        tasks.push_back(std::move(task));
+      }
+      owner_jobs.push_back(tools[idx]->jobs());
+      num_threads = std::max(num_threads, owner_jobs.back());
+    }
+
+    // The durations of former runs are kept in the cache directory to balance
+    // shards by the time they really take rather than the sizes of files.
+    constexpr auto durations_key = "task-durations";
+    auto cache                   = result_cache{context.cache_dir, "scheduler"};
+    auto durations               = cache.load(durations_key)
+                                     .transform([](const nlohmann::json &value) {
+                                       return value.get<task_durations>();
+                                     })
+                                     .value_or(task_durations{});
+    apply_task_durations(tasks, durations);
+
+    // So is the peak memory, to admit tasks by the memory budget.
+    constexpr auto memories_key = "task-memories";
+    auto memories               = cache.load(memories_key)
+                                    .transform([](const nlohmann::json &value) {
+                                      return value.get<task_memories>();
+                                    })
+                                    .value_or(task_memories{});
+    apply_task_memories(tasks, memories);
+
+    // Measures of tasks no longer existing are dropped.
+    auto kept        = task_durations{};
+    auto kept_memory = task_memories{};
+    for (const auto &task: tasks) {
+      if (auto iter = durations.find(task.name); iter != durations.end()) {
+        kept.insert(*iter);
+      }
+      if (auto iter = memories.find(task.name); iter != memories.end()) {
+        kept_memory.insert(*iter);
+      }
+    }
+
+    spdlog::info("Run {} tasks of shard {}/{}",
+                 tasks.size(),
+                 context.shard_index + 1,
+                 context.shard_count);
+    auto max_memory = std::uint64_t{context.max_memory} * 1024 * 1024;
+    auto measures   = context.fail_fast
+                      ? run_tasks_fail_fast(tools, std::move(tasks), max_memory)
+                      : run_tasks(std::move(tasks), num_threads, max_memory, nullptr, owner_jobs);
+    for (auto &[name, duration]: measures.durations) {
+      kept[name] = duration;
+    }
+    for (auto &[name, memory]: measures.memories) {
+      kept_memory[name] = memory;
+    }
+    cache.store(durations_key, kept);
+    cache.store(memories_key, kept_memory);
     for (const auto &tool: tools) {
-      tool->check(context);
+      tool->finalize(context);
     }
   }
 
@@ -64,12 +253,8 @@ namespace linter::tool {
   inline auto
   check_then_get_reporters(const std::vector<tool_base_ptr> &tools, const runtime_context &context)
     -> std::vector<reporter_base_ptr> {
-    auto ret = std::vector<reporter_base_ptr>{};
-    for (const auto &tool: tools) {
-      tool->check(context);
-      ret.emplace_back(tool->get_reporter());
-    }
-    return ret;
+    do_check(tools, context);
+    return get_reporters(tools);
   }
 
 } // namespace linter::tool
@@ -15,6 +15,8 @@
  */
 #include "tools/clang_format/creator.h"
 
+#include <spdlog/spdlog.h>
+
 #include "tools/base_tool.h"
 #include "tools/clang_format/general/impl.h"
 #include "tools/clang_format/version/v18.h"
@@ -28,6 +30,10 @@ namespace linter::tool::clang_format {
   constexpr auto clang_format_version            = "clang-format-version";
   constexpr auto clang_format_binary             = "clang-format-binary";
   constexpr auto clang_format_iregex             = "clang-format-iregex";
+  constexpr auto clang_format_single_invocation  = "clang-format-single-invocation";
+  constexpr auto clang_format_read_from_git      = "clang-format-read-from-git";
+  constexpr auto clang_format_batch_size         = "clang-format-batch-size";
+  constexpr auto clang_format_timeout            = "clang-format-timeout";
 
   void creator::register_option(program_options::options_description &desc) const {
     using namespace program_options; // NOLINT
@@ -43,6 +49,19 @@ namespace linter::tool::clang_format {
     (clang_format_binary,              value<string>(),    "Set the full path of clang-format executable binary. "
                                                            "You are't allowed to specify both this option and "
                                                            "clang-format-version to avoid ambiguous")
+    (clang_format_iregex,              value<string>(),    "Set the case insensitive regex of files to be checked by "
+                                                           "clang-format. Default to C/C++ source and header files")
+    (clang_format_single_invocation,   value<bool>(),      "Run clang-format only once per file and derive the formatted "
+                                                           "source code from the replacements. Default to true")
+    (clang_format_read_from_git,       value<bool>(),      "Read files of source revision from git and pass them to "
+                                                           "clang-format by stdin, so the files needn't be checked out. "
+                                                           "Config files are still looked up in the repository path")
+    (clang_format_batch_size,          value<uint32_t>(),  "Set the maximum number of files passed to one clang-format "
+                                                           "invocation. Ignored if clang-format-read-from-git is set. "
+                                                           "Default to 1")
+    (clang_format_timeout,             value<uint32_t>(),  "Set the seconds each clang-format invocation may take. The "
+                                                           "files of an invocation running longer are killed and "
+                                                           "reported as timed out. Default to 0, unlimited")
   ;
     // clang-format on
   }
@@ -60,28 +79,50 @@ namespace linter::tool::clang_format {
     if (variables.contains(enable_clang_format_fastly_exit)) {
       option.enabled_fastly_exit = variables[enable_clang_format_fastly_exit].as<bool>();
     }
+    if (variables.contains(clang_format_iregex)) {
+      option.source_filter_iregex = variables[clang_format_iregex].as<std::string>();
+    }
+    if (variables.contains(clang_format_single_invocation)) {
+      option.single_invocation = variables[clang_format_single_invocation].as<bool>();
+    }
+    if (variables.contains(clang_format_read_from_git)) {
+      option.read_from_git = variables[clang_format_read_from_git].as<bool>();
+    }
+    if (variables.contains(clang_format_batch_size)) {
+      option.batch_size = variables[clang_format_batch_size].as<std::uint32_t>();
+      throw_if(option.batch_size == 0, "clang-format-batch-size must be greater than 0");
+    }
+    if (variables.contains(clang_format_timeout)) {
+      option.timeout = variables[clang_format_timeout].as<std::uint32_t>();
+    }
+    // The binary is resolved by the tool when it has files to check.
     if (variables.contains(clang_format_version)) {
       option.version = variables[clang_format_version].as<std::string>();
       throw_if(variables.contains(clang_format_binary),
                "specify both clang-format-binary and clang-format-version is "
                "ambiguous");
-      option.binary = find_clang_tool("clang-format", option.version);
+      option.binary = std::format("clang-format-{}", option.version);
     } else if (variables.contains(clang_format_binary)) {
       throw_if(variables.contains(clang_format_version),
                "specify both clang-format-binary and clang-format-version is "
                "ambiguous");
-      option.binary               = variables[clang_format_binary].as<std::string>();
-      auto [ec, std_out, std_err] = shell::which(option.binary);
-      throw_unless(ec == 0, std::format("Can't find given clang_format binary: {}", option.binary));
-      spdlog::info("The clang-format executable path: {}", option.binary);
+      option.binary = variables[clang_format_binary].as<std::string>();
     } else {
-      auto [ec, std_out, std_err] = shell::which("clang-format");
-      throw_unless(ec == 0, "Can't find clang-format");
-      option.binary = std_out;
+      option.binary = "clang-format";
     }
   }
 
   auto creator::create_tool(const runtime_context &context) -> tool_base_ptr {
+    // The staged contents are checked rather than the working tree.
+    if (context.staged) {
+      option.read_from_git = true;
+    }
+    // The saved files are checked rather than source revision, which they
+    // differ from.
+    if (context.watch && option.read_from_git) {
+      spdlog::info("Ignore {} since saved files are watched", clang_format_read_from_git);
+      option.read_from_git = false;
+    }
     auto version = option.version;
     auto tool    = tool_base_ptr{};
     if (version == version_18_1_3) {
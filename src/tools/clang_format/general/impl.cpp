@@ -15,106 +15,45 @@
  */
 #include "tools/clang_format/general/impl.h"
 
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <exception>
 #include <cstdint>
+#include <filesystem>
+#include <format>
 #include <fstream>
+#include <iterator>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 #include <vector>
 
-#include <boost/regex.hpp>
 #include <spdlog/spdlog.h>
-#include <tinyxml2.h>
 
+#include "github/annotation.h"
+#include "tools/clang_format/general/replacements.h"
 #include "tools/clang_format/general/reporter.h"
+#include "tools/result_cache.h"
 #include "tools/util.h"
+#include "utils/git_utils.h"
+#include "utils/line_index.h"
+#include "utils/log.h"
 #include "utils/shell.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace linter::tool::clang_format {
   namespace {
 
-    // Read a file and get this
-    auto get_line_lens(std::string_view file_path) -> std::vector<uint32_t> {
-      spdlog::trace("Enter clang_format::get_line_lens()");
-      constexpr auto line_feed_len = 1;
-
-      auto lines = std::vector<uint32_t>{};
-      auto file  = std::ifstream{file_path.data()};
-      auto temp  = std::string{};
-      while (std::getline(file, temp)) {
-        lines.emplace_back(temp.size() + line_feed_len);
-      }
-      return lines;
-    }
-
-    // offset starts from 0 while row/col starts from 1
-    auto get_position(const std::vector<uint32_t> &lens, int offset)
-      -> std::tuple<int32_t, int32_t> {
-      spdlog::trace("Enter clang_format::get_position()");
-
-      auto cur = uint32_t{0};
-      for (int row = 0; row < lens.size(); ++row) {
-        auto len = lens[row];
-        if (offset >= cur && offset < cur + len) {
-          return {row + 1, offset - cur + 1};
-        }
-        cur += len;
-      }
-      return {-1, -1};
-    }
-
-    inline auto xml_error(tinyxml2::XMLError err) -> std::string_view {
-      spdlog::trace("Enter clang_format::xml_error() with err:{}", static_cast<int>(err));
-      return tinyxml2::XMLDocument::ErrorIDToName(err);
-    }
-
-    inline auto xml_has_error(tinyxml2::XMLError err) -> bool {
-      spdlog::trace("Enter clang_format::xml_has_error() with err:{}", static_cast<int>(err));
-      return err != tinyxml2::XMLError::XML_SUCCESS;
-    }
-
-    auto parse_replacements_xml(std::string_view data) -> replacements_t {
-      spdlog::trace("Enter clang_format::parse_replacements_xml()");
-
-      // Names in replacements xml file.
-      static constexpr auto offset_str       = "offset";
-      static constexpr auto length_str       = "length";
-      static constexpr auto replacements_str = "replacements";
-      static constexpr auto replacement_str  = "replacement";
-
-      // Start to parse given data to xml tree.
-      auto doc = tinyxml2::XMLDocument{};
-      auto err = doc.Parse(data.data());
-      throw_if(xml_has_error(err),
-               std::format("Parse replacements xml failed since: {}", xml_error(err)));
-      throw_if(doc.NoChildren(),
-               "Parse replacements xml failed since no children in replacements xml");
-
-      // Find <replacements><replacement offset="xxx"
-      // length="xxx">text</replacement></replacements>
-      auto *replacements_ele = doc.FirstChildElement(replacements_str);
-      throw_if(replacements_ele == nullptr,
-               "Parse replacements xml failed since no child names 'replacements'");
-      auto replacements = replacements_t{};
-
-      // Empty replacement node is allowd here.
-      auto *replacement_ele = replacements_ele->FirstChildElement(replacement_str);
-      while (replacement_ele != nullptr) {
-        auto replacement = replacement_t{};
-        replacement_ele->QueryIntAttribute(offset_str, &replacement.offset);
-        replacement_ele->QueryIntAttribute(length_str, &replacement.length);
-        const auto *text = replacement_ele->GetText();
-        if (text != nullptr) {
-          replacement.data = text;
-        }
-
-        replacements.emplace_back(std::move(replacement));
-
-        replacement_ele = replacement_ele->NextSiblingElement(replacement_str);
-      }
-      return replacements;
+    auto read_file(const std::filesystem::path &path) -> std::string {
+      spdlog::trace("Enter clang_format::read_file()");
+      auto file = std::ifstream{path, std::ios::binary};
+      throw_unless(file.is_open(), std::format("failed to open {} to read", path.string()));
+      return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
     }
 
     enum class output_style_t : std::uint8_t {
@@ -122,46 +61,135 @@ namespace linter::tool::clang_format {
       replacement_xml
     };
 
-    auto make_replacements_options(std::string_view file) -> std::vector<std::string> {
+    // The file is passed by stdin if its content is given, clang-format still
+    // needs its name to find the config file and detect the language.
+    auto make_file_option(std::string_view file, bool from_stdin) -> std::string {
+      return from_stdin ? std::format("--assume-filename={}", file) : std::string{file};
+    }
+
+    auto make_replacements_options(std::span<const std::string> files, bool from_stdin)
+      -> std::vector<std::string> {
       spdlog::trace("Enter clang_format::make_replacements_options()");
       auto tool_opt = std::vector<std::string>{};
       tool_opt.emplace_back("--output-replacements-xml");
-      tool_opt.emplace_back(file);
+      for (const auto &file: files) {
+        tool_opt.emplace_back(make_file_option(file, from_stdin));
+      }
       return tool_opt;
     }
 
-    auto make_source_code_options(std::string_view file) -> std::vector<std::string> {
+    auto make_source_code_options(std::span<const std::string> files, bool from_stdin)
+      -> std::vector<std::string> {
       spdlog::trace("Enter clang_format::make_source_code_options()");
       auto tool_opt = std::vector<std::string>{};
-      tool_opt.emplace_back(file);
+      for (const auto &file: files) {
+        tool_opt.emplace_back(make_file_option(file, from_stdin));
+      }
       return tool_opt;
     }
 
+    // Several files could be formatted by one invocation, unless the content
+    // of file is passed by stdin.
     auto execute(const option_t &opt,
                  output_style_t output_style,
                  std::string_view repo,
-                 std::string_view file) -> shell::result {
+                 std::span<const std::string> files,
+                 const std::optional<std::string> &content) -> shell::result {
       spdlog::trace("Enter clang_format::execute()");
 
+      auto from_stdin   = content.has_value();
       auto tool_opt     = output_style == output_style_t::formatted_source_code
-                          ? make_source_code_options(file)
-                          : make_replacements_options(file);
-      auto tool_opt_str = tool_opt | std::views::join_with(' ') | std::ranges::to<std::string>();
-      spdlog::info("Running command: {} {}", opt.binary, tool_opt_str);
+                          ? make_source_code_options(files, from_stdin)
+                          : make_replacements_options(files, from_stdin);
+      LINTER_INFO("Running command: {} {}",
+                  opt.binary,
+                  tool_opt | std::views::join_with(' ') | std::ranges::to<std::string>());
+
+      auto config = shell::execute_config{.env          = {},
+                                          .start_dir    = std::string{repo},
+                                          .std_in       = content,
+                                          .std_out_sink = {},
+                                          .std_err_sink = {},
+                                          .timeout      = std::chrono::seconds{opt.timeout}};
+      auto res    = shell::async_execute(opt.binary, tool_opt, config).get();
+      record_task_memory(res.peak_rss);
+      if (res.killed) {
+        throw shell::killed_error{std::format("{} was killed on {}", opt.binary, files.front())};
+      }
+      if (res.timed_out) {
+        throw shell::timeout_error{std::format("{} timed out on {}", opt.binary, files.front())};
+      }
+      return res;
+    }
 
-      return shell::execute(opt.binary, tool_opt, repo);
+    // clang-format prints one replacements xml document for each file when
+    // several files are given.
+    auto split_xml_documents(std::string_view std_out) -> std::vector<std::string_view> {
+      static constexpr auto declaration = std::string_view{"<?xml"};
+      auto documents = std::vector<std::string_view>{};
+      auto begin     = std_out.find(declaration);
+      while (begin != std::string_view::npos) {
+        auto end = std_out.find(declaration, begin + declaration.size());
+        documents.push_back(std_out.substr(begin, end - begin));
+        begin = end;
+      }
+      return documents;
+    }
+
+    /// Bumped whenever the cached format of per_file_result is changed.
+    constexpr auto result_format_version = 2;
+
+    /// The keys of well formatted files are kept in one cache entry, since most
+    /// files are, and loading it once is cheaper than loading an entry of each.
+    constexpr auto clean_files_key = "clean-files";
+    constexpr auto max_clean_keys  = std::size_t{65536};
+
+    // Each replacement is annotated on the line it starts at, or the first
+    // line if unknown.
+    auto make_annotations(const per_file_result &result) -> github::annotations {
+      auto ret = github::annotations{};
+      for (const auto &replacement: result.replacements) {
+        auto row = static_cast<std::uint32_t>(std::max(replacement.row, 1));
+        ret.push_back({.path             = result.file_path,
+                       .start_line       = row,
+                       .end_line         = row,
+                       .annotation_level = "warning",
+                       .title            = "clang-format",
+                       .message          = "The code isn't formatted as clang-format suggests",
+                       .raw_details      = std::format("Replace {} characters with: '{}'",
+                                                  replacement.length,
+                                                  replacement.data)});
+      }
+      if (ret.empty()) {
+        ret.push_back({.path             = result.file_path,
+                       .start_line       = 1,
+                       .end_line         = 1,
+                       .annotation_level = "failure",
+                       .title            = "clang-format",
+                       .message          = "clang-format failed to check the file",
+                       .raw_details      = result.tool_stderr});
+      }
+      return ret;
     }
 
   } // namespace
 
-  // TODO: we should always use source branch's file, not "current" file.
   auto clang_format_general::check_single_file(
-    [[maybe_unused]] const runtime_context &ctx,
+    const runtime_context &ctx,
     const std::string &root_dir,
     const std::string &file) const -> per_file_result {
     spdlog::trace("Enter base_clang_format::apply_on_single_file()");
 
-    auto xml_res       = execute(option, output_style_t::replacement_xml, root_dir, file);
+    // Read the file of source revision from git and pipe it to clang-format,
+    // otherwise clang-format reads the file in the working tree.
+    auto content = std::optional<std::string>{};
+    if (option.read_from_git) {
+      auto handle = ctx.repos->acquire();
+      auto blob   = git::blob::get_view(handle->repo.get(), handle->source_tree.get(), file);
+      content     = std::string{blob.content};
+    }
+
+    auto xml_res = execute(option, output_style_t::replacement_xml, root_dir, {&file, 1}, content);
     auto result        = per_file_result{};
     result.file_path   = file;
     result.tool_stdout = xml_res.std_out;
@@ -170,58 +198,267 @@ namespace linter::tool::clang_format {
       result.passed = false;
       return result;
     }
+    complete_result(root_dir, xml_res.std_out, content, result);
+    return result;
+  }
 
-    auto replacements   = parse_replacements_xml(xml_res.std_out);
-    result.replacements = std::move(replacements);
+  auto clang_format_general::check_batch(const runtime_context &ctx,
+                                         const std::string &root_dir,
+                                         std::span<const std::string> files) const
+    -> std::vector<per_file_result> {
+    auto check_each = [&] {
+      return files
+           | std::views::transform([&](const auto &file) {
+               return check_single_file(ctx, root_dir, file);
+             })
+           | std::ranges::to<std::vector>();
+    };
+    if (files.size() == 1 || option.read_from_git) {
+      return check_each();
+    }
+
+    auto xml_res   = execute(option, output_style_t::replacement_xml, root_dir, files, {});
+    auto documents = split_xml_documents(xml_res.std_out);
+    // It's unknown which file caused the failure, so each file is checked
+    // alone to get its own result.
+    if (xml_res.exit_code != 0 || documents.size() != files.size()) {
+      spdlog::info("Failed to check {} files by one clang-format invocation, check them one by one",
+                   files.size());
+      return check_each();
+    }
 
-    if (option.needs_formatted_source_code) {
+    auto results = std::vector<per_file_result>{};
+    results.reserve(files.size());
+    for (auto idx = std::size_t{0}; idx < files.size(); ++idx) {
+      auto &result       = results.emplace_back();
+      result.file_path   = files[idx];
+      result.tool_stdout = documents[idx];
+      result.tool_stderr = xml_res.std_err;
+      complete_result(root_dir, documents[idx], {}, result);
+    }
+    return results;
+  }
+
+  void clang_format_general::complete_result(const std::string &root_dir,
+                                             std::string_view replacements_xml,
+                                             const std::optional<std::string> &content,
+                                             per_file_result &result) const {
+    const auto &file = result.file_path;
+    {
+      auto scope          = trace::scope{"parse", std::format("clang-format {}", file)};
+      result.replacements = parse_replacements_xml(replacements_xml);
+    }
+    // Nothing else is needed by reporters of a well formatted file.
+    result.passed = result.replacements.empty();
+    if (result.passed) {
+      return;
+    }
+
+    // The source code is read once and shared by position conversion and
+    // formatted source code derivation.
+    auto source = content ? *content : read_file(std::filesystem::path{root_dir} / file);
+    auto lines  = line_index{source};
+    for (auto &replacement: result.replacements) {
+      if (auto pos = lines.position(replacement.offset)) {
+        replacement.row = static_cast<int>(pos->first);
+        replacement.col = static_cast<int>(pos->second);
+      }
+    }
+
+    if (option.needs_formatted_source_code && option.single_invocation) {
+      spdlog::debug("Derive formatted source code from replacements.");
+      result.formatted_source_code = apply_replacements(source, result.replacements);
+    } else if (option.needs_formatted_source_code) {
       spdlog::debug("Execute clang-format again to get formatted source code.");
-      auto code_res       = execute(option, output_style_t::formatted_source_code, root_dir, file);
+      auto code_res =
+        execute(option, output_style_t::formatted_source_code, root_dir, {&file, 1}, content);
       result.tool_stdout += "\n" + code_res.std_out;
       result.tool_stderr += "\n" + code_res.std_err;
       if (code_res.exit_code != 0) {
         result.passed = false;
-        return result;
+        return;
       }
       result.formatted_source_code = code_res.std_out;
     }
+  }
 
-    return result;
+  void clang_format_general::warm_up(const runtime_context &context) {
+    auto binary = resolve_tool_binary(option.binary);
+    if (!context.cache_dir.empty()) {
+      tool_version(context.cache_dir, binary);
+    }
   }
 
-  void clang_format_general::check(const runtime_context &context) {
-    const auto root_dir = context.repo_path;
-    const auto files    = context.changed_files;
-    for (const auto &file: files) {
-      if (filter_file(option.source_filter_iregex, file)) {
-        result.ignored.push_back(file);
-        spdlog::debug("file is ignored {} by {}", file, option.binary);
-        continue;
-      }
+  auto clang_format_general::prepare(const runtime_context &context,
+                                     const classified_files &files) -> std::vector<tool_task> {
+    for (const auto &file: files.ignored) {
+      result.ignored.push_back(file);
+      spdlog::debug("file is ignored {} by {}", file, option.binary);
+    }
+    auto shard =
+      select_shard_files(files.matched, context.repo_path, context.shard_index, context.shard_count);
+    auto file_cache = result_cache{context.cache_dir, name()};
+    state           = std::make_unique<check_state>(std::move(shard), std::move(file_cache));
+    auto &[checked, keys, from_cache, slots, cache, clean_keys] = *state;
+    if (checked.empty()) {
+      return {};
+    }
+    option.binary = resolve_tool_binary(option.binary);
+    if (context.annotations != nullptr) {
+      slots.on_failed = [&context](const per_file_result &res) {
+        context.annotations->add(make_annotations(res));
+      };
+    }
+    if (context.results != nullptr) {
+      slots.on_checked = [this, &context](const per_file_result &res) {
+        // A failed file without replacements is reported as failed to check.
+        auto diagnostics = res.passed ? github::annotations{} : make_annotations(res);
+        context.results->add(name(), res, diagnostics);
+      };
+    }
 
-      auto per_file_result = check_single_file(context, root_dir, file);
-      if (per_file_result.passed) {
-        spdlog::info("file: {} passes {} check.", file, option.binary);
-        result.passes[file] = std::move(per_file_result);
-        continue;
+    // Reuse the cached results of files which are unchanged since last run.
+    if (cache.enabled()) {
+      static const auto config_names = std::vector<std::string>{".clang-format", "_clang-format"};
+      auto args = std::vector<std::string>{"--output-replacements-xml"};
+      args.push_back(std::format("formatted-source-code={}", option.needs_formatted_source_code));
+      args.push_back(std::format("single-invocation={}", option.single_invocation));
+      args.push_back(std::format("read-from-git={}", option.read_from_git));
+      args.push_back(std::format("result-format-{}", result_format_version));
+      // The files are read from git or from the working tree, keyed by what
+      // clang-format is actually given.
+      auto source      = option.read_from_git ? content_source_t::source_revision
+                                              : content_source_t::work_tree;
+      auto fingerprint = make_tool_fingerprint(context, option.binary, args, {});
+      if (auto cached = cache.load(clean_files_key)) {
+        clean_keys = cached->get<std::vector<std::string>>();
+      }
+      auto clean = std::unordered_set<std::string_view>{clean_keys.begin(), clean_keys.end()};
+      for (auto idx = std::size_t{0}; idx < checked.size(); ++idx) {
+        keys[idx] = make_cache_key(context, fingerprint, checked[idx], config_names, {}, source);
+        if (keys[idx] && clean.contains(*keys[idx])) {
+          spdlog::info("{} is known to be formatted by {}", checked[idx], option.binary);
+          auto clean_result      = per_file_result{};
+          clean_result.passed    = true;
+          clean_result.file_path = checked[idx];
+          slots.set(idx, std::move(clean_result));
+          from_cache[idx] = true;
+          continue;
+        }
+        auto cached = keys[idx] ? cache.load(*keys[idx]) : std::nullopt;
+        if (!cached) {
+          continue;
+        }
+        spdlog::info("Use the cached {} result of {}", option.binary, checked[idx]);
+        slots.set(idx, cached->get<per_file_result>());
+        from_cache[idx] = true;
       }
+    }
 
-      spdlog::error("file: {} doesn't pass {} check.", file, option.binary);
-      result.fails[file] = std::move(per_file_result);
+    auto pending = std::vector<std::size_t>{};
+    for (auto idx = std::size_t{0}; idx < checked.size(); ++idx) {
+      if (!from_cache[idx]) {
+        pending.push_back(idx);
+      }
+    }
 
-      if (option.enabled_fastly_exit) {
-        spdlog::info("{} fastly exit since check failed", option.binary);
-        result.final_passed  = false;
-        result.fastly_exited = true;
-        return;
+    // Consecutive files are grouped into batches, so the startup of
+    // clang-format and the loading of configs are shared by a batch.
+    auto tasks            = std::vector<tool_task>{};
+    const auto batch_size = std::size_t{option.batch_size};
+    for (auto begin = std::size_t{0}; begin < pending.size(); begin += batch_size) {
+      auto count   = std::min(batch_size, pending.size() - begin);
+      auto indices = std::vector<std::size_t>(pending.begin() + begin,
+                                              pending.begin() + begin + count);
+      auto task    = tool_task{};
+      for (auto idx: indices) {
+        task.cost += estimate_file_cost(context.repo_path, checked[idx]);
+      }
+      task.name = std::format("{} {}", name(), checked[indices.front()]);
+      if (indices.size() > 1) {
+        task.name += std::format(" and {} more", indices.size() - 1);
       }
+      task.skip = [this, indices] {
+        for (auto idx: indices) {
+          state->slots.set_skipped(idx);
+        }
+      };
+      task.run = [this, &context, indices = std::move(indices)] {
+        auto &slots = state->slots;
+        if (option.enabled_fastly_exit && slots.after_failed(indices.front())) {
+          for (auto idx: indices) {
+            slots.set_skipped(idx);
+          }
+          return;
+        }
+        try {
+          auto batch = indices
+                     | std::views::transform([&](auto idx) { return state->files[idx]; })
+                     | std::ranges::to<std::vector<std::string>>();
+          auto batch_results = check_batch(context, context.repo_path, batch);
+          for (auto offset = std::size_t{0}; offset < indices.size(); ++offset) {
+            slots.set(indices[offset], std::move(batch_results[offset]));
+          }
+        } catch (const shell::timeout_error &) {
+          for (auto idx: indices) {
+            slots.set_timed_out(idx);
+          }
+        } catch (const shell::killed_error &) {
+          for (auto idx: indices) {
+            slots.set_skipped(idx);
+          }
+        } catch (...) {
+          slots.set_error(indices.front(), std::current_exception());
+        }
+      };
+      tasks.push_back(std::move(task));
     }
+    return tasks;
+  }
 
-    result.final_passed = result.fails.empty();
+  void clang_format_general::finalize(const runtime_context &context) {
+    auto &[checked, keys, from_cache, slots, cache, clean_keys] = *state;
+    auto new_clean_keys = std::vector<std::string>{};
+    slots.merge(checked,
+                result,
+                option.enabled_fastly_exit,
+                context.allow_timed_out,
+                option.binary,
+                [&](std::size_t idx, const per_file_result &res) {
+                  if (!keys[idx] || from_cache[idx]) {
+                    return;
+                  }
+                  if (res.passed) {
+                    new_clean_keys.push_back(*keys[idx]);
+                  } else {
+                    cache.store(*keys[idx], res);
+                  }
+                });
+
+    // The latest keys come first, so the oldest are dropped if too many.
+    if (!new_clean_keys.empty()) {
+      for (auto &key: clean_keys) {
+        if (new_clean_keys.size() >= max_clean_keys) {
+          break;
+        }
+        new_clean_keys.push_back(std::move(key));
+      }
+      cache.store(clean_files_key, new_clean_keys);
+    }
+    state.reset();
   }
 
   auto clang_format_general::get_reporter() -> reporter_base_ptr {
     return std::make_unique<reporter_t>(option, result);
   }
 
+  auto clang_format_general::dump_result() -> nlohmann::json {
+    return result;
+  }
+
+  void clang_format_general::merge_result(const runtime_context &context,
+                                          const nlohmann::json &value) {
+    merge_results(result, value.get<result_t>(), context.allow_timed_out);
+  }
+
 } // namespace linter::tool::clang_format
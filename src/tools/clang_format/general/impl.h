@@ -15,7 +15,11 @@
  */
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -26,6 +30,8 @@
 #include "tools/base_tool.h"
 #include "tools/clang_format/general/option.h"
 #include "tools/clang_format/general/result.h"
+#include "tools/result_cache.h"
+#include "tools/scheduler.h"
 
 namespace linter::tool::clang_format {
 
@@ -50,12 +56,62 @@ namespace linter::tool::clang_format {
                            const std::string &root_dir,
                            const std::string &file) const -> per_file_result;
 
-    void check(const runtime_context &context) override;
+    /// Check several files by one clang-format invocation. The returned
+    /// results have the same order as the given files.
+    auto check_batch(const runtime_context &ctx,
+                     const std::string &root_dir,
+                     std::span<const std::string> files) const -> std::vector<per_file_result>;
+
+    void warm_up(const runtime_context &context) override;
+
+    auto source_filter_iregex() -> const std::string & override {
+      return option.source_filter_iregex;
+    }
+
+    auto prepare(const runtime_context &context, const classified_files &files)
+      -> std::vector<tool_task> override;
+
+    void finalize(const runtime_context &context) override;
+
+    auto failed() -> bool override {
+      return state != nullptr && state->slots.any_failed();
+    }
 
     auto get_reporter() -> reporter_base_ptr override;
 
+    auto dump_result() -> nlohmann::json override;
+
+    void merge_result(const runtime_context &context, const nlohmann::json &value) override;
+
+    /// The state shared by prepare, tasks and finalize of one check.
+    struct check_state {
+      check_state(std::vector<std::string> checked_files, result_cache file_cache)
+        : files(std::move(checked_files))
+        , keys(files.size())
+        , from_cache(files.size(), false)
+        , slots(files.size())
+        , cache(std::move(file_cache)) {
+      }
+
+      std::vector<std::string> files;
+      std::vector<std::optional<std::string>> keys;
+      std::vector<bool> from_cache;
+      file_slots<per_file_result> slots;
+      result_cache cache;
+      /// The cache keys of files known to be well formatted, latest first.
+      std::vector<std::string> clean_keys;
+    };
+
     option_t option;
     result_t result;
+    std::unique_ptr<check_state> state;
+
+  private:
+    /// Fill the replacements and formatted source code of a checked file.
+    void complete_result(const std::string &root_dir,
+                         std::string_view replacements_xml,
+                         const std::optional<std::string> &content,
+                         per_file_result &result) const;
   };
 
 } // namespace linter::tool::clang_format
@@ -15,12 +15,19 @@
  */
 #pragma once
 
+#include <cstdint>
+
 #include "tools/base_option.h"
 
 namespace linter::tool::clang_format {
   struct option_t : option_base {
     bool enable_warning_as_error     = false;
-    bool needs_formatted_source_code = true;
+    bool needs_formatted_source_code = false;
+    bool single_invocation           = true;
+    bool read_from_git               = false;
+    std::uint32_t batch_size         = 1;
+    // The seconds each clang-format invocation may take, 0 means unlimited.
+    std::uint32_t timeout = 0;
   };
 
 } // namespace linter::tool::clang_format
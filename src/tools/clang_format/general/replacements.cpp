@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/clang_format/general/replacements.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+#include <tinyxml2.h>
+
+#include "utils/line_index.h"
+#include "utils/util.h"
+
+namespace linter::tool::clang_format {
+  namespace {
+    inline auto xml_error(tinyxml2::XMLError err) -> std::string_view {
+      spdlog::trace("Enter clang_format::xml_error() with err:{}", static_cast<int>(err));
+      return tinyxml2::XMLDocument::ErrorIDToName(err);
+    }
+
+    inline auto xml_has_error(tinyxml2::XMLError err) -> bool {
+      spdlog::trace("Enter clang_format::xml_has_error() with err:{}", static_cast<int>(err));
+      return err != tinyxml2::XMLError::XML_SUCCESS;
+    }
+
+    constexpr auto xml_spaces = std::string_view{" \t\r\n"};
+
+    void skip_spaces(std::string_view &data) {
+      auto idx = data.find_first_not_of(xml_spaces);
+      data.remove_prefix(idx == std::string_view::npos ? data.size() : idx);
+    }
+
+    auto consume(std::string_view &data, std::string_view prefix) -> bool {
+      if (!data.starts_with(prefix)) {
+        return false;
+      }
+      data.remove_prefix(prefix.size());
+      return true;
+    }
+
+    void append_utf8(std::string &out, std::uint32_t code) {
+      if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+      } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+      } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+      } else {
+        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+      }
+    }
+
+    // Decode the entities clang-format writes, e.g. "&#10;" for a new line.
+    auto decode_text(std::string_view text, std::string &out) -> bool {
+      out.reserve(text.size());
+      while (!text.empty()) {
+        auto amp = text.find('&');
+        out.append(text.substr(0, amp));
+        if (amp == std::string_view::npos) {
+          return true;
+        }
+        text.remove_prefix(amp + 1);
+        auto semi = text.find(';');
+        if (semi == std::string_view::npos) {
+          return false;
+        }
+        auto entity = text.substr(0, semi);
+        text.remove_prefix(semi + 1);
+
+        if (entity == "lt") {
+          out.push_back('<');
+        } else if (entity == "gt") {
+          out.push_back('>');
+        } else if (entity == "amp") {
+          out.push_back('&');
+        } else if (entity == "apos") {
+          out.push_back('\'');
+        } else if (entity == "quot") {
+          out.push_back('"');
+        } else if (consume(entity, "#")) {
+          auto base      = consume(entity, "x") ? 16 : 10;
+          auto code      = std::uint32_t{0};
+          auto [ptr, ec] = std::from_chars(entity.begin(), entity.end(), code, base);
+          if (ec != std::errc{} || ptr != entity.end() || code > 0x10FFFF) {
+            return false;
+          }
+          append_utf8(out, code);
+        } else {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Parse attributes like `offset='12' length='1'`. Unknown ones are ignored.
+    auto parse_attributes(std::string_view attrs, replacement_t &replacement) -> bool {
+      skip_spaces(attrs);
+      while (!attrs.empty()) {
+        auto equal = attrs.find('=');
+        if (equal == std::string_view::npos || equal + 1 >= attrs.size()) {
+          return false;
+        }
+        auto name  = trim(attrs.substr(0, equal));
+        auto quote = attrs[equal + 1];
+        if (quote != '\'' && quote != '"') {
+          return false;
+        }
+        attrs.remove_prefix(equal + 2);
+        auto close = attrs.find(quote);
+        if (close == std::string_view::npos) {
+          return false;
+        }
+        auto value = attrs.substr(0, close);
+        attrs.remove_prefix(close + 1);
+        skip_spaces(attrs);
+
+        auto *field = name == "offset" ? &replacement.offset
+                    : name == "length" ? &replacement.length
+                                       : nullptr;
+        if (field != nullptr) {
+          auto [ptr, ec] = std::from_chars(value.begin(), value.end(), *field);
+          if (ec != std::errc{} || ptr != value.end()) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    // Parse the start tag of the given name and return its attributes and
+    // whether it's self closing.
+    auto parse_start_tag(std::string_view &data, std::string_view name)
+      -> std::optional<std::pair<std::string_view, bool>> {
+      if (!consume(data, "<") || !consume(data, name)) {
+        return std::nullopt;
+      }
+      auto tag_end = data.find('>');
+      if (tag_end == std::string_view::npos) {
+        return std::nullopt;
+      }
+      auto attrs        = data.substr(0, tag_end);
+      auto self_closing = attrs.ends_with('/');
+      if (self_closing) {
+        attrs.remove_suffix(1);
+      }
+      // Such as <replacementsX>
+      if (!attrs.empty() && xml_spaces.find(attrs[0]) == std::string_view::npos) {
+        return std::nullopt;
+      }
+      data.remove_prefix(tag_end + 1);
+      return std::pair{attrs, self_closing};
+    }
+
+    // A parser of exactly what clang-format writes, which avoids building a
+    // DOM and copying the whole document. It returns nothing if the data
+    // isn't in the expected form, the caller then falls back to tinyxml2 to
+    // parse the valid xml written in another way or report the error.
+    auto parse_replacements_fast(std::string_view data) -> std::optional<replacements_t> {
+      skip_spaces(data);
+      if (consume(data, "<?xml")) {
+        auto end = data.find("?>");
+        if (end == std::string_view::npos) {
+          return std::nullopt;
+        }
+        data.remove_prefix(end + 2);
+        skip_spaces(data);
+      }
+
+      auto root = parse_start_tag(data, "replacements");
+      if (!root) {
+        return std::nullopt;
+      }
+      auto empty        = root->second;
+      auto replacements = replacements_t{};
+      while (!empty) {
+        skip_spaces(data);
+        if (consume(data, "</replacements>")) {
+          break;
+        }
+        auto tag = parse_start_tag(data, "replacement");
+        if (!tag) {
+          return std::nullopt;
+        }
+        auto [attrs, self_closing] = *tag;
+        auto &replacement          = replacements.emplace_back();
+        if (!parse_attributes(attrs, replacement)) {
+          return std::nullopt;
+        }
+        if (self_closing) {
+          continue;
+        }
+        auto text_end = data.find('<');
+        if (text_end == std::string_view::npos
+            || !decode_text(data.substr(0, text_end), replacement.data)) {
+          return std::nullopt;
+        }
+        data.remove_prefix(text_end);
+        if (!consume(data, "</replacement>")) {
+          return std::nullopt;
+        }
+      }
+
+      skip_spaces(data);
+      if (!data.empty()) {
+        return std::nullopt;
+      }
+      return replacements;
+    }
+  } // namespace
+
+  auto parse_replacements_xml(std::string_view data) -> replacements_t {
+    spdlog::trace("Enter clang_format::parse_replacements_xml()");
+    if (auto replacements = parse_replacements_fast(data)) {
+      return std::move(*replacements);
+    }
+
+    // Names in replacements xml file.
+    static constexpr auto offset_str       = "offset";
+    static constexpr auto length_str       = "length";
+    static constexpr auto replacements_str = "replacements";
+    static constexpr auto replacement_str  = "replacement";
+
+    // Start to parse given data to xml tree.
+    // The data may be one of several documents in the same output, which
+    // isn't null terminated.
+    auto doc = tinyxml2::XMLDocument{};
+    auto err = doc.Parse(data.data(), data.size());
+    throw_if(xml_has_error(err),
+             std::format("Parse replacements xml failed since: {}", xml_error(err)));
+    throw_if(doc.NoChildren(),
+             "Parse replacements xml failed since no children in replacements xml");
+
+    // Find <replacements><replacement offset="xxx"
+    // length="xxx">text</replacement></replacements>
+    auto *replacements_ele = doc.FirstChildElement(replacements_str);
+    throw_if(replacements_ele == nullptr,
+             "Parse replacements xml failed since no child names 'replacements'");
+    auto replacements = replacements_t{};
+
+    // Empty replacement node is allowd here.
+    auto *replacement_ele = replacements_ele->FirstChildElement(replacement_str);
+    while (replacement_ele != nullptr) {
+      auto replacement = replacement_t{};
+      replacement_ele->QueryIntAttribute(offset_str, &replacement.offset);
+      replacement_ele->QueryIntAttribute(length_str, &replacement.length);
+      const auto *text = replacement_ele->GetText();
+      if (text != nullptr) {
+        replacement.data = text;
+      }
+
+      replacements.emplace_back(std::move(replacement));
+
+      replacement_ele = replacement_ele->NextSiblingElement(replacement_str);
+    }
+    return replacements;
+  }
+
+  auto apply_replacements(std::string_view source,
+                          std::span<const replacement_t> replacements,
+                          std::size_t base_offset) -> std::string {
+    spdlog::trace("Enter clang_format::apply_replacements()");
+    auto formatted = std::string{};
+    formatted.reserve(source.size());
+
+    auto cur = std::size_t{0};
+    for (const auto &replacement: replacements) {
+      auto offset = static_cast<std::size_t>(replacement.offset);
+      auto length = static_cast<std::size_t>(replacement.length);
+      throw_if(offset < base_offset + cur || offset + length > base_offset + source.size(),
+               std::format("invalid replacement at offset {} with length {}", offset, length));
+      offset -= base_offset;
+      formatted.append(source.substr(cur, offset - cur));
+      formatted.append(replacement.data);
+      cur = offset + length;
+    }
+    formatted.append(source.substr(cur));
+    return formatted;
+  }
+
+  auto make_suggestions(std::string_view source, const replacements_t &replacements)
+    -> std::vector<suggestion_t> {
+    spdlog::trace("Enter clang_format::make_suggestions()");
+    auto lines = line_index{source};
+
+    // The rows of original lines changed by a replacement. A replacement
+    // which removes up to the start of a line doesn't change that line.
+    auto changed_rows = [&](const replacement_t &replacement) {
+      auto offset = static_cast<std::size_t>(replacement.offset);
+      auto end    = offset + static_cast<std::size_t>(replacement.length);
+      auto first  = lines.position(offset);
+      auto last   = lines.position(end);
+      throw_unless(first && last,
+                   std::format("invalid replacement at offset {} with length {}",
+                               replacement.offset,
+                               replacement.length));
+      auto last_row = last->first;
+      if (end > offset && last->second == 1) {
+        last_row = std::max(first->first, last_row - 1);
+      }
+      return std::pair{first->first, last_row};
+    };
+
+    auto suggestions = std::vector<suggestion_t>{};
+    auto begin       = std::size_t{0};
+    while (begin < replacements.size()) {
+      auto [first_row, last_row] = changed_rows(replacements[begin]);
+      auto end                   = begin + 1;
+      for (; end < replacements.size(); ++end) {
+        auto [next_first, next_last] = changed_rows(replacements[end]);
+        if (next_first > last_row) {
+          break;
+        }
+        last_row = std::max(last_row, next_last);
+      }
+
+      auto range_begin = *lines.line_start(first_row);
+      auto range_end   = lines.line_start(last_row + 1).value_or(source.size());
+      auto group       = std::span{replacements}.subspan(begin, end - begin);
+      suggestions.push_back(
+        {.first_row = first_row,
+         .last_row  = last_row,
+         .text      = apply_replacements(
+           source.substr(range_begin, range_end - range_begin), group, range_begin)});
+      begin = end;
+    }
+    return suggestions;
+  }
+
+} // namespace linter::tool::clang_format
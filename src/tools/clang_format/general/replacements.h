@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tools/clang_format/general/result.h"
+
+namespace linter::tool::clang_format {
+  /// Parse the replacements xml printed by clang-format
+  /// --output-replacements-xml. The data may be one of several documents in
+  /// the same output, so it needn't be null terminated. Throw if malformed.
+  auto parse_replacements_xml(std::string_view data) -> replacements_t;
+
+  /// Apply the replacements to the source code. The replacements of
+  /// clang-format are sorted by offset and never overlap with each other.
+  /// Their offsets are relative to base_offset, the offset of the source code
+  /// in the whole file. Throw if a replacement is out of the source code.
+  auto apply_replacements(std::string_view source,
+                          std::span<const replacement_t> replacements,
+                          std::size_t base_offset = 0) -> std::string;
+
+  /// The formatted text of the lines [first_row, last_row] of a file. Rows
+  /// start from 1.
+  struct suggestion_t {
+    std::size_t first_row = 0;
+    std::size_t last_row  = 0;
+    std::string text;
+  };
+
+  /// Convert the replacements of a file into suggestions of whole lines.
+  /// Replacements changing the same line are merged into one suggestion.
+  auto make_suggestions(std::string_view source, const replacements_t &replacements)
+    -> std::vector<suggestion_t>;
+
+} // namespace linter::tool::clang_format
@@ -15,7 +15,12 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
@@ -24,9 +29,12 @@
 #include "github/utils.h"
 #include "tools/base_reporter.h"
 #include "tools/clang_format/general/option.h"
+#include "tools/clang_format/general/replacements.h"
 #include "tools/clang_format/general/result.h"
+#include "tools/scheduler.h"
 #include "utils/env_manager.h"
 #include "utils/git_utils.h"
+#include "utils/repo_pool.h"
 #include "utils/util.h"
 
 namespace linter::tool::clang_format {
@@ -38,13 +46,20 @@ namespace linter::tool::clang_format {
       , result(std::move(res)) {
     }
 
-    auto make_brief_result() -> std::string {
+    // Shared by the issue comment and the step summary, so it's made once.
+    auto make_brief_result() -> const std::string & {
+      if (brief_result) {
+        return *brief_result;
+      }
       auto content = ""s;
       for (const auto &[name, failed]: result.fails) {
         auto one  = std::format("- {}\n", name);
         content  += one;
       }
-      return content;
+      for (const auto &file: result.timed_out) {
+        content += std::format("- {} timed out\n", file);
+      }
+      return brief_result.emplace(std::move(content));
     }
 
     auto make_issue_comment([[maybe_unused]] const runtime_context &context)
@@ -57,80 +72,71 @@ namespace linter::tool::clang_format {
       return make_brief_result();
     }
 
-    static auto convert_row_number_into_patch_position(int row_number, git_patch &patch)
-      -> std::optional<std::size_t> {
-      const auto num_hunk = git::patch::num_hunks(patch);
-      auto pos            = 0U;
-      for (auto hunk_idx = 0; hunk_idx < num_hunk; ++hunk_idx) {
-        auto [hunk, num_lines] = git::patch::get_hunk(patch, hunk_idx);
-        if (!github::is_row_in_hunk(hunk, row_number)) {
-          pos += num_lines;
-        }
-        return pos + row_number - hunk.new_start + 1;
+    // Suggestions are converted from the replacements directly, so neither
+    // the formatted source code nor a diff of it is needed.
+    static void make_per_file_review_comment(const runtime_context &context,
+                                             const std::string &file,
+                                             const per_file_result &format_result,
+                                             github::review_comments &comments) {
+      // The blob is owned by the repository of the lease, so it's released
+      // before the lease.
+      auto handle        = std::optional<git::repo_pool::lease>{};
+      auto before_format = git::blob::blob_view{};
+      if (context.repos != nullptr) {
+        handle.emplace(context.repos->acquire());
+        before_format =
+          git::blob::get_view((*handle)->repo.get(), (*handle)->source_tree.get(), file);
+      } else {
+        before_format.content = context.source_contents.at(file);
       }
-      return std::nullopt;
-    }
 
-    // The hunk splited rule must be same as github.
-    static void make_per_hunk_review_comment(
-      const runtime_context &context,
-      const std::string &file,
-      git::patch_raw_ptr patch,
-      std::size_t patch_idx,
-      github::review_comments &comments) {
-      // The diff patch of source revision to target revision of checking file.
-      const auto &patch_user = context.patches.at(file);
-
-      const auto [hunk, hunk_line_num] = git::patch::get_hunk(patch, patch_idx);
-      const auto row                   = hunk.old_start;
-      auto pos                         = convert_row_number_into_patch_position(row, *patch_user);
-      if (pos) {
-        auto comment     = github::review_comment{};
-        comment.path     = file;
-        comment.position = *pos;
-
-        auto temp    = git::patch::get_lines_in_hunk(patch, patch_idx);
-        comment.body = git::patch::get_source_lines_in_hunk(*patch, patch_idx)
-                     | std::views::join_with(' ')
-                     | std::ranges::to<std::string>();
+      // The hunks of the diff patch of source revision to target revision of
+      // checking file.
+      const auto &hunks = context.patches.hunks(file);
+      for (auto &suggestion: make_suggestions(before_format.content, format_result.replacements)) {
+        auto comment = github::review_comment{};
+        comment.path = file;
+        comment.body = std::move(suggestion.text);
+        if (suggestion.first_row == suggestion.last_row) {
+          auto pos = hunks.position(suggestion.first_row);
+          if (!pos) {
+            continue;
+          }
+          comment.position = *pos;
+        } else {
+          // A suggestion replaces all the commented lines, so the lines of a
+          // group are commented on together, which must be in one hunk.
+          if (!hunks.contains(suggestion.first_row, suggestion.last_row)) {
+            continue;
+          }
+          comment.start_line = suggestion.first_row;
+          comment.start_side = "RIGHT";
+          comment.line       = suggestion.last_row;
+          comment.side       = "RIGHT";
+        }
         comments.emplace_back(std::move(comment));
       }
     }
 
-    static auto get_suggestion_patch(
-      const runtime_context &context,
-      const std::string &file,
-      const per_file_result &format_result) {
-      // Compare original content with formatted result of a file.
-      const auto before_format =
-        git::blob::get_raw_content(context.repo.get(), context.source_commit.get(), file);
-      auto opts          = git::diff_options{};
-      opts.context_lines = 0;
-      git::diff::init_option(&opts);
-      return git::patch::create_from_buffers(
-        before_format,
-        file,
-        format_result.formatted_source_code,
-        file,
-        opts);
-    }
-
-    static void make_per_file_review_comment(
-      const runtime_context &context,
-      const std::string &file,
-      const per_file_result &format_result,
-      github::review_comments &comments) {
-      auto patch_suggestion = get_suggestion_patch(context, file, format_result);
-      auto num_hunks        = git::patch::num_hunks(patch_suggestion.get());
-      for (int hunk_idx = 0; hunk_idx < num_hunks; ++hunk_idx) {
-        make_per_hunk_review_comment(context, file, patch_suggestion.get(), hunk_idx, comments);
+    /// Suggestions of files are made concurrently, since a formatter upgrade
+    /// may fail thousands of files. Comments keep the order of files.
+    auto make_review_comment(const runtime_context &context) -> github::review_comments override {
+      auto per_file = std::vector<github::review_comments>(result.fails.size());
+      auto tasks    = std::vector<tool_task>{};
+      auto idx      = std::size_t{0};
+      for (const auto &[file, format_result]: result.fails) {
+        tasks.push_back({.cost = format_result.replacements.size(),
+                         .name = std::format("suggest {}", file),
+                         .run  = [&, &comments = per_file[idx]] {
+                           make_per_file_review_comment(context, file, format_result, comments);
+                         }});
+        ++idx;
       }
-    }
+      run_tasks(std::move(tasks), std::max(1U, std::thread::hardware_concurrency()));
 
-    auto make_review_comment(const runtime_context &context) -> github::review_comments override {
       auto comments = github::review_comments{};
-      for (const auto &[file, format_result]: result.fails) {
-        make_per_file_review_comment(context, file, format_result, comments);
+      for (auto &file_comments: per_file) {
+        std::ranges::move(file_comments, std::back_inserter(comments));
       }
       return comments;
     }
@@ -140,6 +146,7 @@ namespace linter::tool::clang_format {
       auto file   = std::fstream{output, std::ios::app};
       throw_unless(file.is_open(), "error to open output file to write");
       file << std::format("clang_format_failed_number={}\n", result.fails.size());
+      file << std::format("clang_format_timed_out_number={}\n", result.timed_out.size());
     }
 
     auto get_brief_result() -> std::tuple<bool, std::size_t, std::size_t, std::size_t> override {
@@ -155,8 +162,17 @@ namespace linter::tool::clang_format {
       return parts.back();
     }
 
+    auto reviewed_files() -> std::vector<std::string> override {
+      return result.fails | std::views::keys | std::ranges::to<std::vector<std::string>>();
+    }
+
+    auto read_files() -> std::vector<std::string> override {
+      return reviewed_files();
+    }
+
     option_t option;
     result_t result;
+    std::optional<std::string> brief_result;
   };
 
 } // namespace linter::tool::clang_format
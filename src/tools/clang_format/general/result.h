@@ -17,6 +17,8 @@
 
 #include <vector>
 
+#include <nlohmann/json.hpp>
+
 #include "tools/base_result.h"
 
 namespace linter::tool::clang_format {
@@ -24,6 +26,11 @@ namespace linter::tool::clang_format {
     int offset;
     int length;
     std::string data;
+
+    // The position of offset in the original source code. Start from 1, 0
+    // means unknown.
+    int row = 0;
+    int col = 0;
   };
 
   using replacements_t = std::vector<replacement_t>;
@@ -34,4 +41,14 @@ namespace linter::tool::clang_format {
   };
 
   using result_t = multi_files_result_base<per_file_result>;
+
+  // Used by the result cache.
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(replacement_t, offset, length, data, row, col)
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(per_file_result,
+                                     passed,
+                                     file_path,
+                                     tool_stdout,
+                                     tool_stderr,
+                                     replacements,
+                                     formatted_source_code)
 } // namespace linter::tool::clang_format
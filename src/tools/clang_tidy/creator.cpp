@@ -46,6 +46,29 @@ namespace linter::tool::clang_tidy {
     (clang_tidy_database,              value<string>(),    "Same as clang-tidy -p option")
     (clang_tidy_header_filter,         value<string>(),    "Same as clang-tidy header_filter option")
     (clang_tidy_line_filter,           value<string>(),    "Same as clang-tidy line_filter option")
+    (clang_tidy_iregex,                value<string>(),    "Set the case insensitive regex of files to be checked by "
+                                                           "clang-tidy. Default to C/C++ source and header files")
+    (clang_tidy_jobs,                  value<uint32_t>(),  "Set the number of files checked by clang-tidy concurrently. "
+                                                           "Default to the number of hardware threads")
+    (clang_tidy_batch_size,            value<uint32_t>(),  "Set the maximum number of files passed to one clang-tidy "
+                                                           "invocation. Default to 1")
+    (clang_tidy_auto_line_filter,      value<bool>(),      "Generate clang-tidy line_filter option from the added lines "
+                                                           "of changed files, so only diagnostics of changed lines are "
+                                                           "reported. You are't allowed to specify both this option "
+                                                           "and clang-tidy-line-filter to avoid ambiguous")
+    (clang_tidy_export_fixes,          value<bool>(),      "Read diagnostics from the YAML file exported by clang-tidy "
+                                                           "export_fixes option rather than the stdout of clang-tidy")
+    (clang_tidy_check_dependents,      value<bool>(),      "Also check the translation units of the compilation database "
+                                                           "which include changed headers directly or transitively. "
+                                                           "Requires clang-tidy-database")
+    (clang_tidy_max_output_size,       value<uint32_t>(),  "Set the maximum bytes of clang-tidy stdout kept in results "
+                                                           "for debugging. Default to 65536")
+    (clang_tidy_baseline,              value<bool>(),      "Only report diagnostics introduced by source revision. Each "
+                                                           "changed file is checked in target revision as well, and "
+                                                           "the diagnostics existing there are dropped")
+    (clang_tidy_timeout,               value<uint32_t>(),  "Set the seconds each clang-tidy invocation may take. The files "
+                                                           "of an invocation running longer are killed and reported as "
+                                                           "timed out. Default to 0, unlimited")
   ;
     // clang-format on
   }
@@ -63,22 +86,18 @@ namespace linter::tool::clang_tidy {
     if (variables.contains(enable_clang_tidy_fastly_exit)) {
       option.enabled_fastly_exit = variables[enable_clang_tidy_fastly_exit].as<bool>();
     }
+    // The binary is resolved by the tool when it has files to check.
     if (variables.contains(clang_tidy_version)) {
       option.version = variables[clang_tidy_version].as<std::string>();
       throw_if(variables.contains(clang_tidy_binary),
                "specify both clang-tidy-binary and clang-tidy-version is ambiguous");
-      option.binary = find_clang_tool("clang-tidy", option.version);
+      option.binary = std::format("clang-tidy-{}", option.version);
     } else if (variables.contains(clang_tidy_binary)) {
       throw_if(variables.contains(clang_tidy_version),
                "specify both clang-tidy-binary and clang-tidy-version is ambiguous");
-      option.binary               = variables[clang_tidy_binary].as<std::string>();
-      auto [ec, std_out, std_err] = shell::which(option.binary);
-      throw_unless(ec == 0, std::format("Can't find given clang_tidy_binary: {}", option.binary));
-      spdlog::info("The clang-tidy executable path: {}", option.binary);
+      option.binary = variables[clang_tidy_binary].as<std::string>();
     } else {
-      auto [ec, std_out, std_err] = shell::which("clang-tidy");
-      throw_unless(ec == 0, "Can't find clang-tidy");
-      option.binary = std_out;
+      option.binary = "clang-tidy";
     }
 
     if (variables.contains(clang_tidy_allow_no_checks)) {
@@ -108,9 +127,44 @@ namespace linter::tool::clang_tidy {
     if (variables.contains(clang_tidy_iregex)) {
       option.source_filter_iregex = variables[clang_tidy_iregex].as<std::string>();
     }
+    if (variables.contains(clang_tidy_jobs)) {
+      option.jobs = variables[clang_tidy_jobs].as<std::uint32_t>();
+      throw_if(option.jobs == 0, "clang-tidy-jobs must be greater than 0");
+    }
+    if (variables.contains(clang_tidy_batch_size)) {
+      option.batch_size = variables[clang_tidy_batch_size].as<std::uint32_t>();
+      throw_if(option.batch_size == 0, "clang-tidy-batch-size must be greater than 0");
+    }
+    if (variables.contains(clang_tidy_auto_line_filter)) {
+      option.auto_line_filter = variables[clang_tidy_auto_line_filter].as<bool>();
+      throw_if(option.auto_line_filter && !option.line_filter.empty(),
+               "specify both clang-tidy-auto-line-filter and clang-tidy-line-filter is ambiguous");
+    }
+    if (variables.contains(clang_tidy_export_fixes)) {
+      option.export_fixes = variables[clang_tidy_export_fixes].as<bool>();
+    }
+    if (variables.contains(clang_tidy_check_dependents)) {
+      option.check_dependents = variables[clang_tidy_check_dependents].as<bool>();
+      throw_if(option.check_dependents && option.database.empty(),
+               "clang-tidy-check-dependents requires clang-tidy-database");
+    }
+    if (variables.contains(clang_tidy_max_output_size)) {
+      option.max_output_size = variables[clang_tidy_max_output_size].as<std::uint32_t>();
+    }
+    if (variables.contains(clang_tidy_baseline)) {
+      option.baseline = variables[clang_tidy_baseline].as<bool>();
+    }
+    if (variables.contains(clang_tidy_timeout)) {
+      option.timeout = variables[clang_tidy_timeout].as<std::uint32_t>();
+    }
   }
 
   auto creator::create_tool(const runtime_context &context) -> tool_base_ptr {
+    // Only the staged lines are reported by a pre-commit hook, unless lines
+    // are filtered by users.
+    if (context.staged && option.line_filter.empty()) {
+      option.auto_line_filter = true;
+    }
     auto version = option.version;
     auto tool    = tool_base_ptr{};
     if (version == version_18_1_3) {
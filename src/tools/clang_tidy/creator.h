@@ -36,6 +36,14 @@ namespace linter::tool::clang_tidy {
   constexpr auto clang_tidy_header_filter        = "clang-tidy-header-filter";
   constexpr auto clang_tidy_line_filter          = "clang-tidy-line-filter";
   constexpr auto clang_tidy_iregex               = "clang-tidy-iregex";
+  constexpr auto clang_tidy_jobs                 = "clang-tidy-jobs";
+  constexpr auto clang_tidy_batch_size           = "clang-tidy-batch-size";
+  constexpr auto clang_tidy_auto_line_filter     = "clang-tidy-auto-line-filter";
+  constexpr auto clang_tidy_export_fixes         = "clang-tidy-export-fixes";
+  constexpr auto clang_tidy_check_dependents     = "clang-tidy-check-dependents";
+  constexpr auto clang_tidy_max_output_size      = "clang-tidy-max-output-size";
+  constexpr auto clang_tidy_baseline             = "clang-tidy-baseline";
+  constexpr auto clang_tidy_timeout              = "clang-tidy-timeout";
 
   struct creator : public creator_base {
     void register_option(program_options::options_description &desc) const override;
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/clang_tidy/general/baseline.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/util.h"
+
+namespace linter::tool::clang_tidy {
+  namespace {
+    // The first line of details is the source line of a diagnostic. It's empty
+    // if diagnostics are read from exported fixes.
+    auto source_line(std::string_view details) -> std::string_view {
+      return trim(details.substr(0, details.find('\n')));
+    }
+
+    // Rows mapped to target revision may be off inside changed hunks.
+    constexpr auto max_row_distance = std::size_t{3};
+
+    auto make_key(const diagnostic &diag) -> std::string {
+      return std::format("{}\n{}\n{}",
+                         diag.header.diagnostic_type,
+                         diag.header.brief,
+                         source_line(diag.details));
+    }
+  } // namespace
+
+  auto remove_baseline(diagnostics diags, const diagnostics &baseline, const row_mapper &to_target)
+    -> diagnostics {
+    // The rows of the unmatched baseline diagnostics by key.
+    auto rows = std::unordered_map<std::string, std::vector<std::size_t>>{};
+    for (const auto &diag: baseline) {
+      rows[make_key(diag)].push_back(diag.header.row_idx);
+    }
+
+    auto ret = diagnostics{};
+    for (auto &diag: diags) {
+      auto iter = rows.find(make_key(diag));
+      if (iter == rows.end() || iter->second.empty()) {
+        ret.push_back(std::move(diag));
+        continue;
+      }
+      auto &candidates = iter->second;
+      if (!source_line(diag.details).empty()) {
+        candidates.pop_back();
+        continue;
+      }
+      auto row      = to_target ? to_target(diag.header.row_idx) : diag.header.row_idx;
+      auto distance = [&](std::size_t candidate) {
+        return candidate > row ? candidate - row : row - candidate;
+      };
+      auto nearest = std::ranges::min_element(candidates, {}, distance);
+      if (distance(*nearest) > max_row_distance) {
+        ret.push_back(std::move(diag));
+        continue;
+      }
+      candidates.erase(nearest);
+    }
+    return ret;
+  }
+
+} // namespace linter::tool::clang_tidy
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include "tools/clang_tidy/general/result.h"
+
+namespace linter::tool::clang_tidy {
+  /// Map a row of the checked file to the row of the same line in target
+  /// revision, e.g. by the hunks of the diff.
+  using row_mapper = std::function<std::size_t(std::size_t row)>;
+
+  /// Remove the diagnostics which already exist in the baseline, i.e. the
+  /// diagnostics of the same file in target revision. Rows are shifted by the
+  /// changes above them, so diagnostics are matched by the diagnostic type,
+  /// the brief and the source line they point to instead. Diagnostics read
+  /// from exported fixes have no source line, they are matched by the type,
+  /// the brief and the row mapped to target revision, which may be a few rows
+  /// off. Rows are kept as they are if no mapper is given. Each diagnostic of
+  /// the baseline matches at most one diagnostic.
+  auto remove_baseline(diagnostics diags,
+                       const diagnostics &baseline,
+                       const row_mapper &to_target = {}) -> diagnostics;
+
+} // namespace linter::tool::clang_tidy
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/clang_tidy/general/compile_database.h"
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <ranges>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+#include "utils/util.h"
+
+namespace linter::tool::clang_tidy {
+  using namespace std::string_view_literals;
+
+  namespace {
+    // Split a command line the way a POSIX shell does for the common cases:
+    // whitespace separated, with single quotes, double quotes and backslash.
+    auto split_command(std::string_view command) -> std::vector<std::string> {
+      auto args   = std::vector<std::string>{};
+      auto arg    = std::string{};
+      auto in_arg = false;
+      auto quote  = '\0';
+      for (auto idx = std::size_t{0}; idx < command.size(); ++idx) {
+        auto chr = command[idx];
+        if (quote == '\'') {
+          if (chr == '\'') {
+            quote = '\0';
+          } else {
+            arg += chr;
+          }
+        } else if (chr == '\\' && idx + 1 < command.size()) {
+          arg    += command[++idx];
+          in_arg  = true;
+        } else if (quote == '"') {
+          if (chr == '"') {
+            quote = '\0';
+          } else {
+            arg += chr;
+          }
+        } else if (chr == '\'' || chr == '"') {
+          quote  = chr;
+          in_arg = true;
+        } else if (std::isspace(static_cast<unsigned char>(chr)) != 0) {
+          if (in_arg) {
+            args.push_back(std::move(arg));
+            arg.clear();
+            in_arg = false;
+          }
+        } else {
+          arg    += chr;
+          in_arg  = true;
+        }
+      }
+      if (in_arg) {
+        args.push_back(std::move(arg));
+      }
+      return args;
+    }
+
+    auto resolve(const std::filesystem::path &dir, std::string_view path) -> std::filesystem::path {
+      auto ret = std::filesystem::path{path};
+      if (ret.is_relative()) {
+        ret = dir / ret;
+      }
+      return ret.lexically_normal();
+    }
+
+    auto parse_command(const nlohmann::json &entry) -> compile_command {
+      auto dir  = std::filesystem::path{entry.value("directory", std::string{})};
+      auto args = std::vector<std::string>{};
+      if (entry.contains("arguments")) {
+        args = entry["arguments"].get<std::vector<std::string>>();
+      } else {
+        args = split_command(entry.value("command", std::string{}));
+      }
+
+      auto ret         = compile_command{};
+      ret.file         = resolve(dir, entry.at("file").get<std::string>());
+      auto system_dirs = std::vector<std::filesystem::path>{};
+      auto after_dirs  = std::vector<std::filesystem::path>{};
+      auto flags       = {
+        std::pair{"-iquote"sv,    &ret.quote_dirs  },
+        std::pair{"-isystem"sv,   &system_dirs     },
+        std::pair{"-idirafter"sv, &after_dirs      },
+        std::pair{"-I"sv,         &ret.include_dirs}
+      };
+      for (auto idx = std::size_t{0}; idx < args.size(); ++idx) {
+        auto arg = std::string_view{args[idx]};
+        for (const auto &[flag, target]: flags) {
+          if (!arg.starts_with(flag)) {
+            continue;
+          }
+          // Both "-Idir" and "-I dir" are accepted by compilers.
+          if (arg.size() > flag.size()) {
+            target->push_back(resolve(dir, arg.substr(flag.size())));
+          } else if (idx + 1 < args.size()) {
+            target->push_back(resolve(dir, args[++idx]));
+          }
+          break;
+        }
+      }
+
+      // The same order as searched by compilers.
+      ret.include_dirs.insert(ret.include_dirs.end(), system_dirs.begin(), system_dirs.end());
+      ret.include_dirs.insert(ret.include_dirs.end(), after_dirs.begin(), after_dirs.end());
+      return ret;
+    }
+
+    auto skip_spaces(std::string_view line) -> std::string_view {
+      auto pos = line.find_first_not_of(" \t");
+      return pos == std::string_view::npos ? std::string_view{} : line.substr(pos);
+    }
+
+    auto parse_include_line(std::string_view line) -> std::optional<include_directive> {
+      line = skip_spaces(line);
+      if (!line.starts_with('#')) {
+        return std::nullopt;
+      }
+      line = skip_spaces(line.substr(1));
+      // include_next and import are rarely used, but they're includes as well.
+      for (auto keyword: {"include_next"sv, "include"sv, "import"sv}) {
+        if (!line.starts_with(keyword)) {
+          continue;
+        }
+        line = skip_spaces(line.substr(keyword.size()));
+        if (line.empty() || (line.front() != '"' && line.front() != '<')) {
+          // Includes by macros can't be resolved without preprocessing.
+          return std::nullopt;
+        }
+        auto quoted = line.front() == '"';
+        auto end    = line.find(quoted ? '"' : '>', 1);
+        if (end == std::string_view::npos) {
+          return std::nullopt;
+        }
+        return include_directive{.name = std::string{line.substr(1, end - 1)}, .quoted = quoted};
+      }
+      return std::nullopt;
+    }
+
+    auto is_under(const std::filesystem::path &root_dir, const std::filesystem::path &path)
+      -> bool {
+      auto relative = path.lexically_relative(root_dir);
+      return !relative.empty() && *relative.begin() != "..";
+    }
+
+    // Translation units with the same search directories resolve includes
+    // the same, which is usual since most of them share the same flags.
+    auto make_search_key(const compile_command &command) -> std::string {
+      auto key = std::string{};
+      for (const auto *dirs: {&command.quote_dirs, &command.include_dirs}) {
+        for (const auto &dir: *dirs) {
+          key += dir.string();
+          key += '\n';
+        }
+        key += '\n';
+      }
+      return key;
+    }
+
+    auto find_header(const compile_command &command,
+                     const std::filesystem::path &includer_dir,
+                     const include_directive &directive) -> std::optional<std::filesystem::path> {
+      auto found = [&](const std::filesystem::path &dir) -> std::optional<std::filesystem::path> {
+        auto path = (dir / directive.name).lexically_normal();
+        auto ec   = std::error_code{};
+        if (std::filesystem::is_regular_file(path, ec)) {
+          return path;
+        }
+        return std::nullopt;
+      };
+
+      if (directive.quoted) {
+        if (auto path = found(includer_dir)) {
+          return path;
+        }
+        for (const auto &dir: command.quote_dirs) {
+          if (auto path = found(dir)) {
+            return path;
+          }
+        }
+      }
+      for (const auto &dir: command.include_dirs) {
+        if (auto path = found(dir)) {
+          return path;
+        }
+      }
+      return std::nullopt;
+    }
+  } // namespace
+
+  auto parse_compile_commands(std::string_view content) -> std::vector<compile_command> {
+    auto database = nlohmann::json::parse(content, nullptr, false);
+    throw_if(database.is_discarded() || !database.is_array(),
+             "The compilation database isn't a json array");
+    auto commands = std::vector<compile_command>{};
+    commands.reserve(database.size());
+    for (const auto &entry: database) {
+      commands.push_back(parse_command(entry));
+    }
+    return commands;
+  }
+
+  auto make_copy_database(std::string_view content,
+                          const std::filesystem::path &file,
+                          const std::filesystem::path &copy) -> std::string {
+    auto database = content.empty() ? nlohmann::json::array()
+                                    : nlohmann::json::parse(content, nullptr, false);
+    throw_if(database.is_discarded() || !database.is_array(),
+             "The compilation database isn't a json array");
+
+    // The number of leading path components shared by two paths.
+    auto common = [](const std::filesystem::path &lhs, const std::filesystem::path &rhs) {
+      auto [lhs_end, rhs_end] = std::ranges::mismatch(lhs, rhs);
+      return std::distance(lhs.begin(), lhs_end);
+    };
+    const auto *nearest = static_cast<const nlohmann::json *>(nullptr);
+    auto nearest_common = std::ptrdiff_t{-1};
+    for (const auto &entry: database) {
+      auto dir  = std::filesystem::path{entry.value("directory", std::string{})};
+      auto path = resolve(dir, entry.value("file", std::string{}));
+      if (path == file) {
+        nearest = &entry;
+        break;
+      }
+      if (auto num = common(path, file); num > nearest_common) {
+        nearest        = &entry;
+        nearest_common = num;
+      }
+    }
+
+    auto directory = file.parent_path().string();
+    auto args      = std::vector<std::string>{"clang-tool"};
+    if (nearest != nullptr) {
+      directory = nearest->value("directory", std::string{});
+      args      = nearest->contains("arguments")
+                  ? (*nearest)["arguments"].get<std::vector<std::string>>()
+                  : split_command(nearest->value("command", std::string{}));
+      auto source = resolve(directory, nearest->value("file", std::string{}));
+      std::erase_if(args, [&](const std::string &arg) {
+        return !arg.starts_with('-') && resolve(directory, arg) == source;
+      });
+    }
+    args.insert(args.begin() + std::min<std::ptrdiff_t>(1, std::ssize(args)),
+                {"-iquote", file.parent_path().string()});
+    args.push_back(copy.string());
+
+    auto entry = nlohmann::json{
+      {"directory", directory    },
+      {"arguments", args         },
+      {"file",      copy.string()}
+    };
+    return nlohmann::json::array({std::move(entry)}).dump();
+  }
+
+  auto parse_includes(std::string_view content) -> std::vector<include_directive> {
+    auto directives = std::vector<include_directive>{};
+    for (auto line: content | std::views::split('\n')) {
+      if (auto directive = parse_include_line(std::string_view{line.begin(), line.end()})) {
+        directives.push_back(std::move(*directive));
+      }
+    }
+    return directives;
+  }
+
+  include_graph::include_graph(std::vector<compile_command> commands,
+                               const std::filesystem::path &root_dir,
+                               const include_reader &read_includes)
+    : commands_(std::move(commands)) {
+    auto root = root_dir.lexically_normal();
+
+    // Each file is read once no matter how many translation units include it.
+    auto directives = std::unordered_map<std::string, std::vector<include_directive>>{};
+    auto get_directives = [&](const std::filesystem::path &file)
+      -> const std::vector<include_directive> & {
+      auto [iter, inserted] = directives.try_emplace(file.string());
+      if (inserted) {
+        iter->second = read_includes(file).value_or(std::vector<include_directive>{});
+      }
+      return iter->second;
+    };
+
+    // The resolved path of each include, shared by translation units with the
+    // same search directories. Quoted includes depend on the includer too.
+    using resolved_map = std::unordered_map<std::string, std::optional<std::filesystem::path>>;
+    auto resolved      = std::unordered_map<std::string, resolved_map>{};
+
+    for (auto idx = std::size_t{0}; idx < commands_.size(); ++idx) {
+      const auto &command = commands_[idx];
+      auto &headers       = resolved[make_search_key(command)];
+      auto visited        = std::unordered_set<std::string>{command.file.string()};
+      auto pending        = std::vector<std::filesystem::path>{command.file};
+      while (!pending.empty()) {
+        auto file = std::move(pending.back());
+        pending.pop_back();
+        auto includer_dir = file.parent_path();
+        for (const auto &directive: get_directives(file)) {
+          auto key = std::format("{}\n{}",
+                                 directive.quoted ? includer_dir.string() : std::string{},
+                                 directive.name);
+          auto [iter, inserted] = headers.try_emplace(std::move(key));
+          if (inserted) {
+            iter->second = find_header(command, includer_dir, directive);
+          }
+          const auto &header = iter->second;
+          if (!header || !is_under(root, *header) || !visited.insert(header->string()).second) {
+            continue;
+          }
+          dependents_[header->string()].push_back(idx);
+          pending.push_back(*header);
+        }
+      }
+    }
+  }
+
+  auto include_graph::affected_units(std::span<const std::filesystem::path> headers) const
+    -> std::vector<std::filesystem::path> {
+    auto indices = std::vector<std::size_t>{};
+    for (const auto &header: headers) {
+      auto iter = dependents_.find(header.lexically_normal().string());
+      if (iter != dependents_.end()) {
+        indices.insert(indices.end(), iter->second.begin(), iter->second.end());
+      }
+    }
+    std::ranges::sort(indices);
+    auto [first, last] = std::ranges::unique(indices);
+    indices.erase(first, last);
+    return indices
+         | std::views::transform([&](auto idx) { return commands_[idx].file; })
+         | std::ranges::to<std::vector>();
+  }
+
+  auto include_graph::num_units() const -> std::size_t {
+    return commands_.size();
+  }
+
+} // namespace linter::tool::clang_tidy
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace linter::tool::clang_tidy {
+  /// The part of a compilation database entry needed to find the headers
+  /// included by a translation unit. All paths are absolute and normalized.
+  struct compile_command {
+    std::filesystem::path file;
+    /// Directories of -iquote, only searched by quoted includes.
+    std::vector<std::filesystem::path> quote_dirs;
+    /// Directories of -I, -isystem and -idirafter in the order of searching.
+    std::vector<std::filesystem::path> include_dirs;
+  };
+
+  /// Parse the content of compile_commands.json. Relative paths are resolved
+  /// by the directory of each entry.
+  auto parse_compile_commands(std::string_view content) -> std::vector<compile_command>;
+
+  /// Make a compilation database of one entry to check a copy of a file written
+  /// elsewhere, e.g. the file of another revision. The copy is compiled by the
+  /// command of the file in the given database content, or by that of the
+  /// nearest file by directory if the file isn't in it. The directory of the
+  /// file is searched for quoted includes first, as it is for the file itself.
+  /// An empty content means no database, the copy is compiled without flags.
+  auto make_copy_database(std::string_view content,
+                          const std::filesystem::path &file,
+                          const std::filesystem::path &copy) -> std::string;
+
+  struct include_directive {
+    std::string name;
+    /// #include "name" rather than #include <name>.
+    bool quoted = false;
+  };
+
+  /// Scan the #include directives of a source file. Conditional compilation
+  /// isn't evaluated, so all includes of all branches are returned.
+  auto parse_includes(std::string_view content) -> std::vector<include_directive>;
+
+  /// The reverse include dependencies of the translation units of a
+  /// compilation database. Only headers under the root directory are followed,
+  /// since headers outside of repository are never changed by a pull request.
+  class include_graph {
+  public:
+    /// Read the include directives of a file, std::nullopt if it can't be read.
+    using include_reader =
+      std::function<std::optional<std::vector<include_directive>>(const std::filesystem::path &)>;
+
+    include_graph(std::vector<compile_command> commands,
+                  const std::filesystem::path &root_dir,
+                  const include_reader &read_includes);
+
+    /// The translation units which include any of the given headers directly
+    /// or transitively, in the order of the compilation database.
+    [[nodiscard]] auto affected_units(std::span<const std::filesystem::path> headers) const
+      -> std::vector<std::filesystem::path>;
+
+    [[nodiscard]] auto num_units() const -> std::size_t;
+
+  private:
+    std::vector<compile_command> commands_;
+    /// The indices of translation units including each header.
+    std::unordered_map<std::string, std::vector<std::size_t>> dependents_;
+  };
+
+} // namespace linter::tool::clang_tidy
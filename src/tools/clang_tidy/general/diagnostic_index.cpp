@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/clang_tidy/general/diagnostic_index.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace linter::tool::clang_tidy {
+  auto diagnostic_index::key_hash::operator()(const key &value) const noexcept -> std::size_t {
+    auto hash    = std::hash<std::string_view>{}(value.file_name);
+    auto combine = [&](std::size_t other) {
+      hash ^= other + 0x9e3779b97f4a7c15ULL + (hash << 6U) + (hash >> 2U);
+    };
+    combine(std::hash<std::uint32_t>{}(value.row_idx));
+    combine(std::hash<std::uint32_t>{}(value.col_idx));
+    combine(std::hash<std::string_view>{}(value.diagnostic_type));
+    return hash;
+  }
+
+  auto diagnostic_index::drop_reported(diagnostics &diags, diagnostics *dropped) -> std::size_t {
+    auto kept = diags.begin();
+    for (auto iter = diags.begin(); iter != diags.end(); ++iter) {
+      const auto &header = iter->header;
+      auto id            = key{.file_name       = header.file_name,
+                               .row_idx         = header.row_idx,
+                               .col_idx         = header.col_idx,
+                               .diagnostic_type = header.diagnostic_type};
+      if (!reported_.insert(id).second) {
+        if (dropped != nullptr) {
+          dropped->push_back(std::move(*iter));
+        }
+        continue;
+      }
+      if (kept != iter) {
+        *kept = std::move(*iter);
+      }
+      ++kept;
+    }
+    auto num_dropped = static_cast<std::size_t>(std::distance(kept, diags.end()));
+    diags.erase(kept, diags.end());
+    return num_dropped;
+  }
+
+  auto deduplicate_kept(std::span<std::optional<per_file_result>> results,
+                        std::span<diagnostics> dropped,
+                        std::size_t last) -> diagnostic_index {
+    auto index = diagnostic_index{};
+    for (auto idx = std::size_t{0}; idx <= last && idx < results.size(); ++idx) {
+      if (!results[idx]) {
+        continue;
+      }
+      auto &diags = results[idx]->diags;
+      std::ranges::move(dropped[idx], std::back_inserter(diags));
+      dropped[idx].clear();
+      index.drop_reported(diags);
+    }
+    return index;
+  }
+
+} // namespace linter::tool::clang_tidy
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_set>
+
+#include "tools/clang_tidy/general/result.h"
+
+namespace linter::tool::clang_tidy {
+  /// The diagnostics reported so far in one run. clang-tidy reports the
+  /// diagnostics of a header once per translation unit including it, so they
+  /// are kept in the result of the first translation unit checked only.
+  class diagnostic_index {
+  public:
+    /// Remove the diagnostics which were reported before, keyed by the file,
+    /// row, column and diagnostic type, and remember the others. The removed
+    /// ones are appended to dropped if given. Return the number of removed
+    /// diagnostics.
+    auto drop_reported(diagnostics &diags, diagnostics *dropped = nullptr) -> std::size_t;
+
+    [[nodiscard]] auto size() const -> std::size_t {
+      return reported_.size();
+    }
+
+  private:
+    struct key {
+      std::string_view file_name;
+      std::uint32_t row_idx = 0;
+      std::uint32_t col_idx = 0;
+      std::string_view diagnostic_type;
+
+      auto operator==(const key &) const -> bool = default;
+    };
+
+    struct key_hash {
+      auto operator()(const key &value) const noexcept -> std::size_t;
+    };
+
+    // The strings are interned in the string pool, so views are stable.
+    std::unordered_set<key, key_hash> reported_;
+  };
+
+  /// Diagnostics are deduplicated in the order files finish, so a file may have
+  /// dropped the copies kept by a file after it. If only the results up to
+  /// last are kept, e.g. by fastly exit, their dropped copies are given back
+  /// and they're deduplicated again in the order of files. Return the index of
+  /// the kept diagnostics.
+  auto deduplicate_kept(std::span<std::optional<per_file_result>> results,
+                        std::span<diagnostics> dropped,
+                        std::size_t last) -> diagnostic_index;
+
+} // namespace linter::tool::clang_tidy
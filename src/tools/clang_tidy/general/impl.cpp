@@ -16,79 +16,65 @@
 #include "tools/clang_tidy/general/impl.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
 #include <format>
+#include <fstream>
+#include <future>
 #include <iterator>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <unordered_map>
 #include <vector>
 
-#include <boost/regex.hpp>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #include <tinyxml2.h>
 
+#include "github/annotation.h"
 #include "github/common.h"
 #include "github/review_comment.h"
 #include "github/utils.h"
+#include "tools/clang_tidy/general/baseline.h"
+#include "tools/clang_tidy/general/compile_database.h"
+#include "tools/clang_tidy/general/parser.h"
 #include "tools/clang_tidy/general/reporter.h"
+#include "tools/path_filter.h"
+#include "tools/result_cache.h"
+#include "tools/scheduler.h"
+#include "tools/util.h"
 #include "utils/env_manager.h"
+#include "utils/git_utils.h"
+#include "utils/line_index.h"
+#include "utils/log.h"
+#include "utils/output_sink.h"
 #include "utils/shell.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace linter::tool::clang_tidy {
   using namespace std::string_view_literals;
 
   namespace {
-    constexpr auto supported_serverity = {"warning"sv, "info"sv, "error"sv};
-
-    // Parse the header line of clang-tidy. If the given line meets header line
-    // rule, parse it. Otherwise return std::nullopt.
-    auto parse_diagnostic_header(std::string_view line) -> std::optional<diagnostic_header> {
-      auto parts = line | std::views::split(':');
-
-      if (std::distance(parts.begin(), parts.end()) != 5) {
-        return std::nullopt;
-      }
-      auto iter            = parts.begin();
-      auto file_name       = std::string_view{*iter++};
-      auto row_idx         = std::string_view{*iter++};
-      auto col_idx         = std::string_view{*iter++};
-      auto serverity       = trim_left(std::string_view{*iter++});
-      auto diagnostic_type = std::string_view{*iter++};
-
-      if (!std::ranges::all_of(row_idx, ::isdigit)) {
-        return std::nullopt;
-      }
-      if (!std::ranges::all_of(col_idx, ::isdigit)) {
-        return std::nullopt;
-      }
-      if (!std::ranges::contains(supported_serverity, serverity)) {
-        return std::nullopt;
-      }
-
-      const auto *square_brackets = std::ranges::find(diagnostic_type, '[');
-      if ((square_brackets == diagnostic_type.end())
-          || (diagnostic_type.size() < 3)
-          || (diagnostic_type.back() != ']')) {
-        return std::nullopt;
-      }
-      auto brief      = std::string_view{diagnostic_type.begin(), square_brackets};
-      auto diagnostic = std::string_view{square_brackets, diagnostic_type.end()};
+    /// clang-tidy parses and analyses the whole translation unit, which is
+    /// usually two orders of magnitude slower than clang-format on the same
+    /// file. Used to weigh the estimated cost of tasks across tools.
+    constexpr auto cost_weight = std::uint64_t{100};
 
-      auto header            = diagnostic_header{};
-      header.file_name       = file_name;
-      header.row_idx         = row_idx;
-      header.col_idx         = col_idx;
-      header.serverity       = serverity;
-      header.brief           = brief;
-      header.diagnostic_type = diagnostic;
-      return header;
-    }
+    /// Bumped whenever the cached format of per_file_result is changed.
+    constexpr auto result_format_version = 2;
 
-    auto execute(const option_t &option, std::string_view repo, std::string_view file)
-      -> shell::result {
+    auto make_options(const option_t &option) -> std::vector<std::string> {
       auto opts = std::vector<std::string>{};
       if (!option.database.empty()) {
         opts.emplace_back(std::format("-p={}", option.database));
@@ -114,121 +100,592 @@ namespace linter::tool::clang_tidy {
       if (!option.line_filter.empty()) {
         opts.emplace_back(std::format("--line-filter={}", option.line_filter));
       }
+      return opts;
+    }
 
-      opts.emplace_back(file);
-
-      auto arg_str = opts | std::views::join_with(' ') | std::ranges::to<std::string>();
-      spdlog::info("Running command: {} {}", option.binary, arg_str);
+    // The added line ranges of a patch in the format of clang-tidy line filter.
+    auto make_added_lines(git::patch_raw_ptr patch) -> nlohmann::json {
+      auto lines = nlohmann::json::array();
+      for (auto hunk_idx = std::size_t{0}; hunk_idx < git::patch::num_hunks(patch); ++hunk_idx) {
+        auto num_lines = git::patch::num_lines_in_hunk(patch, hunk_idx);
+        for (auto line_idx = std::size_t{0}; line_idx < num_lines; ++line_idx) {
+          auto line = git::patch::get_line_in_hunk(patch, hunk_idx, line_idx);
+          if (line.origin != GIT_DIFF_LINE_ADDITION) {
+            continue;
+          }
+          if (!lines.empty() && lines.back()[1].get<int>() + 1 == line.new_lineno) {
+            lines.back()[1] = line.new_lineno;
+          } else {
+            lines.push_back({line.new_lineno, line.new_lineno});
+          }
+        }
+      }
+      // An empty range list means all lines to clang-tidy. Since line numbers
+      // start from 1, this range filters out all lines instead.
+      if (lines.empty()) {
+        lines.push_back({0, 0});
+      }
+      return lines;
+    }
 
-      return shell::execute(option.binary, opts, repo);
+    // All changed source files are put in the line filter, rather than the
+    // checked ones only, so diagnostics in changed lines of headers are kept.
+    auto make_line_filter(const runtime_context &context, const option_t &option) -> std::string {
+      const auto &source_filter = compiled_path_filter(option.source_filter_iregex);
+      auto filter               = nlohmann::json::array();
+      for (const auto &file: context.patches.files()) {
+        if (!source_filter.matches(file)) {
+          continue;
+        }
+        filter.push_back({
+          {"name",  file                                    },
+          {"lines", make_added_lines(context.patches.at(file))}
+        });
+      }
+      return filter.dump();
     }
 
-    void try_match(const std::string &line, const char *regex_str, auto callback) {
-      auto regex   = boost::regex{regex_str};
-      auto match   = boost::smatch{};
-      auto matched = boost::regex_match(line, match, regex, boost::match_extra);
-      if (matched) {
-        callback(match);
+    auto execute(const option_t &option,
+                 std::string_view repo,
+                 std::span<const std::string> files,
+                 const std::string &auto_line_filter,
+                 const std::filesystem::path &vfs_overlay,
+                 const std::filesystem::path &fixes_file,
+                 shell::output_sink std_out_sink) -> shell::result {
+      auto opts = make_options(option);
+      if (!auto_line_filter.empty()) {
+        opts.emplace_back(std::format("--line-filter={}", auto_line_filter));
       }
-    };
+      if (!vfs_overlay.empty()) {
+        opts.emplace_back(std::format("--vfsoverlay={}", vfs_overlay.string()));
+      }
+      if (!fixes_file.empty()) {
+        opts.emplace_back(std::format("--export-fixes={}", fixes_file.string()));
+      }
+      opts.insert(opts.end(), files.begin(), files.end());
+
+      LINTER_INFO("Running command: {} {}",
+                  option.binary,
+                  opts | std::views::join_with(' ') | std::ranges::to<std::string>());
+
+      // The runner thread only queues the chunks of stdout, which are passed
+      // to the sink on the thread of this task.
+      auto queue  = shell::chunk_queue{};
+      auto config = shell::execute_config{.env          = {},
+                                          .start_dir    = std::string{repo},
+                                          .std_in       = {},
+                                          .std_out_sink = queue.sink(),
+                                          .std_err_sink = {},
+                                          .timeout      = std::chrono::seconds{option.timeout}};
+      auto promise = std::promise<shell::result>{};
+      auto done    = promise.get_future();
+      shell::async_execute(
+        option.binary, opts, config, [&](std::exception_ptr error, shell::result res) {
+          if (error) {
+            promise.set_exception(std::move(error));
+          } else {
+            promise.set_value(std::move(res));
+          }
+          queue.close();
+        });
+      for (auto chunks = queue.take(); !chunks.empty(); chunks = queue.take()) {
+        for (const auto &chunk: chunks) {
+          std_out_sink(chunk);
+        }
+      }
+      auto res = done.get();
+      record_task_memory(res.peak_rss);
+      return res;
+    }
 
-    auto parse_stdout(std::string_view std_out) -> diagnostics {
-      auto diags         = diagnostics{};
-      auto needs_details = false;
-
-      for (auto part: std::views::split(std_out, '\n')) {
-        auto line = std::string{part.data(), part.size()};
-        spdlog::trace("Parsing: {}", line);
-
-        auto header_line = parse_diagnostic_header(line);
-        if (header_line) {
-          spdlog::trace(
-            " Result: {}:{}:{}: {}:{}{}",
-            header_line->file_name,
-            header_line->row_idx,
-            header_line->col_idx,
-            header_line->serverity,
-            header_line->brief,
-            header_line->diagnostic_type);
-
-          diags.emplace_back(std::move(*header_line));
-          needs_details = true;
+    // Each clang-tidy invocation exports fixes to its own file.
+    auto make_fixes_file() -> std::filesystem::path {
+      static auto counter = std::atomic<std::uint64_t>{0};
+      auto name = std::format("cpp-linter-fixes-{}-{}.yaml", ::getpid(), counter.fetch_add(1));
+      return std::filesystem::temp_directory_path() / name;
+    }
+
+    // clang-tidy reads files from the working tree, which may differ from the
+    // index. So the staged contents of files differing from the working tree
+    // are written to a temporary directory, and overlaid onto the working tree
+    // by a VFS overlay file. So included headers are read as staged too.
+    auto write_staged_files(const runtime_context &context,
+                            clang_tidy_general::staged_overlay &ret) -> nlohmann::json {
+      auto root   = std::filesystem::absolute(context.repo_path).lexically_normal();
+      auto handle = context.repos->acquire();
+      auto index  = git::repo::index(handle->repo.get());
+      auto opts   = git::diff::init_option();
+      auto diff   = git::diff::index_to_workdir(handle->repo.get(), index.get(), &opts);
+      auto roots  = nlohmann::json::array();
+      for (auto idx = std::size_t{0}; idx < git::diff::num_deltas(diff.get()); ++idx) {
+        // The old file of the delta is the one in the index.
+        const auto *delta = git::diff::get_delta(diff.get(), idx);
+        auto file         = std::string{delta->old_file.path};
+        auto view = git::blob::get_view(handle->repo.get(), handle->source_tree.get(), file);
+        if (view.blob == nullptr) {
           continue;
         }
+        auto path   = (root / file).lexically_normal();
+        auto staged = ret.dir / std::format("{}{}", idx, path.extension().string());
+        auto out    = std::ofstream{staged, std::ios::binary | std::ios::trunc};
+        out.write(view.content.data(), static_cast<std::streamsize>(view.content.size()));
+        throw_unless(out.good(), std::format("failed to write {}", staged.string()));
+        roots.push_back({
+          {"name",              path.string()  },
+          {"type",              "file"         },
+          {"external-contents", staged.string()}
+        });
+        ret.copies.emplace(path.string(), staged);
+      }
+      return roots;
+    }
+
+    auto make_staged_overlay(const runtime_context &context)
+      -> clang_tidy_general::staged_overlay {
+      static auto counter = std::atomic<std::uint64_t>{0};
 
-        if (needs_details) {
-          diags.back().details += line;
+      auto name = std::format("cpp-linter-staged-{}-{}", ::getpid(), counter.fetch_add(1));
+      auto ret  = clang_tidy_general::staged_overlay{};
+      ret.dir   = std::filesystem::temp_directory_path() / name;
+      std::filesystem::create_directories(ret.dir);
+      try {
+        // Diagnostics refer to the files of the working tree rather than the
+        // temporary ones.
+        auto overlay = nlohmann::json{
+          {"version",            0                                },
+          {"use-external-names", false                            },
+          {"roots",              write_staged_files(context, ret)}
+        };
+        ret.file = ret.dir / "overlay.json";
+        auto out = std::ofstream{ret.file, std::ios::trunc};
+        out << overlay.dump();
+        throw_unless(out.good(), std::format("failed to write {}", ret.file.string()));
+      } catch (...) {
+        auto ec = std::error_code{};
+        std::filesystem::remove_all(ret.dir, ec);
+        throw;
+      }
+      return ret;
+    }
+
+    auto read_file(const std::filesystem::path &path) -> std::optional<std::string> {
+      auto file = std::ifstream{path, std::ios::binary};
+      if (!file.is_open()) {
+        return std::nullopt;
+      }
+      return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+
+    auto normalize_path(std::string_view root_dir, std::string_view file) -> std::filesystem::path {
+      auto path = std::filesystem::path{file};
+      if (path.is_relative()) {
+        path = std::filesystem::path{root_dir} / path;
+      }
+      return path.lexically_normal();
+    }
+
+    // Whether the include directive may name the header, e.g. "foo/bar.h"
+    // names "/repo/include/foo/bar.h". Include directories aren't known, so
+    // the name is matched with the tail of the path.
+    auto names_header(const include_directive &directive, const std::filesystem::path &header)
+      -> bool {
+      auto name = std::filesystem::path{directive.name}.lexically_normal();
+      auto tail = header.end();
+      for (auto iter = name.end(); iter != name.begin();) {
+        --iter;
+        if (tail == header.begin() || *--tail != *iter) {
+          return false;
         }
       }
+      return true;
+    }
 
-      spdlog::info("Parsed clang tidy stdout, got {} diagnostics.", diags.size());
-      return diags;
+    // The number of leading directories the paths share.
+    auto common_dirs(const std::filesystem::path &lhs, const std::filesystem::path &rhs)
+      -> std::size_t {
+      auto lhs_dir = lhs.parent_path();
+      auto rhs_dir = rhs.parent_path();
+      auto ends    = std::ranges::mismatch(lhs_dir, rhs_dir);
+      return static_cast<std::size_t>(std::distance(lhs_dir.begin(), ends.in1));
     }
 
-    constexpr auto warning_and_error  = "^(\\d+) warnings and (\\d+) errors? generated.";
-    constexpr auto warnings_generated = "^(\\d+) warnings? generated.";
-    constexpr auto errors_generated   = "^(\\d+) errors? generated.";
-    constexpr auto suppressed         = R"(Suppressed (\d+) warnings \((\d+) in non-user code\)\.)";
-    constexpr auto suppressed_lint =
-      R"(Suppressed (\d+) warnings \((\d+) in non-user code, (\d+) NOLINT\)\.)";
-    constexpr auto warnings_as_errors = "^(\\d+) warnings treated as errors";
-
-    /// TODO: should we parse stderr?
-    auto parse_stderr(std::string_view std_err) -> statistic {
-      auto stat                 = statistic{};
-      auto warning_and_error_cb = [&](boost::smatch &match) {
-        spdlog::trace(" Result: {} warnings and {} error(s) generated.",
-                      match[1].str(),
-                      match[2].str());
-        stat.warnings = stoi(match[1].str());
-        stat.errors   = stoi(match[2].str());
+    // Split the diagnostics of one clang-tidy invocation into the files of the
+    // batch by the file name of each diagnostic. Diagnostics of files outside
+    // of the batch, such as headers matched by header filter, are attributed
+    // to the file of the batch including the header directly, otherwise to
+    // the one nearest to the header in the directory tree.
+    auto split_by_file(diagnostics diags,
+                       std::string_view root_dir,
+                       std::span<const std::string> files) -> std::vector<diagnostics> {
+      auto to_path = [&](const auto &file) {
+        return normalize_path(root_dir, file);
       };
+      auto paths = files | std::views::transform(to_path) | std::ranges::to<std::vector>();
 
-      auto warnings_generated_cb = [&](boost::smatch &match) {
-        spdlog::trace(" Result: {} warning(s) generated.", match[1].str());
-        stat.warnings = stoi(match[1].str());
+      // The includes of batch files are only read if any header has diagnostics.
+      auto includes = std::vector<std::optional<std::vector<include_directive>>>{};
+      auto includer = [&](const std::filesystem::path &header) -> std::size_t {
+        if (includes.empty()) {
+          for (const auto &path: paths) {
+            includes.push_back(read_file(path).transform(parse_includes));
+          }
+        }
+        for (auto idx = std::size_t{0}; idx < paths.size(); ++idx) {
+          if (includes[idx] && std::ranges::any_of(*includes[idx], [&](const auto &directive) {
+                return names_header(directive, header);
+              })) {
+            return idx;
+          }
+        }
+        auto nearest = std::ranges::max_element(paths, {}, [&](const auto &path) {
+          return common_dirs(path, header);
+        });
+        return static_cast<std::size_t>(std::distance(paths.begin(), nearest));
       };
 
-      auto errors_generated_cb = [&](boost::smatch &match) {
-        spdlog::trace(" Result: {} error(s) generated.", match[1].str());
-        stat.errors = stoi(match[1].str());
-      };
+      auto owners = std::unordered_map<std::string, std::size_t>{};
+      auto ret    = std::vector<diagnostics>(files.size());
+      for (auto &diag: diags) {
+        auto path          = normalize_path(root_dir, diag.header.file_name);
+        auto [iter, added] = owners.try_emplace(path.string(), 0);
+        if (added) {
+          auto found   = std::ranges::find(paths, path);
+          iter->second = found != paths.end()
+                         ? static_cast<std::size_t>(std::distance(paths.begin(), found))
+                         : includer(path);
+        }
+        ret[iter->second].emplace_back(std::move(diag));
+      }
+      return ret;
+    }
 
-      auto suppressed_cb = [&](boost::smatch &match) {
-        spdlog::trace(" Result: Suppressed {} warnings ({} in non-user code).",
-                      match[1].str(),
-                      match[2].str());
-        stat.total_suppressed_warnings = stoi(match[1].str());
-        stat.non_user_code_warnings    = stoi(match[2].str());
-      };
+    // Only the file offset of a diagnostic is exported, so the row and column
+    // of it are calculated from the content of the file, which is the staged
+    // copy if the file is overlaid.
+    void locate_diagnostics(diagnostics &diags,
+                            std::string_view root_dir,
+                            const clang_tidy_general::staged_overlay *overlay) {
+      auto indexes = std::unordered_map<std::string, line_index>{};
+      for (auto &diag: diags) {
+        auto [iter, inserted] = indexes.try_emplace(std::string{diag.header.file_name});
+        if (inserted) {
+          auto path = normalize_path(root_dir, diag.header.file_name);
+          if (overlay != nullptr) {
+            auto abs    = std::filesystem::absolute(path).lexically_normal();
+            auto staged = overlay->copies.find(abs.string());
+            if (staged != overlay->copies.end()) {
+              path = staged->second;
+            }
+          }
+          auto content = read_file(path);
+          iter->second = line_index{content.value_or("")};
+        }
+        auto pos            = iter->second.position(diag.file_offset);
+        diag.header.row_idx = pos ? static_cast<std::uint32_t>(pos->first) : 0;
+        diag.header.col_idx = pos ? static_cast<std::uint32_t>(pos->second) : 0;
+      }
+    }
+
+    auto read_export_fixes(const std::filesystem::path &fixes_file,
+                           std::string_view root_dir,
+                           const clang_tidy_general::staged_overlay *overlay) -> diagnostics {
+      // clang-tidy doesn't export anything if it failed before checking.
+      auto content = read_file(fixes_file);
+      if (!content) {
+        return {};
+      }
+      auto ec = std::error_code{};
+      std::filesystem::remove(fixes_file, ec);
+
+      auto diags = parse_export_fixes(*content);
+      locate_diagnostics(diags, root_dir, overlay);
+      return diags;
+    }
+
+    auto has_error(const diagnostics &diags) -> bool {
+      return std::ranges::any_of(diags, [](const auto &diag) {
+        return diag.header.serverity == "error";
+      });
+    }
 
-      auto suppressed_and_nolint_cb = [&](boost::smatch &match) {
-        spdlog::trace(" Result: Suppressed {} warnings ({} in non-user code, {} NOLINT).",
-                      match[1].str(),
-                      match[2].str(),
-                      match[3].str());
-        stat.total_suppressed_warnings = stoi(match[1].str());
-        stat.non_user_code_warnings    = stoi(match[2].str());
-        stat.no_lint_warnings          = stoi(match[3].str());
+    // Headers aren't checked alone but affect the results of files including
+    // them, so the result of a file is cached together with changed headers.
+    auto is_header(std::string_view file) -> bool {
+      static constexpr auto extensions = {".h"sv, ".hh"sv, ".hpp"sv, ".hxx"sv, ".inc"sv};
+      return std::ranges::any_of(extensions, [&](auto ext) { return file.ends_with(ext); });
+    }
+
+    // The include directives of files are cached by their blob ids in source
+    // revision, so only changed files are scanned again.
+    constexpr auto include_cache_key = "include-directives";
+
+    auto directives_to_json(const std::vector<include_directive> &directives) -> nlohmann::json {
+      auto ret = nlohmann::json::array();
+      for (const auto &directive: directives) {
+        ret.push_back({directive.name, directive.quoted});
+      }
+      return ret;
+    }
+
+    auto directives_from_json(const nlohmann::json &value) -> std::vector<include_directive> {
+      auto ret = std::vector<include_directive>{};
+      for (const auto &directive: value) {
+        ret.push_back({.name = directive[0].get<std::string>(), .quoted = directive[1].get<bool>()});
+      }
+      return ret;
+    }
+
+    // Headers aren't checked alone, so the translation units of compilation
+    // database including changed headers are checked instead. Return them
+    // relative to repository, most costly first, except the checked ones.
+    auto find_dependents(const runtime_context &context,
+                         const option_t &option,
+                         const result_cache &cache,
+                         std::span<const std::string> checked) -> std::vector<std::string> {
+      const auto &source_filter = compiled_path_filter(option.source_filter_iregex);
+      auto root                 = std::filesystem::absolute(context.repo_path).lexically_normal();
+      auto headers              = std::vector<std::filesystem::path>{};
+      for (const auto &file: context.changed_files) {
+        if (is_header(file) && source_filter.matches(file)) {
+          headers.push_back(normalize_path(root.string(), file));
+        }
+      }
+      if (headers.empty()) {
+        return {};
+      }
+
+      auto database = normalize_path(root.string(), option.database) / "compile_commands.json";
+      auto content  = read_file(database);
+      if (!content) {
+        spdlog::warn("Can't read compilation database {}, skip checking dependents",
+                     database.string());
+        return {};
+      }
+
+      auto scope  = trace::scope{"parse", "clang-tidy include graph"};
+      auto tree   = git::commit::tree(context.source_commit.get());
+      auto cached = cache.load(include_cache_key).value_or(nlohmann::json::object());
+      auto stored = nlohmann::json::object();
+      auto read_includes = [&](const std::filesystem::path &path)
+        -> std::optional<std::vector<include_directive>> {
+        auto file    = path.lexically_relative(root).generic_string();
+        auto blob_id = std::string{};
+        auto source  = std::optional<std::string>{};
+        if (context.watch) {
+          // Saved files differ from source revision, so they're keyed by the
+          // blob ids of their contents.
+          source = read_file(path);
+          if (source && !file.starts_with("..")) {
+            blob_id = git::oid::to_str(git::oid::hash(*source)).c_str();
+          }
+        } else if (!file.starts_with("..")) {
+          if (auto entry = git::tree::entry_bypath(tree.get(), file)) {
+            // The hex string of oid without the null terminator.
+            blob_id = git::oid::to_str(git::tree::entry_id(entry.get())).c_str();
+          }
+        }
+        if (!blob_id.empty() && cached.contains(file) && cached[file]["id"] == blob_id) {
+          stored[file] = cached[file];
+          return directives_from_json(cached[file]["includes"]);
+        }
+        if (!context.watch) {
+          source = read_file(path);
+        }
+        if (!source) {
+          return std::nullopt;
+        }
+        auto directives = parse_includes(*source);
+        if (!blob_id.empty()) {
+          stored[file] = {
+            {"id",       blob_id             },
+            {"includes", directives_to_json(directives)}
+          };
+        }
+        return directives;
       };
+      auto graph = include_graph{parse_compile_commands(*content), root, read_includes};
+      cache.store(include_cache_key, stored);
+
+      auto dependents = std::vector<std::pair<std::uint64_t, std::string>>{};
+      for (const auto &unit: graph.affected_units(headers)) {
+        auto file = unit.lexically_relative(root).generic_string();
+        if (file.empty() || file.starts_with("..") || std::ranges::contains(checked, file)
+            || !source_filter.matches(file)) {
+          continue;
+        }
+        dependents.emplace_back(estimate_file_cost(context.repo_path, file), std::move(file));
+      }
+      std::ranges::stable_sort(dependents, std::ranges::greater{}, [](const auto &dependent) {
+        return dependent.first;
+      });
+      spdlog::info("{} of {} translation units include changed headers",
+                   dependents.size(),
+                   graph.num_units());
+      return dependents | std::views::values | std::ranges::to<std::vector>();
+    }
+
+    auto make_fingerprint(const runtime_context &context, const option_t &option) -> std::string {
+      auto files = std::vector<std::string>{};
+      if (!option.database.empty()) {
+        auto database = std::filesystem::path{option.database} / "compile_commands.json";
+        files.push_back(database.string());
+      }
+      if (!option.config_file.empty()) {
+        files.push_back(option.config_file);
+      }
+      auto args = make_options(option);
+      if (option.export_fixes) {
+        args.emplace_back("--export-fixes");
+      }
+      // Entries cached in a different format are never loaded.
+      args.emplace_back(std::format("result-format-{}", result_format_version));
+      return make_tool_fingerprint(context, option.binary, args, files);
+    }
+
+    // All diagnostics of a file are compared with its baseline, so no line
+    // filter is used to check the baseline.
+    auto make_baseline_option(option_t option) -> option_t {
+      option.baseline         = false;
+      option.check_dependents = false;
+      option.auto_line_filter = false;
+      option.line_filter.clear();
+      return option;
+    }
+
+    // The file of target revision is written to a temporary directory of its
+    // own, so nothing is left in the working tree even if cpp-linter crashes.
+    // A compilation database next to it gives the compile command of the
+    // checked file, including its directory for relative includes.
+    struct baseline_file {
+      explicit baseline_file(const std::filesystem::path &file) {
+        static auto counter = std::atomic<std::uint64_t>{0};
 
-      auto warnings_as_errors_cb = [&](boost::smatch &match) {
-        spdlog::trace(" Result: {} warnings treated as errors", match[1].str());
-        stat.warnings_treated_as_errors = stoi(match[1].str());
+        auto name = std::format("cpp-linter-baseline-{}-{}", ::getpid(), counter.fetch_add(1));
+        dir       = std::filesystem::temp_directory_path() / name;
+        path      = dir / file.filename();
+      }
+
+      baseline_file(const baseline_file &)            = delete;
+      baseline_file &operator=(const baseline_file &) = delete;
+
+      ~baseline_file() {
+        auto ec = std::error_code{};
+        std::filesystem::remove_all(dir, ec);
+      }
+
+      [[nodiscard]] auto write(std::string_view content, std::string_view database) const -> bool {
+        auto ec = std::error_code{};
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+          return false;
+        }
+        for (auto [file, data]: {std::pair{path, content},
+                                 std::pair{dir / "compile_commands.json", database}}) {
+          auto out = std::ofstream{file, std::ios::binary | std::ios::trunc};
+          out.write(data.data(), static_cast<std::streamsize>(data.size()));
+          if (!out.good()) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      std::filesystem::path dir;
+      std::filesystem::path path;
+    };
+
+    // The nearest .clang-tidy of a file in repository. The copy of the file in
+    // temporary directory doesn't find it by itself.
+    auto find_config_file(const std::filesystem::path &root, const std::filesystem::path &file)
+      -> std::optional<std::filesystem::path> {
+      auto ec = std::error_code{};
+      for (auto dir = file.parent_path();; dir = dir.parent_path()) {
+        auto relative = dir.lexically_relative(root);
+        if (relative.empty() || *relative.begin() == "..") {
+          return std::nullopt;
+        }
+        if (auto config = dir / ".clang-tidy"; std::filesystem::exists(config, ec)) {
+          return config;
+        }
+        if (relative == ".") {
+          return std::nullopt;
+        }
+      }
+    }
+
+    // Map rows of a changed file to target revision by the hunks of its patch.
+    // A row inside a hunk is mapped as if the hunk only replaced lines.
+    auto make_row_mapper(const runtime_context &context, const std::string &file) -> row_mapper {
+      if (!context.patches.contains(file)) {
+        return {};
+      }
+      auto *patch = context.patches.at(file);
+      auto hunks  = std::vector<git::diff_hunk>{};
+      for (auto idx = std::size_t{0}; idx < git::patch::num_hunks(patch); ++idx) {
+        hunks.push_back(std::get<0>(git::patch::get_hunk(patch, idx)));
+      }
+      return [hunks = std::move(hunks)](std::size_t row) -> std::size_t {
+        auto line  = static_cast<std::int64_t>(row);
+        auto shift = std::int64_t{0};
+        for (const auto &hunk: hunks) {
+          if (line < hunk.new_start) {
+            break;
+          }
+          if (line < hunk.new_start + hunk.new_lines) {
+            auto last   = std::max(hunk.old_lines - 1, 0);
+            auto offset = std::min<std::int64_t>(line - hunk.new_start, last);
+            return static_cast<std::size_t>(hunk.old_start + offset);
+          }
+          shift = (hunk.old_start + hunk.old_lines) - (hunk.new_start + hunk.new_lines);
+        }
+        return static_cast<std::size_t>(std::max<std::int64_t>(line + shift, 0));
       };
+    }
 
-      for (auto part: std::views::split(std_err, '\n')) {
-        auto line = std::string{part.data(), part.size()};
-        spdlog::trace("Parsing: {}", line);
-        try_match(line, warning_and_error, warning_and_error_cb);
-        try_match(line, warnings_generated, warnings_generated_cb);
-        try_match(line, errors_generated, errors_generated_cb);
-        try_match(line, suppressed, suppressed_cb);
-        try_match(line, warnings_as_errors, warnings_as_errors_cb);
-        try_match(line, suppressed_lint, suppressed_and_nolint_cb);
+    // Drop the diagnostics reported by former files, and ones of the given
+    // files in order, so the first file including a header keeps them. Used
+    // by merging results of shards, each one deduplicated already.
+    void drop_reported_diagnostics(diagnostic_index &reported,
+                                   result_t &result,
+                                   std::span<const std::string> files) {
+      auto dropped = std::size_t{0};
+      for (const auto &file: files) {
+        for (auto *results: {&result.fails, &result.passes}) {
+          if (auto iter = results->find(file); iter != results->end()) {
+            dropped += reported.drop_reported(iter->second.diags);
+          }
+        }
+      }
+      if (dropped != 0) {
+        spdlog::info("Drop {} diagnostics reported by other files", dropped);
       }
+    }
 
-      return stat;
+    // Diagnostics of headers are annotated on the headers.
+    auto make_annotations(std::string_view root_dir, const per_file_result &result)
+      -> github::annotations {
+      auto root = std::filesystem::absolute(root_dir).lexically_normal();
+      auto ret  = github::annotations{};
+      for (const auto &diag: result.diags) {
+        const auto &header = diag.header;
+        auto path          = std::filesystem::absolute(normalize_path(root_dir, header.file_name))
+                      .lexically_relative(root)
+                      .string();
+        if (path.empty() || path.starts_with("..")) {
+          path = result.file_path;
+        }
+        auto level = header.serverity == "error"   ? "failure"
+                   : header.serverity == "warning" ? "warning"
+                                                   : "notice";
+        ret.push_back({.path             = std::move(path),
+                       .start_line       = std::max(header.row_idx, 1U),
+                       .end_line         = std::max(header.row_idx, 1U),
+                       .annotation_level = level,
+                       .title            = std::format("clang-tidy {}", header.diagnostic_type),
+                       .message          = std::string{header.brief},
+                       .raw_details      = std::string{diag.details}});
+      }
+      return ret;
     }
 
     void print_statistic(const statistic &stat) {
@@ -242,75 +699,396 @@ namespace linter::tool::clang_tidy {
 
   } // namespace
 
-  auto clang_tidy_general::check_single_file(
-    [[maybe_unused]] const runtime_context &context,
-    const std::string &root_dir,
-    const std::string &file) const -> per_file_result {
+  auto clang_tidy_general::check_single_file(const runtime_context &context,
+                                             const std::string &root_dir,
+                                             const std::string &file) const -> per_file_result {
+    return std::move(check_batch(context, root_dir, {&file, 1}).front());
+  }
+
+  auto clang_tidy_general::check_batch(const runtime_context &context,
+                                       const std::string &root_dir,
+                                       std::span<const std::string> files) const
+    -> std::vector<per_file_result> {
     spdlog::info("Start to run clang-tidy");
-    auto [ec, std_out, std_err] = execute(option, root_dir, file);
+    auto line_filter = option.auto_line_filter ? state->line_filter : std::string{};
+    auto *overlay    = state != nullptr ? &state->vfs_overlay : nullptr;
+    auto vfs_overlay = overlay != nullptr ? overlay->file : std::filesystem::path{};
+    auto fixes_file  = option.export_fixes ? make_fixes_file() : std::filesystem::path{};
+
+    // The stdout of clang-tidy may be huge on large files, so it's parsed as
+    // it's being read and only the head of it is kept.
+    auto parser    = stdout_parser{};
+    auto lines     = shell::line_splitter{[&](std::string_view line) { parser.parse_line(line); }};
+    auto kept      = shell::capped_output{option.max_output_size};
+    auto on_stdout = [&](std::string_view chunk) {
+      if (!option.export_fixes) {
+        lines.feed(chunk);
+      }
+      kept.append(chunk);
+    };
+    auto res      = execute(
+      option, root_dir, files, line_filter, vfs_overlay, fixes_file, on_stdout);
+    auto ec       = res.exit_code;
+    auto &std_err = res.std_err;
+    lines.finish();
+    auto std_out = kept.str();
+    if (res.killed) {
+      throw shell::killed_error{std::format("{} was killed on {}", option.binary, files.front())};
+    }
+    if (res.timed_out) {
+      spdlog::warn("{} timed out on {}, output before that:\nstdout:\n{}stderr:\n{}",
+                   option.binary,
+                   files.front(),
+                   std_out,
+                   std_err);
+      throw shell::timeout_error{std::format("{} timed out on {}", option.binary, files.front())};
+    }
     spdlog::trace("clang-tidy original output:\nreturn code: {}\nstdout:\n{}stderr:\n{}",
                   ec,
                   std_out,
                   std_err);
 
     spdlog::info("Successfully ran clang-tidy, now start to parse the output of it.");
-    auto result        = per_file_result{};
-    result.passed      = ec == 0;
-    result.diags       = parse_stdout(std_out);
-    result.tool_stdout = std_out;
-    result.tool_stderr = std_err;
-    result.file_path   = file;
-
-    if (result.passed) {
-      spdlog::info("The final result of ran clang-tidy on {} is: {}, detailed "
-                   "information:\n{}",
-                   file,
-                   "PASSED",
-                   result.tool_stderr);
-    } else {
-      spdlog::error(
-        "The final result of ran clang-tidy on {} is: {} , detailed "
-        "information:\n{}",
-        file,
-        "FAILED",
-        result.tool_stderr);
+    auto scope  = trace::scope{"parse", std::format("clang-tidy {}", files.front())};
+    auto parsed = option.export_fixes ? read_export_fixes(fixes_file, root_dir, overlay)
+                                      : parser.take();
+    auto diags  = split_by_file(std::move(parsed), root_dir, files);
+    auto stat   = parse_stderr(std_err);
+    print_statistic(stat);
+
+    // The exit code belongs to the whole invocation. If it failed, only the
+    // files owning error diagnostics are blamed. If none of them does, it's
+    // unknown which file caused the failure, so all of them are failed.
+    auto blame_all = ec != 0 && std::ranges::none_of(diags, has_error);
+
+    // Diagnostics which also exist in target revision aren't introduced by
+    // the changes, so they're neither reported nor blamed.
+    if (option.baseline) {
+      for (auto idx = std::size_t{0}; idx < files.size(); ++idx) {
+        auto baseline = check_baseline(context, root_dir, files[idx]);
+        if (!baseline) {
+          continue;
+        }
+        auto num_diags = diags[idx].size();
+        diags[idx] =
+          remove_baseline(std::move(diags[idx]), *baseline, make_row_mapper(context, files[idx]));
+        spdlog::info("{} of {} diagnostics of {} exist in target revision",
+                     num_diags - diags[idx].size(),
+                     num_diags,
+                     files[idx]);
+      }
     }
-    return result;
+
+    // Each translation unit prints its own profile table in the order of
+    // files. If the tables can't be matched with files, they're all given to
+    // the first file.
+    auto profiles = option.enable_check_profile ? parse_check_profile(std_err)
+                                                : std::vector<check_profile>{};
+    if (!profiles.empty() && profiles.size() != files.size()) {
+      auto merged = profiles | std::views::join | std::ranges::to<check_profile>();
+      profiles    = std::vector<check_profile>(files.size());
+      profiles.front() = std::move(merged);
+    }
+
+    // The outputs of clang-tidy can't be split reliably, so they're kept once
+    // by the first failed file of the batch, which is the most likely to be
+    // read, or the first file if all passed.
+    auto passed = std::vector<bool>(files.size());
+    for (auto idx = std::size_t{0}; idx < files.size(); ++idx) {
+      passed[idx] = ec == 0 || (!blame_all && !has_error(diags[idx]));
+    }
+    auto first_failed = std::ranges::find(passed, false);
+    auto keeper       = first_failed == passed.end()
+                        ? std::size_t{0}
+                        : static_cast<std::size_t>(std::distance(passed.begin(), first_failed));
+
+    auto results = std::vector<per_file_result>{};
+    results.reserve(files.size());
+    for (auto idx = std::size_t{0}; idx < files.size(); ++idx) {
+      const auto &file = files[idx];
+      auto result      = per_file_result{};
+      result.passed    = passed[idx];
+      result.diags     = std::move(diags[idx]);
+      // The statistic is of the whole invocation as well.
+      result.stat = stat;
+      if (idx == keeper) {
+        result.tool_stdout = std_out;
+        result.tool_stderr = std_err;
+      } else {
+        result.tool_stderr = std::format("The outputs of {} are kept by {}, checked together\n",
+                                         option.binary,
+                                         files[keeper]);
+      }
+      result.file_path = file;
+      if (!profiles.empty()) {
+        result.profile = std::move(profiles[idx]);
+      }
+
+      if (result.passed) {
+        spdlog::info("The final result of ran clang-tidy on {} is: {}, detailed "
+                     "information:\n{}",
+                     file,
+                     "PASSED",
+                     result.tool_stderr);
+      } else {
+        spdlog::error(
+          "The final result of ran clang-tidy on {} is: {} , detailed "
+          "information:\n{}",
+          file,
+          "FAILED",
+          result.tool_stderr);
+      }
+      results.emplace_back(std::move(result));
+    }
+    return results;
   }
 
-  void clang_tidy_general::check(const runtime_context &context) {
-    const auto root_dir = context.repo_path;
-    const auto files    = context.changed_files;
-    for (const auto &file: files) {
-      if (filter_file(option.source_filter_iregex, file)) {
-        result.ignored.push_back(file);
-        spdlog::debug("file is ignored {} by {}", file, option.binary);
-        continue;
+  auto clang_tidy_general::check_baseline(const runtime_context &context,
+                                          const std::string &root_dir,
+                                          const std::string &file) const
+    -> std::optional<diagnostics> {
+    if (context.repos == nullptr) {
+      return std::nullopt;
+    }
+    auto handle = context.repos->acquire();
+    auto view   = git::blob::get_view(handle->repo.get(), handle->target.get(), file);
+    if (view.blob == nullptr) {
+      return std::nullopt;
+    }
+
+    const auto &cache = state->cache;
+    auto key          = std::optional<std::string>{};
+    if (!state->baseline_fingerprint.empty()) {
+      auto config_name = std::vector<std::string>{".clang-tidy"};
+      key              = make_cache_key(
+        handle->target.get(), state->baseline_fingerprint, file, config_name, {});
+      if (auto cached = key ? cache.load(*key) : std::nullopt) {
+        spdlog::info("Use the cached baseline of {}", file);
+        return cached->get<per_file_result>().diags;
       }
+    }
 
-      auto per_file_result = check_single_file(context, root_dir, file);
-      if (per_file_result.passed) {
-        spdlog::info("file: {} passes {} check.", file, option.binary);
-        result.passes[file] = std::move(per_file_result);
-        continue;
+    spdlog::info("Check the baseline of {} in target revision", file);
+    auto checked  = normalize_path(root_dir, file);
+    auto temp     = baseline_file{checked};
+    auto database = std::string{};
+    if (!option.database.empty()) {
+      auto commands = normalize_path(root_dir, option.database) / "compile_commands.json";
+      database      = read_file(commands).value_or("");
+    }
+    if (!temp.write(view.content, make_copy_database(database, checked, temp.path))) {
+      spdlog::warn("Failed to write the baseline of {} to {}", file, temp.path.string());
+      return std::nullopt;
+    }
+    auto baseline     = make_baseline_option(option);
+    baseline.database = temp.dir.string();
+    if (baseline.config.empty() && baseline.config_file.empty()) {
+      if (auto config = find_config_file(root_dir, checked)) {
+        baseline.config_file = config->string();
+      }
+    }
+    auto tool   = clang_tidy_general{std::move(baseline)};
+    auto result = tool.check_single_file(context, root_dir, temp.path.string());
+    if (key) {
+      cache.store(*key, result);
+    }
+    return std::move(result.diags);
+  }
+
+  void clang_tidy_general::warm_up(const runtime_context &context) {
+    auto binary = resolve_tool_binary(option.binary);
+    if (!context.cache_dir.empty()) {
+      tool_version(context.cache_dir, binary);
+    }
+  }
+
+  auto clang_tidy_general::prepare(const runtime_context &context,
+                                   const classified_files &classes) -> std::vector<tool_task> {
+    for (const auto &file: classes.ignored) {
+      result.ignored.push_back(file);
+      spdlog::debug("file is ignored {} by {}", file, option.binary);
+    }
+    auto files = classes.matched;
+    auto file_cache = result_cache{context.cache_dir, name()};
+    if (option.check_dependents) {
+      auto dependents = find_dependents(context, option, file_cache, files);
+      files.insert(files.end(), dependents.begin(), dependents.end());
+    }
+    files = select_shard_files(files, context.repo_path, context.shard_index, context.shard_count);
+    state = std::make_unique<check_state>(std::move(files), std::move(file_cache));
+    auto &[checked, keys, from_cache, slots, dropped, cache, baseline_fingerprint, line_filter,
+           vfs_overlay] = *state;
+    if (checked.empty()) {
+      return {};
+    }
+    option.binary = resolve_tool_binary(option.binary);
+    if (option.auto_line_filter) {
+      line_filter = make_line_filter(context, option);
+    }
+    if (context.staged) {
+      vfs_overlay = make_staged_overlay(context);
+    }
+    if (context.annotations != nullptr) {
+      slots.on_failed = [&context](const per_file_result &res) {
+        context.annotations->add(make_annotations(context.repo_path, res));
+      };
+    }
+    if (context.results != nullptr) {
+      slots.on_checked = [this, &context](const per_file_result &res) {
+        context.results->add(name(), res, make_annotations(context.repo_path, res));
+      };
+    }
+    if (option.baseline && cache.enabled()) {
+      baseline_fingerprint = make_fingerprint(context, make_baseline_option(option));
+    }
+
+    // Reuse the cached results of files which are unchanged since last run.
+    if (cache.enabled()) {
+      auto fingerprint = make_fingerprint(context, option);
+      auto headers     = context.changed_files
+                   | std::views::filter(is_header)
+                   | std::ranges::to<std::vector<std::string>>();
+      auto config_name = std::vector<std::string>{".clang-tidy"};
+      // Staged contents of changed files are given by the VFS overlay, which
+      // are their blobs in source revision. Otherwise clang-tidy reads the
+      // working tree.
+      auto source =
+        context.staged ? content_source_t::source_revision : content_source_t::work_tree;
+      for (auto idx = std::size_t{0}; idx < checked.size(); ++idx) {
+        // The generated line filter depends on the changes of a file, not only
+        // the content of it.
+        auto file_fingerprint = fingerprint;
+        if (option.auto_line_filter && context.patches.contains(checked[idx])) {
+          file_fingerprint += make_added_lines(context.patches.at(checked[idx])).dump();
+        }
+        keys[idx] =
+          make_cache_key(context, file_fingerprint, checked[idx], config_name, headers, source);
+        if (!keys[idx]) {
+          continue;
+        }
+        auto cached = cache.load(*keys[idx]);
+        if (!cached) {
+          continue;
+        }
+        spdlog::info("Use the cached {} result of {}", option.binary, checked[idx]);
+        from_cache[idx] = true;
+        set_result(idx, cached->get<per_file_result>());
       }
+    }
 
-      spdlog::error("file: {} doesn't pass {} check.", file, option.binary);
-      result.fails[file] = std::move(per_file_result);
+    auto pending = std::vector<std::size_t>{};
+    for (auto idx = std::size_t{0}; idx < checked.size(); ++idx) {
+      if (!from_cache[idx]) {
+        pending.push_back(idx);
+      }
+    }
 
-      if (option.enabled_fastly_exit) {
-        spdlog::info("{} fastly exit since check failed", option.binary);
-        result.final_passed  = false;
-        result.fastly_exited = true;
-        return;
+    // Consecutive files are grouped into batches, each batch is checked by
+    // one clang-tidy invocation.
+    auto tasks            = std::vector<tool_task>{};
+    const auto batch_size = std::size_t{option.batch_size};
+    for (auto begin = std::size_t{0}; begin < pending.size(); begin += batch_size) {
+      auto count   = std::min(batch_size, pending.size() - begin);
+      auto indices = std::vector<std::size_t>(pending.begin() + begin,
+                                              pending.begin() + begin + count);
+      auto task    = tool_task{};
+      for (auto idx: indices) {
+        task.cost += estimate_file_cost(context.repo_path, checked[idx]) * cost_weight;
+      }
+      task.name = std::format("{} {}", name(), checked[indices.front()]);
+      if (indices.size() > 1) {
+        task.name += std::format(" and {} more", indices.size() - 1);
       }
+      task.skip = [this, indices] {
+        for (auto idx: indices) {
+          state->slots.set_skipped(idx);
+        }
+      };
+      task.run = [this, &context, indices = std::move(indices)] {
+        auto &slots = state->slots;
+        if (option.enabled_fastly_exit && slots.after_failed(indices.front())) {
+          for (auto idx: indices) {
+            slots.set_skipped(idx);
+          }
+          return;
+        }
+        try {
+          auto batch = indices
+                     | std::views::transform([&](auto idx) { return state->files[idx]; })
+                     | std::ranges::to<std::vector<std::string>>();
+          auto batch_results = check_batch(context, context.repo_path, batch);
+          for (auto offset = std::size_t{0}; offset < indices.size(); ++offset) {
+            set_result(indices[offset], std::move(batch_results[offset]));
+          }
+        } catch (const shell::timeout_error &) {
+          for (auto idx: indices) {
+            slots.set_timed_out(idx);
+          }
+        } catch (const shell::killed_error &) {
+          for (auto idx: indices) {
+            slots.set_skipped(idx);
+          }
+        } catch (...) {
+          slots.set_error(indices.front(), std::current_exception());
+        }
+      };
+      tasks.push_back(std::move(task));
     }
+    return tasks;
+  }
 
-    result.final_passed = result.fails.empty();
+  void clang_tidy_general::finalize(const runtime_context &context) {
+    // Results were cached and deduplicated as they were set. Fastly exit only
+    // keeps the files up to the first failed one, which may have dropped the
+    // diagnostics kept by files after it.
+    auto &slots = state->slots;
+    if (option.enabled_fastly_exit && slots.any_failed()) {
+      reported = deduplicate_kept(slots.results, state->dropped, slots.first_failed.load());
+    }
+    slots.merge(state->files,
+                result,
+                option.enabled_fastly_exit,
+                context.allow_timed_out,
+                option.binary,
+                [](std::size_t, const per_file_result &) {});
+    state.reset();
+  }
+
+  void clang_tidy_general::set_result(std::size_t idx, per_file_result res) {
+    // Duplicates are dropped after results are cached, since the files
+    // checked together may differ in next run.
+    if (state->keys[idx] && !state->from_cache[idx]) {
+      state->cache.store(*state->keys[idx], res);
+    }
+    auto dropped = std::size_t{0};
+    {
+      auto lock = std::scoped_lock{reported_mutex};
+      dropped   = reported.drop_reported(res.diags, &state->dropped[idx]);
+    }
+    if (dropped != 0) {
+      spdlog::info("Drop {} diagnostics of {} reported by other files", dropped, res.file_path);
+    }
+    state->slots.set(idx, std::move(res));
   }
 
   auto clang_tidy_general::get_reporter() -> reporter_base_ptr {
     return std::make_unique<reporter_t>(option, result);
   }
 
+  auto clang_tidy_general::dump_result() -> nlohmann::json {
+    return result;
+  }
+
+  void clang_tidy_general::merge_result(const runtime_context &context,
+                                        const nlohmann::json &value) {
+    auto other = value.get<result_t>();
+    auto files = std::views::keys(other.fails) | std::ranges::to<std::vector<std::string>>();
+    for (const auto &file: std::views::keys(other.passes)) {
+      files.push_back(file);
+    }
+    std::ranges::sort(files);
+    drop_reported_diagnostics(reported, other, files);
+    merge_results(result, std::move(other), context.allow_timed_out);
+  }
+
 } // namespace linter::tool::clang_tidy
@@ -15,15 +15,25 @@
  */
 #pragma once
 
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <system_error>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <spdlog/spdlog.h>
 
 #include "tools/base_tool.h"
+#include "tools/clang_tidy/general/diagnostic_index.h"
 #include "tools/clang_tidy/general/option.h"
 #include "tools/clang_tidy/general/result.h"
+#include "tools/result_cache.h"
+#include "tools/scheduler.h"
 
 namespace linter::tool::clang_tidy {
   struct clang_tidy_general : tool_base {
@@ -47,12 +57,105 @@ namespace linter::tool::clang_tidy {
                            const std::string &root_dir,
                            const std::string &file) const -> per_file_result;
 
-    void check(const runtime_context &context) override;
+    /// Check several files by one clang-tidy invocation. The returned results
+    /// have the same order as the given files.
+    auto check_batch(const runtime_context &context,
+                     const std::string &root_dir,
+                     std::span<const std::string> files) const -> std::vector<per_file_result>;
+
+    /// Check a file of target revision and return its diagnostics, which are
+    /// the pre-existing ones. Return std::nullopt if the file doesn't exist in
+    /// target revision. The results are cached by the blob id of the file.
+    auto check_baseline(const runtime_context &context,
+                        const std::string &root_dir,
+                        const std::string &file) const -> std::optional<diagnostics>;
+
+    void warm_up(const runtime_context &context) override;
+
+    auto source_filter_iregex() -> const std::string & override {
+      return option.source_filter_iregex;
+    }
+
+    auto prepare(const runtime_context &context, const classified_files &files)
+      -> std::vector<tool_task> override;
+
+    void finalize(const runtime_context &context) override;
+
+    auto failed() -> bool override {
+      return state != nullptr && state->slots.any_failed();
+    }
+
+    auto jobs() -> std::size_t override {
+      return option.jobs;
+    }
 
     auto get_reporter() -> reporter_base_ptr override;
 
+    auto dump_result() -> nlohmann::json override;
+
+    void merge_result(const runtime_context &context, const nlohmann::json &value) override;
+
+    /// Keep the result of a file, which may be called by several tasks. The
+    /// result is cached as checked, then the diagnostics reported by other
+    /// files are dropped before the slots publish it, so the result stream,
+    /// the check run and the reports see each diagnostic once.
+    void set_result(std::size_t idx, per_file_result res);
+
+    /// The staged contents of files overlaid onto the working tree.
+    struct staged_overlay {
+      /// The temporary directory holding the overlay and the staged copies.
+      std::filesystem::path dir;
+      /// The VFS overlay file passed to clang-tidy.
+      std::filesystem::path file;
+      /// The staged copies keyed by the absolute paths of the files.
+      std::unordered_map<std::string, std::filesystem::path> copies;
+    };
+
+    /// The state shared by prepare, tasks and finalize of one check.
+    struct check_state {
+      check_state(std::vector<std::string> checked_files, result_cache file_cache)
+        : files(std::move(checked_files))
+        , keys(files.size())
+        , from_cache(files.size(), false)
+        , slots(files.size())
+        , dropped(files.size())
+        , cache(std::move(file_cache)) {
+      }
+
+      check_state(const check_state &)            = delete;
+      check_state &operator=(const check_state &) = delete;
+
+      ~check_state() {
+        if (!vfs_overlay.dir.empty()) {
+          auto ec = std::error_code{};
+          std::filesystem::remove_all(vfs_overlay.dir, ec);
+        }
+      }
+
+      std::vector<std::string> files;
+      std::vector<std::optional<std::string>> keys;
+      std::vector<bool> from_cache;
+      file_slots<per_file_result> slots;
+      /// The diagnostics of each file dropped since other files reported them.
+      std::vector<diagnostics> dropped;
+      result_cache cache;
+      /// The tool fingerprint of checking baselines, empty if not cached.
+      std::string baseline_fingerprint;
+      /// The generated line filter shared by all batches, made before they
+      /// run since patches mustn't be read by several threads.
+      std::string line_filter;
+      /// The VFS overlay which maps files to their staged contents, empty
+      /// unless staged changes are checked.
+      staged_overlay vfs_overlay;
+    };
+
     option_t option;
     result_t result;
+    std::unique_ptr<check_state> state;
+    /// The diagnostics kept in result, so ones of headers reported by several
+    /// translation units are kept once.
+    diagnostic_index reported;
+    std::mutex reported_mutex;
   };
 
 } // namespace linter::tool::clang_tidy
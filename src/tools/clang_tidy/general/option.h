@@ -15,12 +15,27 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
 #include "tools/base_option.h"
 
 namespace linter::tool::clang_tidy {
   struct option_t : option_base {
     bool allow_no_checks      = false;
     bool enable_check_profile = false;
+    std::uint32_t jobs        = std::max(1U, std::thread::hardware_concurrency());
+    std::uint32_t batch_size  = 1;
+    bool auto_line_filter     = false;
+    bool export_fixes         = false;
+    bool check_dependents     = false;
+    bool baseline             = false;
+    // The stdout of clang-tidy is parsed while being read, only this many
+    // bytes of it are kept in results for debugging.
+    std::uint32_t max_output_size = 64 * 1024;
+    // The seconds each clang-tidy invocation may take, 0 means unlimited.
+    std::uint32_t timeout = 0;
     std::string checks;
     std::string config;
     std::string config_file;
@@ -0,0 +1,620 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/clang_tidy/general/parser.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <initializer_list>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "utils/log.h"
+#include "utils/string_pool.h"
+#include "utils/util.h"
+
+namespace linter::tool::clang_tidy {
+  using namespace std::string_view_literals;
+
+  namespace {
+    constexpr auto supported_serverity = {"warning"sv, "info"sv, "error"sv};
+
+    // Call the given function on each line of text without copying. The
+    // trailing carriage return of a line is dropped.
+    void for_each_line(std::string_view text, auto func) {
+      while (!text.empty()) {
+        auto end  = text.find('\n');
+        auto line = text.substr(0, end);
+        if (line.ends_with('\r')) {
+          line.remove_suffix(1);
+        }
+        func(line);
+        if (end == std::string_view::npos) {
+          break;
+        }
+        text.remove_prefix(end + 1);
+      }
+    }
+
+    auto is_digits(std::string_view str) -> bool {
+      return !str.empty() && std::ranges::all_of(str, [](char c) { return std::isdigit(c) != 0; });
+    }
+
+    // A cursor which consumes a line from left to right.
+    struct scanner {
+      std::string_view rest;
+
+      auto consume(std::string_view literal) -> bool {
+        if (!rest.starts_with(literal)) {
+          return false;
+        }
+        rest.remove_prefix(literal.size());
+        return true;
+      }
+
+      // Consume a word and its optional plural suffix 's'.
+      auto consume_word(std::string_view word) -> bool {
+        if (!consume(word)) {
+          return false;
+        }
+        consume("s");
+        return true;
+      }
+
+      auto consume_number(std::uint32_t &value) -> bool {
+        const auto *end  = rest.data() + rest.size();
+        auto [ptr, errc] = std::from_chars(rest.data(), end, value);
+        if (errc != std::errc{}) {
+          return false;
+        }
+        rest.remove_prefix(ptr - rest.data());
+        return true;
+      }
+    };
+
+    // Parse one line of clang-tidy stderr. Lines which aren't statistic are
+    // ignored. Supported lines:
+    //   N warning(s) generated.
+    //   N error(s) generated.
+    //   N warning(s) and M error(s) generated.
+    //   N warning(s) treated as errors
+    //   Suppressed N warning(s) (M in non-user code).
+    //   Suppressed N warning(s) (M in non-user code, K NOLINT).
+    void parse_stderr_line(std::string_view line, statistic &stat) {
+      auto scan   = scanner{line};
+      auto first  = std::uint32_t{0};
+      auto second = std::uint32_t{0};
+      auto third  = std::uint32_t{0};
+
+      if (scan.consume("Suppressed ")) {
+        if (!scan.consume_number(first)
+            || !scan.consume(" ")
+            || !scan.consume_word("warning")
+            || !scan.consume(" (")
+            || !scan.consume_number(second)
+            || !scan.consume(" in non-user code")) {
+          return;
+        }
+        if (scan.consume(").")) {
+          LINTER_TRACE(" Result: Suppressed {} warnings ({} in non-user code).", first, second);
+          stat.total_suppressed_warnings = first;
+          stat.non_user_code_warnings    = second;
+        } else if (scan.consume(", ") && scan.consume_number(third) && scan.consume(" NOLINT).")) {
+          LINTER_TRACE(" Result: Suppressed {} warnings ({} in non-user code, {} NOLINT).",
+                       first,
+                       second,
+                       third);
+          stat.total_suppressed_warnings = first;
+          stat.non_user_code_warnings    = second;
+          stat.no_lint_warnings          = third;
+        }
+        return;
+      }
+
+      if (!scan.consume_number(first) || !scan.consume(" ")) {
+        return;
+      }
+      if (scan.consume_word("error")) {
+        if (scan.consume(" generated.")) {
+          LINTER_TRACE(" Result: {} error(s) generated.", first);
+          stat.errors = first;
+        }
+        return;
+      }
+      if (!scan.consume_word("warning")) {
+        return;
+      }
+      if (scan.consume(" generated.")) {
+        LINTER_TRACE(" Result: {} warning(s) generated.", first);
+        stat.warnings = first;
+      } else if (scan.consume(" treated as errors")) {
+        LINTER_TRACE(" Result: {} warnings treated as errors", first);
+        stat.warnings_treated_as_errors = first;
+      } else if (scan.consume(" and ")
+                 && scan.consume_number(second)
+                 && scan.consume(" ")
+                 && scan.consume_word("error")
+                 && scan.consume(" generated.")) {
+        LINTER_TRACE(" Result: {} warnings and {} error(s) generated.", first, second);
+        stat.warnings = first;
+        stat.errors   = second;
+      }
+    }
+
+    // Fold a line break inside a quoted YAML scalar, the position is right
+    // after the line break. A single line break becomes a space while each
+    // following empty line becomes a line break.
+    void fold_line_break(std::string_view text, std::size_t &pos, std::string &out) {
+      while (out.ends_with(' ') || out.ends_with('\t')) {
+        out.pop_back();
+      }
+      auto empty_lines = std::size_t{0};
+      while (pos < text.size()) {
+        if (text[pos] == ' ' || text[pos] == '\t') {
+          ++pos;
+        } else if (text[pos] == '\n') {
+          ++empty_lines;
+          ++pos;
+        } else {
+          break;
+        }
+      }
+      out.append(empty_lines == 0 ? std::string(1, ' ') : std::string(empty_lines, '\n'));
+    }
+
+    void append_utf8(std::uint32_t code, std::string &out) {
+      if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+      } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+      } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+      } else {
+        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+      }
+    }
+
+    // Read a single quoted scalar, the position is right after the opening
+    // quote and will be moved to right after the closing quote.
+    auto read_single_quoted(std::string_view text, std::size_t &pos) -> std::string {
+      auto out = std::string{};
+      while (pos < text.size()) {
+        auto c = text[pos++];
+        if (c == '\'') {
+          if (pos < text.size() && text[pos] == '\'') {
+            out.push_back('\'');
+            ++pos;
+            continue;
+          }
+          return out;
+        }
+        if (c == '\n') {
+          fold_line_break(text, pos, out);
+          continue;
+        }
+        out.push_back(c);
+      }
+      throw std::runtime_error{"unterminated single quoted scalar in export fixes"};
+    }
+
+    // Read a double quoted scalar, the position is right after the opening
+    // quote and will be moved to right after the closing quote.
+    auto read_double_quoted(std::string_view text, std::size_t &pos) -> std::string {
+      auto out = std::string{};
+      while (pos < text.size()) {
+        auto c = text[pos++];
+        if (c == '"') {
+          return out;
+        }
+        if (c == '\n') {
+          fold_line_break(text, pos, out);
+          continue;
+        }
+        if (c != '\\' || pos == text.size()) {
+          out.push_back(c);
+          continue;
+        }
+
+        auto escaped = text[pos++];
+        switch (escaped) {
+        case 'n' : out.push_back('\n'); break;
+        case 't' : out.push_back('\t'); break;
+        case 'r' : out.push_back('\r'); break;
+        case '0' : out.push_back('\0'); break;
+        case 'a' : out.push_back('\a'); break;
+        case 'b' : out.push_back('\b'); break;
+        case 'e' : out.push_back('\x1B'); break;
+        case 'f' : out.push_back('\f'); break;
+        case 'v' : out.push_back('\v'); break;
+        case '\n': {
+          // An escaped line break is dropped together with leading spaces of
+          // the next line.
+          while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) {
+            ++pos;
+          }
+          break;
+        }
+        case 'x':
+        case 'u':
+        case 'U': {
+          auto len  = escaped == 'x' ? 2 : (escaped == 'u' ? 4 : 8);
+          auto code = std::uint32_t{0};
+          auto hex  = text.substr(pos, len);
+          auto [ptr, errc] = std::from_chars(hex.data(), hex.data() + hex.size(), code, 16);
+          throw_if(errc != std::errc{} || ptr != hex.data() + len,
+                   "invalid escaped character in export fixes");
+          append_utf8(code, out);
+          pos += len;
+          break;
+        }
+        default: out.push_back(escaped); break;
+        }
+      }
+      throw std::runtime_error{"unterminated double quoted scalar in export fixes"};
+    }
+
+    // The enclosing mapping keys of a YAML line with their indents.
+    using yaml_path = std::vector<std::pair<std::size_t, std::string_view>>;
+
+    auto is_path(const yaml_path &path, std::initializer_list<std::string_view> keys) -> bool {
+      return std::ranges::equal(path | std::views::values, keys);
+    }
+
+    // Read the block style YAML emitted by clang-tidy line by line. on_item is
+    // called with the path of a list when a new item of it starts and on_value
+    // is called for each "key: value" line with the path of the key. Flow
+    // style collections and anchors aren't supported since clang-tidy never
+    // emits them.
+    void read_yaml(std::string_view yaml, auto on_item, auto on_value) {
+      auto path = yaml_path{};
+      auto pos  = std::size_t{0};
+      while (pos < yaml.size()) {
+        auto line_end = std::min(yaml.find('\n', pos), yaml.size());
+        auto line     = yaml.substr(pos, line_end - pos);
+        auto indent   = line.find_first_not_of(' ');
+        if (indent == std::string_view::npos
+            || line[indent] == '#'
+            || line.starts_with("---")
+            || line.starts_with("...")) {
+          pos = line_end + 1;
+          continue;
+        }
+
+        auto cur = pos + indent;
+        if (yaml[cur] == '-' && (cur + 1 == line_end || yaml[cur + 1] == ' ')) {
+          cur = std::min(yaml.find_first_not_of(' ', cur + 1), line_end);
+          // The keys of the item are indented deeper than the dash.
+          indent = cur - pos;
+          while (!path.empty() && path.back().first >= indent) {
+            path.pop_back();
+          }
+          on_item(path);
+          if (cur == line_end) {
+            pos = line_end + 1;
+            continue;
+          }
+        }
+
+        auto colon = yaml.find(':', cur);
+        if (colon >= line_end) {
+          // Plain scalars in lists aren't used by clang-tidy.
+          pos = line_end + 1;
+          continue;
+        }
+        auto key = trim_right(yaml.substr(cur, colon - cur));
+        while (!path.empty() && path.back().first >= indent) {
+          path.pop_back();
+        }
+
+        cur = std::min(yaml.find_first_not_of(' ', colon + 1), line_end);
+        auto value = std::string{};
+        if (cur < line_end && yaml[cur] == '\'') {
+          value = read_single_quoted(yaml, ++cur);
+        } else if (cur < line_end && yaml[cur] == '"') {
+          value = read_double_quoted(yaml, ++cur);
+        } else {
+          auto plain = yaml.substr(cur, line_end - cur);
+          plain      = plain.substr(0, plain.find(" #"));
+          value      = trim_right(plain);
+        }
+        on_value(path, key, std::move(value));
+        path.emplace_back(indent, key);
+
+        // A quoted scalar may span several lines.
+        pos = std::min(yaml.find('\n', cur), yaml.size()) + 1;
+      }
+    }
+
+    auto to_number(std::string_view str) -> std::uint32_t {
+      auto value = std::uint32_t{0};
+      std::from_chars(str.data(), str.data() + str.size(), value);
+      return value;
+    }
+
+    auto to_serverity(std::string_view level) -> std::string_view {
+      if (level == "Error") {
+        return "error";
+      }
+      if (level == "Remark") {
+        return "info";
+      }
+      return "warning";
+    }
+
+
+    // The columns of a profile table, e.g.
+    //   ---User Time---   --System Time--   --User+System--   ---Wall Time---  --- Name ---
+    struct profile_columns {
+      std::optional<std::size_t> user;
+      std::optional<std::size_t> system;
+      std::optional<std::size_t> user_system;
+      std::optional<std::size_t> wall;
+    };
+
+    auto parse_profile_header(std::string_view line) -> std::optional<profile_columns> {
+      if (!line.contains("--- Name ---")) {
+        return std::nullopt;
+      }
+      // Columns are ordered by their positions in the header line.
+      auto names = std::array{"User Time"sv, "System Time"sv, "User+System"sv, "Wall Time"sv};
+      auto found = std::vector<std::pair<std::size_t, std::size_t>>{};
+      for (auto idx = std::size_t{0}; idx < names.size(); ++idx) {
+        if (auto pos = line.find(names[idx]); pos != std::string_view::npos) {
+          found.emplace_back(pos, idx);
+        }
+      }
+      std::ranges::sort(found);
+
+      auto columns = profile_columns{};
+      auto fields  = std::array{&columns.user, &columns.system, &columns.user_system, &columns.wall};
+      for (auto column = std::size_t{0}; column < found.size(); ++column) {
+        *fields[found[column].second] = column;
+      }
+      return columns;
+    }
+
+    // Parse a row of profile table, e.g.
+    //   0.0012 ( 0.1%)   0.0001 ( 0.0%)   0.0013 ( 0.1%)   0.0013 ( 0.1%)  readability-foo
+    // Return the values of all columns and the name.
+    auto parse_profile_row(std::string_view line)
+      -> std::optional<std::pair<std::vector<double>, std::string_view>> {
+      auto values = std::vector<double>{};
+      while (true) {
+        line             = trim_left(line);
+        auto value       = 0.0;
+        auto [ptr, errc] = std::from_chars(line.data(), line.data() + line.size(), value);
+        if (errc != std::errc{}) {
+          break;
+        }
+        line.remove_prefix(ptr - line.data());
+        line = trim_left(line);
+        if (!line.starts_with('(')) {
+          return std::nullopt;
+        }
+        auto close = line.find(')');
+        if (close == std::string_view::npos) {
+          return std::nullopt;
+        }
+        line.remove_prefix(close + 1);
+        values.push_back(value);
+      }
+      auto name = trim_right(line);
+      if (values.empty() || name.empty()) {
+        return std::nullopt;
+      }
+      return std::pair{std::move(values), name};
+    }
+
+  } // namespace
+
+  auto parse_diagnostic_header(std::string_view line) -> std::optional<diagnostic_header> {
+    // file_name:row:col: serverity: brief [diagnostic_type]
+    auto parts = std::array<std::string_view, 5>{};
+    auto rest  = line;
+    for (auto idx = std::size_t{0}; idx < parts.size() - 1; ++idx) {
+      auto colon = rest.find(':');
+      if (colon == std::string_view::npos) {
+        return std::nullopt;
+      }
+      parts[idx] = rest.substr(0, colon);
+      rest.remove_prefix(colon + 1);
+    }
+    if (rest.find(':') != std::string_view::npos) {
+      return std::nullopt;
+    }
+    parts.back() = rest;
+
+    auto [file_name, row_idx, col_idx, serverity, diagnostic_type] = parts;
+    serverity = trim_left(serverity);
+
+    if (!is_digits(row_idx) || !is_digits(col_idx)) {
+      return std::nullopt;
+    }
+    if (!std::ranges::contains(supported_serverity, serverity)) {
+      return std::nullopt;
+    }
+
+    auto square_brackets = diagnostic_type.find('[');
+    if ((square_brackets == std::string_view::npos)
+        || (diagnostic_type.size() < 3)
+        || (diagnostic_type.back() != ']')) {
+      return std::nullopt;
+    }
+
+    auto &pool             = string_pool::instance();
+    auto header            = diagnostic_header{};
+    header.file_name       = pool.intern(file_name);
+    header.row_idx         = to_number(row_idx);
+    header.col_idx         = to_number(col_idx);
+    header.serverity       = pool.intern(serverity);
+    header.brief           = pool.intern(diagnostic_type.substr(0, square_brackets));
+    header.diagnostic_type = pool.intern(diagnostic_type.substr(square_brackets));
+    return header;
+  }
+
+  void stdout_parser::parse_line(std::string_view line) {
+    LINTER_TRACE("Parsing: {}", line);
+    if (auto header = parse_diagnostic_header(line)) {
+      LINTER_TRACE(" Result: {}:{}:{}: {}:{}{}",
+                   header->file_name,
+                   header->row_idx,
+                   header->col_idx,
+                   header->serverity,
+                   header->brief,
+                   header->diagnostic_type);
+      flush_details();
+      diags_.emplace_back(std::move(*header));
+      return;
+    }
+    if (!diags_.empty()) {
+      details_.append(line).push_back('\n');
+    }
+  }
+
+  // The details are stored once all lines of them are parsed.
+  void stdout_parser::flush_details() {
+    if (!diags_.empty() && !details_.empty()) {
+      diags_.back().details = string_pool::instance().store(details_);
+    }
+    details_.clear();
+  }
+
+  auto stdout_parser::take() -> diagnostics {
+    flush_details();
+    spdlog::info("Parsed clang tidy stdout, got {} diagnostics.", diags_.size());
+    return std::exchange(diags_, {});
+  }
+
+  auto parse_stdout(std::string_view std_out) -> diagnostics {
+    auto parser = stdout_parser{};
+    for_each_line(std_out, [&](std::string_view line) { parser.parse_line(line); });
+    return parser.take();
+  }
+
+  auto parse_stderr(std::string_view std_err) -> statistic {
+    auto stat = statistic{};
+    for_each_line(std_err, [&](std::string_view line) {
+      LINTER_TRACE("Parsing: {}", line);
+      parse_stderr_line(line, stat);
+    });
+    return stat;
+  }
+
+  auto parse_check_profile(std::string_view std_err) -> std::vector<check_profile> {
+    auto profiles = std::vector<check_profile>{};
+    auto columns  = std::optional<profile_columns>{};
+    for_each_line(std_err, [&](std::string_view line) {
+      if (auto header = parse_profile_header(line)) {
+        columns = header;
+        profiles.emplace_back();
+        return;
+      }
+      if (!columns) {
+        return;
+      }
+      auto row = parse_profile_row(line);
+      if (!row) {
+        // The table ends at the first line which isn't a row.
+        columns.reset();
+        return;
+      }
+      const auto &[values, name] = *row;
+      if (name == "Total") {
+        return;
+      }
+      auto value_of = [&](std::optional<std::size_t> column) {
+        return column && *column < values.size() ? values[*column] : 0.0;
+      };
+      auto time = check_time{.name = std::string{name}, .wall = 0.0, .cpu = 0.0};
+      time.wall = value_of(columns->wall);
+      time.cpu  = columns->user_system ? value_of(columns->user_system)
+                                       : value_of(columns->user) + value_of(columns->system);
+      profiles.back().push_back(std::move(time));
+    });
+    return profiles;
+  }
+
+  auto parse_export_fixes(std::string_view yaml) -> diagnostics {
+    static const auto diagnostics_path  = {"Diagnostics"sv};
+    static const auto message_path      = {"Diagnostics"sv, "DiagnosticMessage"sv};
+    static const auto replacements_path = {
+      "Diagnostics"sv, "DiagnosticMessage"sv, "Replacements"sv};
+
+    auto diags   = diagnostics{};
+    auto on_item = [&](const yaml_path &path) {
+      if (is_path(path, diagnostics_path)) {
+        diags.emplace_back().header.serverity = "warning";
+      } else if (!diags.empty() && is_path(path, replacements_path)) {
+        diags.back().fixes.emplace_back();
+      }
+    };
+
+    auto on_value = [&](const yaml_path &path, std::string_view key, std::string value) {
+      if (diags.empty()) {
+        return;
+      }
+      auto &diag = diags.back();
+      if (is_path(path, diagnostics_path)) {
+        if (key == "DiagnosticName") {
+          diag.header.diagnostic_type = string_pool::instance().intern(std::format("[{}]", value));
+        } else if (key == "Level") {
+          diag.header.serverity = to_serverity(value);
+        }
+      } else if (is_path(path, message_path)) {
+        if (key == "Message") {
+          diag.header.brief = string_pool::instance().intern(std::format(" {} ", value));
+        } else if (key == "FilePath") {
+          diag.header.file_name = string_pool::instance().intern(value);
+        } else if (key == "FileOffset") {
+          diag.file_offset = to_number(value);
+        }
+      } else if (is_path(path, replacements_path) && !diag.fixes.empty()) {
+        auto &fix = diag.fixes.back();
+        if (key == "FilePath") {
+          fix.file_path = std::move(value);
+        } else if (key == "Offset") {
+          fix.offset = to_number(value);
+        } else if (key == "Length") {
+          fix.length = to_number(value);
+        } else if (key == "ReplacementText") {
+          fix.replacement_text = std::move(value);
+        }
+      }
+    };
+
+    read_yaml(yaml, on_item, on_value);
+    spdlog::info("Parsed clang tidy exported fixes, got {} diagnostics.", diags.size());
+    return diags;
+  }
+
+} // namespace linter::tool::clang_tidy
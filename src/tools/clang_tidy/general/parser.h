@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tools/clang_tidy/general/result.h"
+
+namespace linter::tool::clang_tidy {
+  /// Parse the header line of a clang-tidy diagnostic. Return std::nullopt if
+  /// the given line isn't a header line.
+  auto parse_diagnostic_header(std::string_view line) -> std::optional<diagnostic_header>;
+
+  /// Parse the diagnostics from the stdout of clang-tidy line by line, so the
+  /// stdout could be parsed while it's being read from the pipe. Lines
+  /// following a header line, until the next header line, are the details of
+  /// it.
+  class stdout_parser {
+  public:
+    void parse_line(std::string_view line);
+
+    /// Take the parsed diagnostics out.
+    [[nodiscard]] auto take() -> diagnostics;
+
+  private:
+    void flush_details();
+
+    diagnostics diags_;
+    /// The details of the last diagnostic which are still being parsed.
+    std::string details_;
+  };
+
+  /// Parse the diagnostics from the whole stdout of clang-tidy.
+  auto parse_stdout(std::string_view std_out) -> diagnostics;
+
+  /// Parse the statistic from the stderr of clang-tidy.
+  auto parse_stderr(std::string_view std_err) -> statistic;
+
+  /// Parse the profile tables printed to stderr by clang-tidy
+  /// --enable-check-profile. Each translation unit has its own table, so one
+  /// profile is returned for each table in order.
+  auto parse_check_profile(std::string_view std_err) -> std::vector<check_profile>;
+
+  /// Parse the YAML file exported by clang-tidy --export-fixes. Only the
+  /// subset of YAML emitted by clang-tidy is supported. The row and column of
+  /// the returned diagnostics are left empty since only the file offset is
+  /// exported.
+  auto parse_export_fixes(std::string_view yaml) -> diagnostics;
+
+} // namespace linter::tool::clang_tidy
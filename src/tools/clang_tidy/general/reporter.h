@@ -15,6 +15,19 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
 #include "context.h"
 #include "github/common.h"
 #include "github/utils.h"
@@ -34,7 +47,11 @@ namespace linter::tool::clang_tidy {
       , result(std::move(res)) {
     }
 
-    auto make_brief() -> std::string {
+    // Shared by the issue comment and the step summary, so it's made once.
+    auto make_brief() -> const std::string & {
+      if (brief) {
+        return *brief;
+      }
       // TODO: replace diagnostic_type with linkable name
       auto ret = ""s;
       for (const auto &[name, failed]: result.fails) {
@@ -51,7 +68,10 @@ namespace linter::tool::clang_tidy {
           ret += one;
         }
       }
-      return ret;
+      for (const auto &file: result.timed_out) {
+        ret += std::format("- **{}:** timed out\n", file);
+      }
+      return brief.emplace(std::move(ret));
     }
 
     auto make_issue_comment([[maybe_unused]] const runtime_context &context)
@@ -59,9 +79,104 @@ namespace linter::tool::clang_tidy {
       return make_brief();
     }
 
+    /// Aggregate the check profiles of all files, checks and files are ranked
+    /// by wall time in descending order.
+    auto make_profile_report() const -> nlohmann::json {
+      struct total {
+        double wall       = 0.0;
+        double cpu        = 0.0;
+        std::size_t files = 0;
+      };
+      auto checks = std::unordered_map<std::string, total>{};
+      auto files  = std::unordered_map<std::string, total>{};
+      for (const auto *results: {&result.passes, &result.fails}) {
+        for (const auto &[file, per_file_result]: *results) {
+          for (const auto &time: per_file_result.profile) {
+            auto &check       = checks[time.name];
+            check.wall       += time.wall;
+            check.cpu        += time.cpu;
+            check.files      += 1;
+            files[file].wall += time.wall;
+            files[file].cpu  += time.cpu;
+          }
+        }
+      }
+
+      auto rank = [](const std::unordered_map<std::string, total> &totals, bool with_files) {
+        auto items = totals | std::ranges::to<std::vector<std::pair<std::string, total>>>();
+        std::ranges::sort(items, std::ranges::greater{}, [](const auto &item) {
+          return item.second.wall;
+        });
+        auto ret = nlohmann::json::array();
+        for (const auto &[name, value]: items) {
+          auto item = nlohmann::json{
+            {"name", name},
+            {"wall", value.wall},
+            {"cpu", value.cpu}
+          };
+          if (with_files) {
+            item["files"] = value.files;
+          }
+          ret.push_back(std::move(item));
+        }
+        return ret;
+      };
+      return {
+        {"checks", rank(checks, true)},
+        {"files", rank(files, false)}
+      };
+    }
+
+    auto make_profile_summary(std::size_t num_slowest = 10) const -> std::string {
+      const auto report  = make_profile_report();
+      const auto &checks = report["checks"];
+      const auto &files  = report["files"];
+
+      auto summary = std::string{"### Slowest clang-tidy checks\n\n"};
+      summary.append("| Check | Files | Wall (s) | CPU (s) |\n");
+      summary.append("|-------|-------|----------|---------|\n");
+      for (auto idx = std::size_t{0}; idx < std::min(num_slowest, checks.size()); ++idx) {
+        const auto &check = checks[idx];
+        summary.append(std::format("| {} | {} | {:.3f} | {:.3f} |\n",
+                                   check["name"].get<std::string>(),
+                                   check["files"].get<std::size_t>(),
+                                   check["wall"].get<double>(),
+                                   check["cpu"].get<double>()));
+      }
+
+      summary.append("\n### Slowest files by clang-tidy checks\n\n");
+      summary.append("| File | Wall (s) | CPU (s) |\n");
+      summary.append("|------|----------|---------|\n");
+      for (auto idx = std::size_t{0}; idx < std::min(num_slowest, files.size()); ++idx) {
+        const auto &file = files[idx];
+        summary.append(std::format("| {} | {:.3f} | {:.3f} |\n",
+                                   file["name"].get<std::string>(),
+                                   file["wall"].get<double>(),
+                                   file["cpu"].get<double>()));
+      }
+      return summary;
+    }
+
     auto make_step_summary([[maybe_unused]] const runtime_context &context)
       -> std::string override {
-      return make_brief();
+      if (!option.enable_check_profile) {
+        return make_brief();
+      }
+      return make_brief() + "\n" + make_profile_summary();
+    }
+
+    // Diagnostics of headers are kept by the files including them, so the
+    // path of a diagnostic is resolved from its file name as annotations do.
+    static auto diagnostic_path(std::string_view root_dir,
+                                std::string_view file_name,
+                                const std::string &owner) -> std::string {
+      auto root = std::filesystem::absolute(root_dir).lexically_normal();
+      auto path = std::filesystem::path{file_name};
+      if (path.is_relative()) {
+        path = root / path;
+      }
+      auto ret = path.lexically_normal().lexically_relative(root).string();
+      return ret.empty() || ret.starts_with("..") ? owner : ret;
     }
 
     auto make_review_comment(const runtime_context &context) -> github::review_comments override {
@@ -72,28 +187,25 @@ namespace linter::tool::clang_tidy {
         assert(per_file_result.file_path == file);
         assert(context.patches.contains(file));
 
-        const auto &patch   = context.patches.at(file);
-        const auto num_hunk = git::patch::num_hunks(patch.get());
-
         // For each clang-tidy diagnostic result in current file:
         for (const auto &diag: per_file_result.diags) {
-          auto row = std::stoi(diag.header.row_idx);
-          auto col = std::stoi(diag.header.col_idx);
-
-          // Check current diagnostic is in diff hunk.
-          auto pos = std::size_t{0};
-          for (int hunk_idx = 0; hunk_idx < num_hunk; ++hunk_idx) {
-            auto [hunk, num_lines] = git::patch::get_hunk(patch.get(), hunk_idx);
-            if (!github::is_row_in_hunk(hunk, row)) {
-              pos += num_lines;
-            } else {
-              auto comment     = github::review_comment{};
-              comment.path     = file;
-              comment.position = pos + row - hunk.new_start + 1;
-              comment.body     = diag.header.brief + diag.header.diagnostic_type;
-              comments.emplace_back(std::move(comment));
-            }
+          auto row  = diag.header.row_idx;
+          auto path = diagnostic_path(context.repo_path, diag.header.file_name, file);
+
+          // Only diagnostics in diff hunks could be commented on, so the ones
+          // of unchanged headers are skipped.
+          if (row == 0 || !context.patches.contains(path)) {
+            continue;
+          }
+          auto pos = context.patches.hunks(path).position(row);
+          if (!pos) {
+            continue;
           }
+          auto comment     = github::review_comment{};
+          comment.path     = std::move(path);
+          comment.position = *pos;
+          comment.body     = std::format("{}{}", diag.header.brief, diag.header.diagnostic_type);
+          comments.emplace_back(std::move(comment));
         }
       }
       return comments;
@@ -104,6 +216,10 @@ namespace linter::tool::clang_tidy {
       auto file   = std::fstream{output, std::ios::app};
       throw_unless(file.is_open(), "error to open output file to write");
       file << std::format("clang_tidy_failed_number={}\n", result.fails.size());
+      file << std::format("clang_tidy_timed_out_number={}\n", result.timed_out.size());
+      if (option.enable_check_profile) {
+        file << std::format("clang_tidy_check_profile={}\n", make_profile_report().dump());
+      }
     }
 
     auto get_brief_result() -> std::tuple<bool, std::size_t, std::size_t, std::size_t> override {
@@ -119,8 +235,13 @@ namespace linter::tool::clang_tidy {
       return parts.back();
     }
 
+    auto reviewed_files() -> std::vector<std::string> override {
+      return result.fails | std::views::keys | std::ranges::to<std::vector<std::string>>();
+    }
+
     option_t option;
     result_t result;
+    std::optional<std::string> brief;
   };
 
 } // namespace linter::tool::clang_tidy
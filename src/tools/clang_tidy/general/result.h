@@ -15,9 +15,15 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include <nlohmann/json.hpp>
+
 #include "tools/base_result.h"
+#include "utils/string_pool.h"
 
 namespace linter::tool::clang_tidy {
   /// Represents statistics outputed by clang-tidy. It's usually the stderr
@@ -31,14 +37,26 @@ namespace linter::tool::clang_tidy {
     std::uint32_t no_lint_warnings           = 0;
   };
 
-  /// Each diagnostic hase a header line.
+  /// Each diagnostic hase a header line. Runs with many checks enabled may
+  /// produce lots of diagnostics, so the strings are stored in the string
+  /// pool rather than owned by each diagnostic. The file name, serverity,
+  /// brief and diagnostic type are interned since they are usually repeated.
   struct diagnostic_header {
-    std::string file_name;
-    std::string row_idx;
-    std::string col_idx;
-    std::string serverity;
-    std::string brief;
-    std::string diagnostic_type;
+    std::string_view file_name;
+    std::uint32_t row_idx = 0;
+    std::uint32_t col_idx = 0;
+    std::string_view serverity;
+    std::string_view brief;
+    std::string_view diagnostic_type;
+  };
+
+  /// A suggested fix of a diagnostic. Only available when clang-tidy exports
+  /// fixes.
+  struct fix_it {
+    std::string file_path;
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+    std::string replacement_text;
   };
 
   /// Represents one diagnostic which outputed by clang-tidy.
@@ -46,16 +64,79 @@ namespace linter::tool::clang_tidy {
   /// which give a further detailed explanation.
   struct diagnostic {
     diagnostic_header header;
-    std::string details;
+    /// Stored in the string pool as well.
+    std::string_view details;
+
+    // Only available when clang-tidy exports fixes.
+    std::uint32_t file_offset = 0;
+    std::vector<fix_it> fixes;
   };
 
   /// Represents all diagnostics which outputed by clang-tidy.
   using diagnostics = std::vector<diagnostic>;
 
+  /// The time spent by one check on one translation unit in seconds. Only
+  /// available when check profile is enabled.
+  struct check_time {
+    std::string name;
+    double wall = 0.0;
+    double cpu  = 0.0;
+  };
+
+  using check_profile = std::vector<check_time>;
+
   struct per_file_result : per_file_result_base {
     statistic stat;
     diagnostics diags;
+    check_profile profile;
   };
 
   using result_t = multi_files_result_base<per_file_result>;
+
+  // Used by the result cache.
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(statistic,
+                                     warnings,
+                                     errors,
+                                     warnings_treated_as_errors,
+                                     total_suppressed_warnings,
+                                     non_user_code_warnings,
+                                     no_lint_warnings)
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(fix_it, file_path, offset, length, replacement_text)
+
+  inline void to_json(nlohmann::json &json, const diagnostic &diag) {
+    const auto &header = diag.header;
+    json               = {
+      {"file_name",       header.file_name      },
+      {"row_idx",         header.row_idx        },
+      {"col_idx",         header.col_idx        },
+      {"serverity",       header.serverity      },
+      {"brief",           header.brief          },
+      {"diagnostic_type", header.diagnostic_type},
+      {"details",         diag.details          },
+      {"file_offset",     diag.file_offset      },
+      {"fixes",           diag.fixes            }
+    };
+  }
+
+  inline void from_json(const nlohmann::json &json, diagnostic &diag) {
+    auto &pool  = string_pool::instance();
+    auto intern = [&](const char *key) {
+      return pool.intern(json.at(key).get_ref<const std::string &>());
+    };
+    auto &header           = diag.header;
+    header.file_name       = intern("file_name");
+    header.row_idx         = json.at("row_idx").get<std::uint32_t>();
+    header.col_idx         = json.at("col_idx").get<std::uint32_t>();
+    header.serverity       = intern("serverity");
+    header.brief           = intern("brief");
+    header.diagnostic_type = intern("diagnostic_type");
+    diag.details           = pool.store(json.at("details").get_ref<const std::string &>());
+    diag.file_offset       = json.at("file_offset").get<std::uint32_t>();
+    diag.fixes             = json.at("fixes").get<std::vector<fix_it>>();
+  }
+
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(check_time, name, wall, cpu)
+  // Entries written before a field was added are still readable.
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+    per_file_result, passed, file_path, tool_stdout, tool_stderr, stat, diags, profile)
 } // namespace linter::tool::clang_tidy
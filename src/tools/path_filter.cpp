@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/path_filter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <unordered_map>
+
+namespace linter::tool {
+  namespace {
+    auto to_lower(std::string_view str) -> std::string {
+      return str | std::views::transform([](unsigned char chr) {
+               return static_cast<char>(std::tolower(chr));
+             })
+           | std::ranges::to<std::string>();
+    }
+
+    auto iequals_suffix(std::string_view str, std::string_view lower_suffix) -> bool {
+      if (str.size() < lower_suffix.size()) {
+        return false;
+      }
+      auto tail = str.substr(str.size() - lower_suffix.size());
+      return std::ranges::equal(tail, lower_suffix, {}, [](unsigned char chr) {
+        return static_cast<char>(std::tolower(chr));
+      });
+    }
+
+    // Unescape a regex made of plain characters, e.g. `c\+\+`. Return nothing
+    // if it has any other special character.
+    auto parse_literal(std::string_view regex) -> std::optional<std::string> {
+      static constexpr auto specials = std::string_view{".[]{}()*+?|^$\\"};
+      auto literal                   = std::string{};
+      for (auto idx = std::size_t{0}; idx < regex.size(); ++idx) {
+        auto chr = regex[idx];
+        if (chr == '\\') {
+          if (idx + 1 == regex.size() || specials.find(regex[idx + 1]) == std::string_view::npos) {
+            return std::nullopt;
+          }
+          literal.push_back(regex[++idx]);
+        } else if (specials.find(chr) != std::string_view::npos) {
+          return std::nullopt;
+        } else {
+          literal.push_back(chr);
+        }
+      }
+      return literal;
+    }
+
+    // Parse `.*\.(cpp|h)` or `.*\.cpp` into extensions with the leading dot.
+    auto parse_extensions(std::string_view regex) -> std::optional<std::vector<std::string>> {
+      static constexpr auto prefix = std::string_view{R"(.*\.)"};
+      if (!regex.starts_with(prefix)) {
+        return std::nullopt;
+      }
+      regex.remove_prefix(prefix.size());
+      if (regex.starts_with('(') && regex.ends_with(')')) {
+        regex = regex.substr(1, regex.size() - 2);
+      }
+
+      auto extensions = std::vector<std::string>{};
+      for (auto part: regex | std::views::split('|')) {
+        auto literal = parse_literal(std::string_view{part.begin(), part.end()});
+        if (!literal || literal->empty()) {
+          return std::nullopt;
+        }
+        extensions.push_back("." + to_lower(*literal));
+      }
+      return extensions;
+    }
+  } // namespace
+
+  path_filter::path_filter(const std::string &iregex) {
+    if (auto extensions = parse_extensions(iregex)) {
+      extensions_ = std::move(extensions);
+    } else if (auto literal = parse_literal(iregex)) {
+      literal_ = to_lower(*literal);
+    } else {
+      regex_.emplace(iregex, boost::regex::icase);
+    }
+  }
+
+  auto path_filter::matches(std::string_view file) const -> bool {
+    if (extensions_) {
+      return std::ranges::any_of(*extensions_, [&](const auto &extension) {
+        return iequals_suffix(file, extension);
+      });
+    }
+    if (literal_) {
+      return file.size() == literal_->size() && iequals_suffix(file, *literal_);
+    }
+    return boost::regex_match(file.begin(), file.end(), *regex_);
+  }
+
+  auto compiled_path_filter(const std::string &iregex) -> const path_filter & {
+    static auto mutex   = std::mutex{};
+    static auto filters = std::unordered_map<std::string, std::unique_ptr<path_filter>>{};
+    auto lock           = std::lock_guard{mutex};
+    auto &filter        = filters[iregex];
+    if (filter == nullptr) {
+      filter = std::make_unique<path_filter>(iregex);
+    }
+    return *filter;
+  }
+
+  auto classify_files(const std::vector<std::string> &files,
+                      const std::vector<std::string> &iregexes) -> std::vector<classified_files> {
+    auto filters = iregexes
+                 | std::views::transform([](const auto &iregex) {
+                     return &compiled_path_filter(iregex);
+                   })
+                 | std::ranges::to<std::vector>();
+    auto classes = std::vector<classified_files>(iregexes.size());
+    for (const auto &file: files) {
+      for (auto idx = std::size_t{0}; idx < filters.size(); ++idx) {
+        auto &files_of = filters[idx]->matches(file) ? classes[idx].matched : classes[idx].ignored;
+        files_of.push_back(file);
+      }
+    }
+    return classes;
+  }
+} // namespace linter::tool
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/regex.hpp>
+
+namespace linter::tool {
+  /// A source_filter_iregex compiled once. Files are matched case
+  /// insensitively. The common forms `.*\.(cpp|h)` and literal paths are
+  /// matched by comparing strings, others by the compiled regex.
+  class path_filter {
+  public:
+    explicit path_filter(const std::string &iregex);
+
+    /// Return true if the whole file path is matched, i.e. it's checked.
+    [[nodiscard]] auto matches(std::string_view file) const -> bool;
+
+  private:
+    // The lower case extensions with the leading dot, if the iregex only
+    // matches by extension.
+    std::optional<std::vector<std::string>> extensions_;
+    // The lower case path, if the iregex has no special characters.
+    std::optional<std::string> literal_;
+    std::optional<boost::regex> regex_;
+  };
+
+  /// Return the path filter of the given iregex, which is compiled by the
+  /// first call and shared by all tools and threads after.
+  auto compiled_path_filter(const std::string &iregex) -> const path_filter &;
+
+  /// The changed files split by a path filter, both in the order of changed
+  /// files.
+  struct classified_files {
+    std::vector<std::string> matched;
+    std::vector<std::string> ignored;
+  };
+
+  /// Classify files by all given iregexes in one pass over the files. The
+  /// returned classifications have the same order as the iregexes.
+  auto classify_files(const std::vector<std::string> &files,
+                      const std::vector<std::string> &iregexes) -> std::vector<classified_files>;
+} // namespace linter::tool
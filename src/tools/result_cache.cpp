@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/result_cache.h"
+
+#include <format>
+#include <functional>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+#include "utils/git_utils.h"
+#include "utils/shell.h"
+#include "utils/util.h"
+
+namespace linter::tool {
+  namespace {
+    // The hex string of oid without the null terminator.
+    auto to_hex(const git_oid &oid) -> std::string {
+      return git::oid::to_str(oid).c_str();
+    }
+
+    auto blob_id(git::tree_raw_cptr tree, const std::string &path) -> std::optional<std::string> {
+      auto entry = git::tree::entry_bypath(tree, path);
+      if (entry == nullptr) {
+        return std::nullopt;
+      }
+      return to_hex(*git::tree::entry_id(entry.get()));
+    }
+
+    auto read_file(const std::filesystem::path &path) -> std::optional<std::string> {
+      auto file = std::ifstream{path, std::ios::binary};
+      if (!file.is_open()) {
+        return std::nullopt;
+      }
+      return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+
+    using content_id_fn = std::function<std::optional<std::string>(const std::string &)>;
+
+    auto make_cache_key(const content_id_fn &id_of,
+                        std::string_view fingerprint,
+                        const std::string &file,
+                        std::span<const std::string> config_names,
+                        std::span<const std::string> dependencies) -> std::optional<std::string> {
+      auto id = id_of(file);
+      if (!id) {
+        return std::nullopt;
+      }
+      auto content = std::format("{}\n{}:{}\n", fingerprint, file, *id);
+
+      // Config files are searched from the directory of file up to the root of
+      // repository, the same as the way clang tools find them.
+      auto dir = std::filesystem::path{file}.parent_path();
+      while (true) {
+        for (const auto &name: config_names) {
+          auto config = (dir / name).generic_string();
+          if (auto config_id = id_of(config)) {
+            content += std::format("{}:{}\n", config, *config_id);
+          }
+        }
+        if (dir.empty()) {
+          break;
+        }
+        dir = dir.parent_path();
+      }
+
+      for (const auto &dependency: dependencies) {
+        if (auto dependency_id = id_of(dependency)) {
+          content += std::format("{}:{}\n", dependency, *dependency_id);
+        }
+      }
+      return to_hex(git::oid::hash(content));
+    }
+  } // namespace
+
+  auto tool_version(const std::string &cache_dir, const std::string &binary) -> std::string {
+    static auto mutex    = std::mutex{};
+    static auto versions = std::unordered_map<std::string, std::string>{};
+
+    auto identity = std::string{};
+    if (struct stat info{}; ::stat(binary.c_str(), &info) == 0) {
+      identity = std::format("{}:{}:{}:{}:{}.{}",
+                             binary,
+                             info.st_dev,
+                             info.st_ino,
+                             info.st_size,
+                             info.st_mtim.tv_sec,
+                             info.st_mtim.tv_nsec);
+    }
+    auto lock = std::lock_guard{mutex};
+    if (auto iter = versions.find(identity); !identity.empty() && iter != versions.end()) {
+      return iter->second;
+    }
+    auto cache = result_cache{cache_dir, "tools"};
+    auto key   = std::format("version-{}", to_hex(git::oid::hash(identity)));
+    if (auto cached = identity.empty() ? std::nullopt : cache.load(key)) {
+      return versions[identity] = cached->get<std::string>();
+    }
+
+    auto res = shell::execute(binary, {"--version"});
+    throw_unless(res.exit_code == 0,
+                 std::format("Failed to get the version of {}: {}", binary, res.std_err));
+    if (!identity.empty()) {
+      cache.store(key, res.std_out);
+      versions[identity] = res.std_out;
+    }
+    return res.std_out;
+  }
+
+  auto make_tool_fingerprint(const runtime_context &context,
+                             const std::string &binary,
+                             std::span<const std::string> args,
+                             std::span<const std::string> files) -> std::string {
+    auto content = std::format("{}\n{}\n", binary, tool_version(context.cache_dir, binary));
+    for (const auto &arg: args) {
+      content += arg + "\n";
+    }
+    for (const auto &file: files) {
+      auto path = std::filesystem::path{file};
+      if (path.is_relative()) {
+        path = std::filesystem::path{context.repo_path} / path;
+      }
+      auto data = read_file(path);
+      content  += std::format("{}:{}\n", file, data ? to_hex(git::oid::hash(*data)) : "missing");
+    }
+    return to_hex(git::oid::hash(content));
+  }
+
+  auto make_cache_key(const runtime_context &context,
+                      std::string_view fingerprint,
+                      const std::string &file,
+                      std::span<const std::string> config_names,
+                      std::span<const std::string> dependencies,
+                      content_source_t source) -> std::optional<std::string> {
+    if (source == content_source_t::source_revision) {
+      return make_cache_key(context.source_commit.get(),
+                            fingerprint,
+                            file,
+                            config_names,
+                            dependencies);
+    }
+    auto root = std::filesystem::path{context.repo_path};
+    return make_cache_key(
+      [&root](const std::string &path) -> std::optional<std::string> {
+        return read_file(root / path).transform(
+          [](const std::string &content) { return to_hex(git::oid::hash(content)); });
+      },
+      fingerprint,
+      file,
+      config_names,
+      dependencies);
+  }
+
+  auto make_cache_key(git::commit_raw_cptr commit,
+                      std::string_view fingerprint,
+                      const std::string &file,
+                      std::span<const std::string> config_names,
+                      std::span<const std::string> dependencies) -> std::optional<std::string> {
+    auto tree = git::commit::tree(commit);
+    return make_cache_key(
+      [&tree](const std::string &path) { return blob_id(tree.get(), path); },
+      fingerprint,
+      file,
+      config_names,
+      dependencies);
+  }
+
+} // namespace linter::tool
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+#include "context.h"
+#include "utils/json_cache.h"
+
+namespace linter::tool {
+  /// The cache of per file results, one directory for each tool.
+  using result_cache = json_cache;
+
+  /// Return the output of `binary --version`. The version is cached by the
+  /// identity of the file in process and in the cache directory, so the
+  /// binary isn't spawned for it again until the file is replaced.
+  auto tool_version(const std::string &cache_dir, const std::string &binary) -> std::string;
+
+  /// Make the fingerprint of everything a tool result depends on except the
+  /// checked file itself: the tool binary and its version, the arguments and
+  /// the content of additional files on disk such as the compilation database.
+  auto make_tool_fingerprint(const runtime_context &context,
+                             const std::string &binary,
+                             std::span<const std::string> args,
+                             std::span<const std::string> files) -> std::string;
+
+  /// Where a tool reads the checked file and the files it depends on from.
+  enum class content_source_t : std::uint8_t {
+    source_revision,
+    work_tree,
+  };
+
+  /// Make the cache key of a file from the tool fingerprint, the blob id of the
+  /// file, the blob ids of the config files which may apply to the file and
+  /// the blob ids of other files the result depends on. The ids are those of
+  /// the content the tool actually reads: the blobs in source revision, or
+  /// the files in working tree hashed as blobs, which differ on local runs.
+  /// Return std::nullopt if the file doesn't exist in the given source.
+  auto make_cache_key(const runtime_context &context,
+                      std::string_view fingerprint,
+                      const std::string &file,
+                      std::span<const std::string> config_names,
+                      std::span<const std::string> dependencies,
+                      content_source_t source) -> std::optional<std::string>;
+
+  /// The same as above, but of the file in the given revision rather than
+  /// source revision.
+  auto make_cache_key(git::commit_raw_cptr commit,
+                      std::string_view fingerprint,
+                      const std::string &file,
+                      std::span<const std::string> config_names,
+                      std::span<const std::string> dependencies) -> std::optional<std::string>;
+
+} // namespace linter::tool
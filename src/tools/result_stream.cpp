@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/result_stream.h"
+
+#include <chrono>
+#include <exception>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "utils/util.h"
+
+namespace linter::tool {
+  namespace {
+    // The results array is left open, so results are appended as files are
+    // checked. The tool follows the results since its rules are only known
+    // after all results.
+    constexpr auto sarif_begin =
+      R"({"version":"2.1.0","$schema":"https://json.schemastore.org/sarif-2.1.0.json",)"
+      R"("runs":[{"results":[)";
+
+    auto make_sarif_end(const std::vector<std::string> &rules) -> std::string {
+      auto driver = nlohmann::json{
+        {"name",           "cpp-linter"                         },
+        {"informationUri", "https://github.com/emmett2020/linter"},
+        {"rules",          nlohmann::json::array()              }
+      };
+      for (const auto &rule: rules) {
+        driver["rules"].push_back({
+          {"id",               rule              },
+          {"shortDescription", {{"text", rule}}}
+        });
+      }
+      return R"(],"tool":{"driver":)" + driver.dump() + "}}]}\n";
+    }
+
+    // The title of a clang-tidy annotation is the tool followed by the check
+    // in brackets, e.g. "clang-tidy [misc-unused]", others are the tool only.
+    auto make_rule_id(std::string_view title) -> std::string {
+      auto begin = title.find('[');
+      auto end   = title.rfind(']');
+      if (begin == std::string_view::npos || end == std::string_view::npos || end < begin) {
+        return std::string{title};
+      }
+      return std::string{title.substr(begin + 1, end - begin - 1)};
+    }
+
+    auto sarif_level(std::string_view annotation_level) -> std::string_view {
+      if (annotation_level == "failure") {
+        return "error";
+      }
+      if (annotation_level == "warning") {
+        return "warning";
+      }
+      return "note";
+    }
+
+    auto make_file_record(std::string_view tool,
+                          const per_file_result_base &result,
+                          std::size_t num_diagnostics) -> nlohmann::json {
+      return {
+        {"type",        "file"          },
+        {"tool",        tool            },
+        {"file",        result.file_path},
+        {"passed",      result.passed   },
+        {"diagnostics", num_diagnostics }
+      };
+    }
+
+    auto make_diagnostic_record(std::string_view tool, const github::annotation &diagnostic)
+      -> nlohmann::json {
+      auto record    = nlohmann::json(diagnostic);
+      record["type"] = "diagnostic";
+      record["tool"] = tool;
+      return record;
+    }
+
+    auto make_sarif_result(const github::annotation &diagnostic, const std::string &rule_id)
+      -> nlohmann::json {
+      auto region = nlohmann::json{
+        {"startLine", diagnostic.start_line},
+        {"endLine",   diagnostic.end_line  }
+      };
+      auto location = nlohmann::json{
+        {"physicalLocation",
+         {{"artifactLocation", {{"uri", diagnostic.path}}}, {"region", std::move(region)}}}
+      };
+      auto message = diagnostic.raw_details.empty()
+                     ? diagnostic.message
+                     : std::format("{}\n{}", diagnostic.message, diagnostic.raw_details);
+      auto level = sarif_level(diagnostic.annotation_level);
+      return {
+        {"ruleId",    rule_id                                    },
+        {"level",     level                                      },
+        {"message",   {{"text", std::move(message)}}             },
+        {"locations", nlohmann::json::array({std::move(location)})}
+      };
+    }
+  } // namespace
+
+  result_stream::result_stream(const std::string &file,
+                               format_t format,
+                               std::size_t buffer_size,
+                               std::chrono::milliseconds flush_interval)
+    : out_(file, std::ios::binary | std::ios::trunc)
+    , format_(format)
+    , buffer_size_(buffer_size)
+    , flush_interval_(flush_interval)
+    , last_flush_(std::chrono::steady_clock::now()) {
+    throw_unless(out_.is_open(), std::format("failed to open result file: {}", file));
+    buffer_.reserve(buffer_size_);
+    if (format_ == format_t::sarif) {
+      buffer_ += sarif_begin;
+    }
+  }
+
+  result_stream::~result_stream() {
+    try {
+      close();
+    } catch (const std::exception &err) {
+      spdlog::error("Failed to write result file: {}", err.what());
+    }
+  }
+
+  void result_stream::add(std::string_view tool,
+                          const per_file_result_base &result,
+                          const github::annotations &diagnostics) {
+    // Records are made outside the lock, since tasks finish concurrently.
+    auto records  = std::vector<std::string>{};
+    auto rule_ids = std::vector<std::string>{};
+    records.reserve(diagnostics.size() + 1);
+    if (format_ == format_t::jsonl) {
+      records.push_back(make_file_record(tool, result, diagnostics.size()).dump());
+      for (const auto &diagnostic: diagnostics) {
+        records.push_back(make_diagnostic_record(tool, diagnostic).dump());
+      }
+    } else {
+      for (const auto &diagnostic: diagnostics) {
+        rule_ids.push_back(make_rule_id(diagnostic.title));
+        records.push_back(make_sarif_result(diagnostic, rule_ids.back()).dump());
+      }
+    }
+
+    auto lock = std::lock_guard{mutex_};
+    if (closed_) {
+      return;
+    }
+    for (const auto &record: records) {
+      append(record);
+    }
+    for (auto &rule_id: rule_ids) {
+      if (known_rules_.insert(rule_id).second) {
+        rules_.push_back(std::move(rule_id));
+      }
+    }
+    // Only whole records are written, so the file could be read while it's
+    // written in JSON Lines format. They're written at least once per flush
+    // interval, so records of a slow check aren't held back by the buffer.
+    auto now = std::chrono::steady_clock::now();
+    if (buffer_.size() >= buffer_size_ || now - last_flush_ >= flush_interval_) {
+      flush();
+    }
+  }
+
+  void result_stream::close() {
+    auto lock = std::lock_guard{mutex_};
+    if (closed_) {
+      return;
+    }
+    closed_ = true;
+    if (format_ == format_t::sarif) {
+      buffer_ += make_sarif_end(rules_);
+    }
+    flush();
+    out_.close();
+  }
+
+  void result_stream::append(const std::string &record) {
+    if (format_ == format_t::jsonl) {
+      buffer_ += record;
+      buffer_ += '\n';
+    } else {
+      if (num_results_ != 0) {
+        buffer_ += ',';
+      }
+      buffer_ += record;
+    }
+    ++num_results_;
+  }
+
+  void result_stream::flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_.flush();
+    buffer_.clear();
+    last_flush_ = std::chrono::steady_clock::now();
+    throw_unless(out_.good(), "failed to write result file");
+  }
+
+  auto parse_result_format(std::string_view name) -> result_stream::format_t {
+    if (name == "jsonl") {
+      return result_stream::format_t::jsonl;
+    }
+    throw_unless(name == "sarif", std::format("unsupported result file format: {}", name));
+    return result_stream::format_t::sarif;
+  }
+
+} // namespace linter::tool
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "github/annotation.h"
+#include "tools/base_result.h"
+
+namespace linter::tool {
+  /// Write the result of each file to a file as soon as it's checked, so
+  /// downstream consumers could tail it during long runs rather than scraping
+  /// reports. Records are kept in a buffer of bounded size and written once
+  /// it's full or the flush interval passed, rather than building the whole
+  /// document in memory.
+  ///
+  /// In JSON Lines format, each line is a record of either a checked file or
+  /// one of its diagnostics. In SARIF format, only diagnostics are written as
+  /// results of one run. Their rule ids are the checks, which are listed as
+  /// the rules of the driver when the document is completed by close.
+  class result_stream {
+  public:
+    enum class format_t : std::uint8_t {
+      jsonl,
+      sarif
+    };
+
+    static constexpr auto default_buffer_size    = std::size_t{64} * 1024;
+    static constexpr auto default_flush_interval = std::chrono::milliseconds{1000};
+
+    /// Throw if the file can't be opened. It's truncated.
+    result_stream(const std::string &file,
+                  format_t format,
+                  std::size_t buffer_size                 = default_buffer_size,
+                  std::chrono::milliseconds flush_interval = default_flush_interval);
+    ~result_stream();
+
+    result_stream(const result_stream &)            = delete;
+    result_stream &operator=(const result_stream &) = delete;
+
+    /// Write the result of a file checked by the given tool and its
+    /// diagnostics. It's called by several tasks concurrently. Results added
+    /// after close are dropped.
+    void add(std::string_view tool,
+             const per_file_result_base &result,
+             const github::annotations &diagnostics);
+
+    /// Complete the document and write the buffered records. Throw if any
+    /// write failed.
+    void close();
+
+  private:
+    void append(const std::string &record);
+    void flush();
+
+    std::mutex mutex_;
+    std::ofstream out_;
+    std::string buffer_;
+    format_t format_;
+    std::size_t buffer_size_;
+    std::chrono::milliseconds flush_interval_;
+    std::chrono::steady_clock::time_point last_flush_;
+    std::size_t num_results_ = 0;
+    bool closed_             = false;
+    // The rule ids of SARIF results by the order they're first seen.
+    std::vector<std::string> rules_;
+    std::unordered_set<std::string> known_rules_;
+  };
+
+  /// Return the format of the given name, one of jsonl and sarif. Throw if it's
+  /// unsupported.
+  auto parse_result_format(std::string_view name) -> result_stream::format_t;
+
+} // namespace linter::tool
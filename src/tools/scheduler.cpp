@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <system_error>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include "utils/trace.h"
+
+namespace linter::tool {
+  namespace {
+    // The peak memory of the task running on the current thread.
+    thread_local std::uint64_t *current_task_memory = nullptr;
+
+    auto elapsed_since(std::chrono::steady_clock::time_point start) -> std::uint64_t {
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+    }
+  } // namespace
+
+  auto run_tasks(std::vector<tool_task> tasks, std::size_t num_threads) -> task_durations {
+    return run_tasks(std::move(tasks), num_threads, 0).durations;
+  }
+
+  auto run_tasks(std::vector<tool_task> tasks,
+                 std::size_t num_threads,
+                 std::uint64_t max_memory,
+                 const std::atomic<bool> *cancelled,
+                 std::span<const std::size_t> owner_jobs) -> task_measures {
+    auto measures = task_measures{};
+    if (tasks.empty()) {
+      return measures;
+    }
+    std::ranges::stable_sort(tasks, std::ranges::greater{}, &tool_task::cost);
+
+    // Tasks having memory measured before seed the estimation of the others.
+    auto measured_memory = std::uint64_t{0};
+    auto num_measured    = std::uint64_t{0};
+    for (const auto &task: tasks) {
+      if (task.memory != 0) {
+        measured_memory += task.memory;
+        ++num_measured;
+      }
+    }
+
+    auto mutex    = std::mutex{};
+    auto finished = std::condition_variable{};
+    auto error    = std::exception_ptr{};
+    auto pending  = tasks
+                 | std::views::transform([](tool_task &task) { return &task; })
+                 | std::ranges::to<std::vector>();
+    auto reserved = std::uint64_t{0};
+    auto running  = std::size_t{0};
+    auto active   = std::vector<std::size_t>(owner_jobs.size(), 0);
+
+    auto estimate = [&](const tool_task &task) {
+      if (task.memory != 0 || num_measured == 0) {
+        return task.memory;
+      }
+      return measured_memory / num_measured;
+    };
+    auto admitted = [&](const tool_task *task) {
+      if (max_memory != 0 && reserved + estimate(*task) > max_memory) {
+        return false;
+      }
+      return task->owner >= owner_jobs.size()
+          || active[task->owner] < std::max<std::size_t>(owner_jobs[task->owner], 1);
+    };
+
+    // Each worker takes the next admitted task until all are taken.
+    auto work = [&] {
+      auto lock = std::unique_lock{mutex};
+      while (!pending.empty()) {
+        if (cancelled != nullptr && cancelled->load()) {
+          auto dropped = std::exchange(pending, {});
+          lock.unlock();
+          for (auto *task: dropped) {
+            if (task->skip) {
+              task->skip();
+            }
+          }
+          return;
+        }
+        auto next = std::ranges::find_if(pending, admitted);
+        if (next == pending.end() && running != 0) {
+          finished.wait(lock);
+          continue;
+        }
+        // Nothing runs, so only the memory budget could reject the task.
+        if (next == pending.end()) {
+          next = pending.begin();
+        }
+        auto &task  = **next;
+        auto memory = max_memory != 0 ? estimate(task) : std::uint64_t{0};
+        auto owned  = task.owner < owner_jobs.size();
+        pending.erase(next);
+        reserved += memory;
+        ++running;
+        if (owned) {
+          ++active[task.owner];
+        }
+        lock.unlock();
+
+        auto peak    = std::uint64_t{0};
+        auto elapsed = std::optional<std::uint64_t>{};
+        auto failure = std::exception_ptr{};
+        try {
+          auto scope          = trace::scope{"task", task.name};
+          auto start          = std::chrono::steady_clock::now();
+          current_task_memory = &peak;
+          task.run();
+          elapsed = elapsed_since(start);
+        } catch (...) {
+          failure = std::current_exception();
+        }
+        current_task_memory = nullptr;
+
+        lock.lock();
+        reserved -= memory;
+        --running;
+        if (owned) {
+          --active[task.owner];
+        }
+        if (elapsed) {
+          measures.durations[task.name] = *elapsed;
+        }
+        if (peak != 0) {
+          measures.memories[task.name]  = peak;
+          measured_memory              += peak;
+          ++num_measured;
+        }
+        if (failure && !error) {
+          error = failure;
+        }
+        finished.notify_all();
+      }
+    };
+
+    auto num_workers = std::clamp<std::size_t>(num_threads, 1, tasks.size());
+    auto pool        = boost::asio::thread_pool{num_workers};
+    for (auto idx = std::size_t{0}; idx < num_workers; ++idx) {
+      boost::asio::post(pool, work);
+    }
+    pool.join();
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return measures;
+  }
+
+  void record_task_memory(std::uint64_t bytes) {
+    if (current_task_memory != nullptr) {
+      *current_task_memory = std::max(*current_task_memory, bytes);
+    }
+  }
+
+  void apply_task_memories(std::vector<tool_task> &tasks, const task_memories &memories) {
+    for (auto &task: tasks) {
+      if (auto iter = memories.find(task.name); iter != memories.end()) {
+        task.memory = iter->second;
+      }
+    }
+  }
+
+  void apply_task_durations(std::vector<tool_task> &tasks, const task_durations &durations) {
+    // Scale by the tasks measured before, e.g. bytes to microseconds.
+    auto measured  = std::uint64_t{0};
+    auto estimated = std::uint64_t{0};
+    for (const auto &task: tasks) {
+      if (auto iter = durations.find(task.name); iter != durations.end() && task.cost != 0) {
+        measured  += iter->second;
+        estimated += task.cost;
+      }
+    }
+    for (auto &task: tasks) {
+      if (auto iter = durations.find(task.name); iter != durations.end()) {
+        task.cost = iter->second;
+      } else if (estimated != 0) {
+        task.cost = static_cast<std::uint64_t>(static_cast<double>(task.cost)
+                                               * static_cast<double>(measured)
+                                               / static_cast<double>(estimated));
+      }
+    }
+  }
+
+  auto select_shard(std::vector<tool_task> tasks, std::size_t shard_index, std::size_t shard_count)
+    -> std::vector<tool_task> {
+    if (shard_count <= 1) {
+      return tasks;
+    }
+    // Tie by names, so the order doesn't depend on the order of tools.
+    std::ranges::sort(tasks, [](const tool_task &lhs, const tool_task &rhs) {
+      return std::tie(rhs.cost, lhs.name) < std::tie(lhs.cost, rhs.name);
+    });
+
+    auto loads = std::vector<std::uint64_t>(shard_count, 0);
+    auto ret   = std::vector<tool_task>{};
+    for (auto &task: tasks) {
+      auto least = std::ranges::min_element(loads);
+      *least     += std::max<std::uint64_t>(task.cost, 1);
+      if (static_cast<std::size_t>(least - loads.begin()) == shard_index) {
+        ret.push_back(std::move(task));
+      }
+    }
+    return ret;
+  }
+
+  auto select_shard_files(const std::vector<std::string> &files,
+                          const std::string &root_dir,
+                          std::size_t shard_index,
+                          std::size_t shard_count) -> std::vector<std::string> {
+    if (shard_count <= 1) {
+      return files;
+    }
+    auto tasks = files
+               | std::views::transform([&](const std::string &file) {
+                   return tool_task{.cost = estimate_file_cost(root_dir, file), .name = file};
+                 })
+               | std::ranges::to<std::vector>();
+    auto selected = std::unordered_set<std::string>{};
+    for (auto &task: select_shard(std::move(tasks), shard_index, shard_count)) {
+      selected.insert(std::move(task.name));
+    }
+    return files
+         | std::views::filter([&](const std::string &file) { return selected.contains(file); })
+         | std::ranges::to<std::vector>();
+  }
+
+  auto estimate_file_cost(const std::string &root_dir, const std::string &file) -> std::uint64_t {
+    auto ec   = std::error_code{};
+    auto size = std::filesystem::file_size(std::filesystem::path{root_dir} / file, ec);
+    return ec ? 0 : size;
+  }
+
+} // namespace linter::tool
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "tools/base_result.h"
+
+namespace linter::tool {
+  /// A unit of work of a tool, usually checking one file or one batch of files.
+  /// Tasks of all tools are run by a shared pool, so a slow tool doesn't leave
+  /// the others waiting.
+  struct tool_task {
+    /// The estimated cost of this task. The most costly tasks are started
+    /// first to shorten the tail of the whole check.
+    std::uint64_t cost = 0;
+    /// Shown in the trace, usually the tool and the checked files.
+    std::string name;
+    std::function<void()> run;
+    /// Called instead of run if the task is dropped since the check was
+    /// cancelled, e.g. to mark its files skipped. May be empty.
+    std::function<void()> skip;
+    /// The estimated peak memory of this task in bytes, 0 if unknown.
+    std::uint64_t memory = 0;
+    /// The index of the tool owning this task, set by do_check.
+    std::size_t owner = 0;
+  };
+
+  /// The measured durations of tasks in microseconds by task name.
+  using task_durations = std::unordered_map<std::string, std::uint64_t>;
+
+  /// The measured peak memory of tasks in bytes by task name.
+  using task_memories = std::unordered_map<std::string, std::uint64_t>;
+
+  struct task_measures {
+    task_durations durations;
+    task_memories memories;
+  };
+
+  /// Run tasks by at most the given number of threads and wait for all of them
+  /// finished. The first thrown exception is rethrown after that. Return the
+  /// durations of the tasks.
+  auto run_tasks(std::vector<tool_task> tasks, std::size_t num_threads) -> task_durations;
+
+  /// The same as above, but a task is only started while the estimated memory
+  /// of it and the running tasks fits max_memory, the most costly fitting one
+  /// first. A task which doesn't fit alone is run when nothing else runs. The
+  /// memory of a task unknown is estimated by the average of the others, which
+  /// is updated as tasks finish. 0 means unlimited. No more task is started once
+  /// cancelled is set, the tasks not started are skipped and not measured. At most
+  /// owner_jobs[owner] tasks of an owner run at the same time, owners out of
+  /// owner_jobs aren't limited. Return the durations and the peak memory of the
+  /// tasks.
+  auto run_tasks(std::vector<tool_task> tasks,
+                 std::size_t num_threads,
+                 std::uint64_t max_memory,
+                 const std::atomic<bool> *cancelled = nullptr,
+                 std::span<const std::size_t> owner_jobs = {}) -> task_measures;
+
+  /// Record the peak memory of a child process launched by the running task.
+  /// The peak memory of a task is the maximum recorded. Do nothing if it isn't
+  /// called by a task.
+  void record_task_memory(std::uint64_t bytes);
+
+  /// Replace the estimated memory of tasks by their peak memory measured in
+  /// former runs.
+  void apply_task_memories(std::vector<tool_task> &tasks, const task_memories &memories);
+
+  /// Replace the estimated costs of tasks by their durations measured in former
+  /// runs. The estimated costs of the other tasks are scaled to durations by the
+  /// tasks having both, so all costs are comparable.
+  void apply_task_durations(std::vector<tool_task> &tasks, const task_durations &durations);
+
+  /// Partition tasks into the given number of shards and return the tasks of
+  /// the given shard. The most costly task is assigned to the least loaded
+  /// shard first, so shards finish at about the same time. The partition only
+  /// depends on the names and costs of tasks, so every shard computes the same.
+  auto select_shard(std::vector<tool_task> tasks, std::size_t shard_index, std::size_t shard_count)
+    -> std::vector<tool_task>;
+
+  /// Partition files into the given number of shards by their sizes and return
+  /// the files of the given shard in their order. Each tool partitions its own
+  /// files before anything local to a runner, such as the cache, is applied,
+  /// so every shard computes the same partition.
+  auto select_shard_files(const std::vector<std::string> &files,
+                          const std::string &root_dir,
+                          std::size_t shard_index,
+                          std::size_t shard_count) -> std::vector<std::string>;
+
+  /// Estimate the cost of checking a file by its size. Return 0 if the file
+  /// doesn't exist.
+  auto estimate_file_cost(const std::string &root_dir, const std::string &file) -> std::uint64_t;
+
+  /// The results of files checked concurrently. Each file owns a slot, so the
+  /// results could be merged by the order of files no matter which one
+  /// finishes first.
+  template <class PerFileResult>
+  struct file_slots {
+    explicit file_slots(std::size_t size)
+      : results(size)
+      , errors(size)
+      , timed_out(size)
+      , skipped(size)
+      , first_failed(size) {
+    }
+
+    void set(std::size_t idx, PerFileResult res) {
+      publish(on_checked, res);
+      if (!res.passed) {
+        auto cur = first_failed.load();
+        while (idx < cur && !first_failed.compare_exchange_weak(cur, idx)) {
+        }
+        publish(on_failed, res);
+      }
+      results[idx] = std::move(res);
+    }
+
+    void set_error(std::size_t idx, std::exception_ptr error) {
+      errors[idx] = std::move(error);
+    }
+
+    void set_timed_out(std::size_t idx) {
+      timed_out[idx] = true;
+    }
+
+    /// Mark a file not checked since fail fast stopped the check, e.g. its
+    /// task was dropped or its child process was killed.
+    void set_skipped(std::size_t idx) {
+      skipped[idx] = true;
+    }
+
+    [[nodiscard]] auto any_failed() const -> bool {
+      return first_failed.load() < results.size();
+    }
+
+    /// Files after the first failed one are dropped when fastly exit is
+    /// enabled, so it's unnecessary to check them.
+    [[nodiscard]] auto after_failed(std::size_t idx) const -> bool {
+      return idx > first_failed.load();
+    }
+
+    /// Merge the results into the given result by the order of files. The
+    /// callback is invoked with the index of each merged result. Timed out
+    /// files fail the result unless allow_timed_out is set.
+    template <class OnMerged>
+    void merge(const std::vector<std::string> &files,
+               multi_files_result_base<PerFileResult> &result,
+               bool fastly_exit,
+               bool allow_timed_out,
+               std::string_view binary,
+               OnMerged &&on_merged) {
+      for (auto idx = std::size_t{0}; idx < files.size(); ++idx) {
+        if (errors[idx]) {
+          std::rethrow_exception(errors[idx]);
+        }
+        if (timed_out[idx]) {
+          spdlog::warn("file: {} timed out by {} check.", files[idx], binary);
+          result.timed_out.push_back(files[idx]);
+          continue;
+        }
+        if (skipped[idx]) {
+          result.fastly_exited = true;
+          continue;
+        }
+        if (!results[idx]) {
+          continue;
+        }
+        on_merged(idx, *results[idx]);
+
+        const auto &file     = files[idx];
+        auto per_file_result = std::move(*results[idx]);
+        if (per_file_result.passed) {
+          spdlog::info("file: {} passes {} check.", file, binary);
+          result.passes[file] = std::move(per_file_result);
+          continue;
+        }
+
+        spdlog::error("file: {} doesn't pass {} check.", file, binary);
+        result.fails[file] = std::move(per_file_result);
+
+        if (fastly_exit) {
+          spdlog::info("{} fastly exit since check failed", binary);
+          result.final_passed  = false;
+          result.fastly_exited = true;
+          return;
+        }
+      }
+
+      result.final_passed = is_passed(result, allow_timed_out);
+    }
+
+    /// Called with each failed result as soon as it's set, e.g. to publish it
+    /// before all files are checked. It may be called concurrently.
+    std::function<void(const PerFileResult &)> on_failed;
+
+    /// The same as on_failed, but called with each result no matter whether
+    /// it passed.
+    std::function<void(const PerFileResult &)> on_checked;
+
+    std::vector<std::optional<PerFileResult>> results;
+    std::vector<std::exception_ptr> errors;
+    // Not std::vector<bool>, whose elements can't be set concurrently.
+    std::vector<char> timed_out;
+    std::vector<char> skipped;
+    std::atomic<std::size_t> first_failed;
+
+  private:
+    // Consumers of results, e.g. the result file, are only side outputs, so
+    // their failures are logged rather than failing the check of the file.
+    static void publish(const std::function<void(const PerFileResult &)> &consumer,
+                        const PerFileResult &res) {
+      if (!consumer) {
+        return;
+      }
+      try {
+        consumer(res);
+      } catch (const std::exception &err) {
+        spdlog::error("Failed to publish a checked result: {}", err.what());
+      }
+    }
+  };
+
+} // namespace linter::tool
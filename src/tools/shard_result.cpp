@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/shard_result.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "utils/git_utils.h"
+#include "utils/hunk_index.h"
+#include "utils/patch_set.h"
+#include "utils/util.h"
+
+namespace linter::tool {
+  namespace {
+    // Increased when the layout of result files changes.
+    constexpr auto result_file_version = 2;
+
+    constexpr auto base64_chars =
+      std::string_view{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+    // Sources needn't be UTF-8, which json strings must be, so they're saved
+    // in base64 to be restored byte by byte.
+    auto encode_base64(std::string_view data) -> std::string {
+      auto ret = std::string{};
+      ret.reserve((data.size() + 2) / 3 * 4);
+      for (auto idx = std::size_t{0}; idx < data.size(); idx += 3) {
+        auto num   = std::min<std::size_t>(3, data.size() - idx);
+        auto group = std::uint32_t{0};
+        for (auto offset = std::size_t{0}; offset < 3; ++offset) {
+          auto byte = offset < num ? static_cast<unsigned char>(data[idx + offset]) : 0U;
+          group     = (group << 8U) | byte;
+        }
+        for (auto offset = std::size_t{0}; offset < 4; ++offset) {
+          ret += offset <= num ? base64_chars[(group >> (18U - (6U * offset))) & 0x3FU] : '=';
+        }
+      }
+      return ret;
+    }
+
+    auto decode_base64(std::string_view text) -> std::string {
+      auto ret   = std::string{};
+      auto group = std::uint32_t{0};
+      auto bits  = 0U;
+      for (auto chr: text) {
+        if (chr == '=') {
+          break;
+        }
+        auto value = base64_chars.find(chr);
+        throw_if(value == std::string_view::npos, "invalid base64 in shard result file");
+        group  = (group << 6U) | static_cast<std::uint32_t>(value);
+        bits  += 6;
+        if (bits >= 8) {
+          bits -= 8;
+          ret  += static_cast<char>((group >> bits) & 0xFFU);
+        }
+      }
+      return ret;
+    }
+
+    auto read_source(const runtime_context &context,
+                     const std::string &file) -> std::optional<std::string> {
+      if (context.repo != nullptr) {
+        return std::string{
+          git::blob::get_view(context.repo.get(), context.source_commit.get(), file).content};
+      }
+      if (auto iter = context.source_contents.find(file); iter != context.source_contents.end()) {
+        return iter->second;
+      }
+      return std::nullopt;
+    }
+  } // namespace
+
+  void write_shard_result(const runtime_context &context,
+                          const std::vector<tool_base_ptr> &tools,
+                          const std::vector<reporter_base_ptr> &reporters,
+                          const std::string &file) {
+    auto results = nlohmann::json::object();
+    for (const auto &tool: tools) {
+      results[std::string{tool->name()}] = tool->dump_result();
+    }
+
+    auto hunks   = nlohmann::json::object();
+    auto sources = nlohmann::json::object();
+    for (const auto &reporter: reporters) {
+      for (const auto &reviewed: reporter->reviewed_files()) {
+        if (!hunks.contains(reviewed) && context.patches.contains(reviewed)) {
+          hunks[reviewed] = context.patches.hunks(reviewed);
+        }
+      }
+      for (const auto &read: reporter->read_files()) {
+        if (sources.contains(read)) {
+          continue;
+        }
+        if (auto content = read_source(context, read)) {
+          sources[read] = encode_base64(*content);
+        }
+      }
+    }
+
+    auto value = nlohmann::json{
+      {"version",       result_file_version  },
+      {"changed_files", context.changed_files},
+      {"hunks",         std::move(hunks)     },
+      {"sources",       std::move(sources)   },
+      {"results",       std::move(results)   }
+    };
+    auto stream = std::ofstream{file, std::ios::trunc};
+    throw_unless(stream.is_open(), std::format("failed to open shard result file {}", file));
+    // Outputs of tools kept in results may have bytes which aren't UTF-8, they
+    // are replaced since only sources must be kept byte by byte.
+    stream << value.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    spdlog::info("The shard result is written to {}", file);
+  }
+
+  void merge_shard_results(runtime_context &context,
+                           const std::vector<tool_base_ptr> &tools,
+                           const std::vector<std::string> &files) {
+    auto hunks    = std::vector<std::pair<std::string, git::hunk_index>>{};
+    auto restored = std::unordered_set<std::string>{};
+    for (const auto &file: files) {
+      auto stream = std::ifstream{file};
+      throw_unless(stream.is_open(), std::format("failed to open shard result file {}", file));
+      auto value = nlohmann::json::parse(stream, nullptr, false);
+      throw_if(value.is_discarded(), std::format("failed to parse shard result file {}", file));
+      throw_unless(value.value("version", 0) == result_file_version,
+                   std::format("unsupported version of shard result file {}", file));
+
+      // All shards check the same diff.
+      if (context.changed_files.empty()) {
+        value["changed_files"].get_to(context.changed_files);
+      }
+      for (auto &[name, index]: value["hunks"].items()) {
+        if (restored.insert(name).second) {
+          hunks.emplace_back(name, index.get<git::hunk_index>());
+        }
+      }
+      for (auto &[name, content]: value["sources"].items()) {
+        context.source_contents.try_emplace(name, decode_base64(content.get<std::string>()));
+      }
+
+      const auto &results = value["results"];
+      for (const auto &tool: tools) {
+        auto name = std::string{tool->name()};
+        if (results.contains(name)) {
+          tool->merge_result(context, results[name]);
+        } else {
+          spdlog::warn("The shard result file {} lacks the result of {}", file, name);
+        }
+      }
+    }
+    context.patches = git::patch_set{std::move(hunks)};
+  }
+
+} // namespace linter::tool
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "context.h"
+#include "tools/base_reporter.h"
+#include "tools/base_tool.h"
+
+namespace linter::tool {
+  /// Write the results of all tools to the given file, so the results of
+  /// shards could be merged and reported once by another run. The hunks and
+  /// contents of files used by reporters are written as well, so reports
+  /// could be made again without the repository or checking again.
+  void write_shard_result(const runtime_context &context,
+                          const std::vector<tool_base_ptr> &tools,
+                          const std::vector<reporter_base_ptr> &reporters,
+                          const std::string &file);
+
+  /// Merge the results of shards in the given files into the results of tools,
+  /// and restore the changed files and patches of the context from them. The
+  /// results of tools not enabled in this run are ignored.
+  void merge_shard_results(runtime_context &context,
+                           const std::vector<tool_base_ptr> &tools,
+                           const std::vector<std::string> &files);
+
+} // namespace linter::tool
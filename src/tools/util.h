@@ -15,21 +15,32 @@
  */
 #pragma once
 
-#include <spdlog/spdlog.h>
+#include <format>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
 
 #include "utils/shell.h"
 #include "utils/util.h"
 
 namespace linter::tool {
-  // Find the full executable path of clang tools with specific version.
-  inline auto find_clang_tool(std::string_view tool, std::string_view version) -> std::string {
-    auto command                = std::format("{}-{}", tool, version);
-    auto [ec, std_out, std_err] = shell::which(command);
-    throw_unless(ec == 0,
-                 std::format("find {}-{} failed, error message: {}", tool, version, std_err));
-    auto trimmed = trim(std_out);
-    throw_if(trimmed.empty(), "got empty clang tool path");
-    return {trimmed.data(), trimmed.size()};
+  /// Resolve the full path of a tool binary by PATH. Tools are resolved when
+  /// they have files to check, so unused tools cost nothing at startup. The
+  /// results are memoized since several tools may share a binary.
+  inline auto resolve_tool_binary(const std::string &binary) -> std::string {
+    static auto mutex    = std::mutex{};
+    static auto resolved = std::unordered_map<std::string, std::string>{};
+    auto lock            = std::lock_guard{mutex};
+    if (auto iter = resolved.find(binary); iter != resolved.end()) {
+      return iter->second;
+    }
+
+    auto res = shell::which(binary);
+    throw_unless(res.exit_code == 0,
+                 std::format("Can't find {}, error message: {}", binary, res.std_err));
+    spdlog::info("The {} executable path: {}", binary, res.std_out);
+    return resolved.emplace(binary, std::move(res.std_out)).first->second;
   }
 } // namespace linter::tool
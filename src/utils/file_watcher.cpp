@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <ranges>
+#include <system_error>
+#include <utility>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "utils/util.h"
+
+namespace linter {
+#if defined(__linux__)
+  namespace {
+    // Editors either write files in place or rename a temporary file to them.
+    // Directories created or moved in are watched once known.
+    constexpr auto watched_events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+    constexpr auto event_buffer_size = std::size_t{64} * 1024;
+  } // namespace
+
+  file_watcher::file_watcher(std::string root, std::vector<std::string> skipped_dirs)
+    : root_(std::move(root))
+    , skipped_dirs_(std::move(skipped_dirs))
+    , fd_(::inotify_init1(IN_CLOEXEC)) {
+    throw_if(fd_ < 0, std::format("Failed to init inotify: {}", std::strerror(errno)));
+    watch_tree("");
+    spdlog::debug("Watch {} directories under {}", dirs_.size(), root_);
+  }
+
+  file_watcher::~file_watcher() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  void file_watcher::watch_tree(const std::string &dir) {
+    auto path = std::filesystem::path{root_} / dir;
+    auto wd   = ::inotify_add_watch(fd_, path.c_str(), watched_events | IN_ONLYDIR);
+    if (wd < 0) {
+      spdlog::warn("Can't watch {}: {}", path.string(), std::strerror(errno));
+      return;
+    }
+    dirs_[wd] = dir;
+
+    auto ec = std::error_code{};
+    for (const auto &entry: std::filesystem::directory_iterator{path, ec}) {
+      auto name = entry.path().filename().string();
+      if (entry.is_directory(ec) && !entry.is_symlink(ec)
+          && !std::ranges::contains(skipped_dirs_, name)) {
+        watch_tree((std::filesystem::path{dir} / name).generic_string());
+      }
+    }
+  }
+
+  auto file_watcher::wait(std::chrono::milliseconds quiet_time) -> std::vector<std::string> {
+    auto files   = std::vector<std::string>{};
+    auto buffer  = std::vector<char>(event_buffer_size);
+    auto timeout = -1;
+    while (true) {
+      auto pfd = pollfd{.fd = fd_, .events = POLLIN, .revents = 0};
+      auto ret = ::poll(&pfd, 1, timeout);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      throw_if(ret < 0, std::format("Failed to wait for file changes: {}", std::strerror(errno)));
+      if (ret == 0) {
+        break;
+      }
+
+      auto size = ::read(fd_, buffer.data(), buffer.size());
+      if (size < 0 && errno == EINTR) {
+        continue;
+      }
+      throw_if(size < 0, std::format("Failed to read file changes: {}", std::strerror(errno)));
+      for (auto offset = std::size_t{0}; offset < static_cast<std::size_t>(size);) {
+        auto event = inotify_event{};
+        std::memcpy(&event, buffer.data() + offset, sizeof(event));
+        auto name = std::string{buffer.data() + offset + sizeof(event)};
+        offset    += sizeof(event) + event.len;
+
+        if ((event.mask & IN_IGNORED) != 0) {
+          dirs_.erase(event.wd);
+          continue;
+        }
+        auto iter = dirs_.find(event.wd);
+        if (iter == dirs_.end() || name.empty()) {
+          continue;
+        }
+        auto path = (std::filesystem::path{iter->second} / name).generic_string();
+        if ((event.mask & IN_ISDIR) != 0) {
+          if (!std::ranges::contains(skipped_dirs_, name)) {
+            watch_tree(path);
+          }
+        } else if ((event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0) {
+          files.push_back(std::move(path));
+        }
+      }
+      // Wait for the quiet time only once a file changed.
+      if (!files.empty()) {
+        timeout = static_cast<int>(quiet_time.count());
+      }
+    }
+
+    std::ranges::sort(files);
+    auto [first, last] = std::ranges::unique(files);
+    files.erase(first, last);
+    return files;
+  }
+#else
+  file_watcher::file_watcher(std::string root, std::vector<std::string> skipped_dirs)
+    : root_(std::move(root))
+    , skipped_dirs_(std::move(skipped_dirs)) {
+    throw_if(true, "Watching files is only supported on Linux");
+  }
+
+  file_watcher::~file_watcher() = default;
+
+  void file_watcher::watch_tree([[maybe_unused]] const std::string &dir) {
+  }
+
+  auto file_watcher::wait([[maybe_unused]] std::chrono::milliseconds quiet_time)
+    -> std::vector<std::string> {
+    return {};
+  }
+#endif
+} // namespace linter
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace linter {
+  /// Watch the files under a directory for changes by inotify. Directories
+  /// created later are watched as well. Only supported on Linux.
+  class file_watcher {
+  public:
+    /// Directories having the given names, e.g. .git, are skipped with all
+    /// files under them.
+    file_watcher(std::string root, std::vector<std::string> skipped_dirs);
+    ~file_watcher();
+
+    file_watcher(const file_watcher &)                     = delete;
+    auto operator=(const file_watcher &) -> file_watcher & = delete;
+
+    /// Block until files are written, moved in or deleted, then return their
+    /// paths relative to root. Changes keep being collected until none comes
+    /// in the given time, so saving several files at once is returned once.
+    auto wait(std::chrono::milliseconds quiet_time) -> std::vector<std::string>;
+
+  private:
+    void watch_tree(const std::string &dir);
+
+    std::string root_;
+    std::vector<std::string> skipped_dirs_;
+    int fd_ = -1;
+    // The directories relative to root by watch descriptors.
+    std::unordered_map<int, std::string> dirs_;
+  };
+} // namespace linter
@@ -20,9 +20,13 @@
 #include <cstring>
 #include <git2/buffer.h>
 #include <git2/diff.h>
+#include <git2/odb.h>
 #include <git2/patch.h>
+#include <git2/sys/mempack.h>
+#include <git2/sys/odb_backend.h>
 #include <git2/tree.h>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "utils/git_error.h"
@@ -34,8 +38,43 @@ namespace linter::git {
     }
   } // namespace
 
-  int setup() {
-    return ::git_libgit2_init();
+  auto setup(const tuning &options) -> int {
+    auto ret = ::git_libgit2_init();
+    if (ret < 0) {
+      return ret;
+    }
+
+    auto set_size = [](git_libgit2_opt_t opt, const std::optional<std::size_t> &value) {
+      if (value) {
+        throw_if(::git_libgit2_opts(opt, *value));
+      }
+    };
+    auto set_object_limit = [](git_object_t type, const std::optional<std::size_t> &value) {
+      if (value) {
+        throw_if(::git_libgit2_opts(GIT_OPT_SET_CACHE_OBJECT_LIMIT, type, *value));
+      }
+    };
+    if (options.cache_max_size) {
+      // It's a ssize_t to libgit2.
+      auto size = static_cast<std::ptrdiff_t>(*options.cache_max_size);
+      throw_if(::git_libgit2_opts(GIT_OPT_SET_CACHE_MAX_SIZE, size));
+    }
+    set_object_limit(GIT_OBJECT_BLOB, options.blob_cache_limit);
+    set_object_limit(GIT_OBJECT_TREE, options.tree_cache_limit);
+    set_object_limit(GIT_OBJECT_COMMIT, options.commit_cache_limit);
+    set_size(GIT_OPT_SET_MWINDOW_SIZE, options.mwindow_size);
+    set_size(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT, options.mwindow_mapped_limit);
+    set_size(GIT_OPT_SET_MWINDOW_FILE_LIMIT, options.mwindow_file_limit);
+    throw_if(::git_libgit2_opts(GIT_OPT_ENABLE_STRICT_HASH_VERIFICATION,
+                                static_cast<int>(options.strict_hash_verification)));
+    return ret;
+  }
+
+  auto cached_memory() -> cache_usage {
+    auto current = ssize_t{0};
+    auto allowed = ssize_t{0};
+    throw_if(::git_libgit2_opts(GIT_OPT_GET_CACHED_MEMORY, &current, &allowed));
+    return {.current = current, .allowed = allowed};
   }
 
   auto shutdown() -> int {
@@ -177,6 +216,26 @@ namespace linter::git {
       return {repo, ::git_repository_free};
     }
 
+    void use_memory_odb(repo_raw_ptr repo) {
+      // Objects are written to the backend of the highest priority, the
+      // loose and packed backends have 1 and 2.
+      static constexpr auto memory_priority = 1000;
+
+      auto *odb = static_cast<git_odb *>(nullptr);
+      auto ret  = ::git_repository_odb(&odb, repo);
+      throw_if(ret);
+      auto odb_guard = std::unique_ptr<git_odb, decltype(&::git_odb_free)>{odb, ::git_odb_free};
+
+      auto *backend = static_cast<git_odb_backend *>(nullptr);
+      ret           = ::git_mempack_new(&backend);
+      throw_if(ret);
+      ret = ::git_odb_add_backend(odb, backend, memory_priority);
+      if (ret != 0) {
+        backend->free(backend);
+      }
+      throw_if(ret);
+    }
+
     void free(repo_raw_ptr repo) {
       ::git_repository_free(repo);
     }
@@ -412,6 +471,37 @@ namespace linter::git {
       return {oid, std::move(commit)};
     }
 
+    auto create_staged(repo_raw_ptr repo) -> commit_ptr {
+      auto index    = repo::index(repo);
+      auto tree_oid = index::write_tree(index.get());
+      auto tree     = tree::lookup(repo, &tree_oid);
+
+      auto *sig_ptr = signature_raw_ptr{nullptr};
+      auto ret      = ::git_signature_new(&sig_ptr, "cpp-linter", "cpp-linter", 0, 0);
+      throw_if(ret);
+      auto sig = signature_ptr{sig_ptr, ::git_signature_free};
+
+      auto head    = repo::head_commit(repo);
+      auto parents = std::vector<commit_raw_cptr>{};
+      if (head != nullptr) {
+        parents.push_back(head.get());
+      }
+      auto id = git_oid{};
+      ret     = ::git_commit_create(
+        &id,
+        repo,
+        nullptr,
+        sig.get(),
+        sig.get(),
+        "UTF-8",
+        "Staged changes",
+        tree.get(),
+        parents.size(),
+        parents.data());
+      throw_if(ret);
+      return lookup(repo, &id);
+    }
+
     auto tree(commit_raw_cptr commit) -> tree_ptr {
       auto *ptr = tree_raw_ptr{nullptr};
       auto ret  = ::git_commit_tree(&ptr, commit);
@@ -483,6 +573,10 @@ namespace linter::git {
       git::object::free(reinterpret_cast<object_raw_ptr>(commit));
     }
 
+    auto id(commit_raw_cptr commit) -> oid_raw_cptr {
+      return ::git_commit_id(commit);
+    }
+
     auto id_str(commit_raw_cptr commit) -> std::string {
       const auto *obj = reinterpret_cast<object_raw_cptr>(commit);
       return object::id_str(obj);
@@ -503,6 +597,14 @@ namespace linter::git {
       return {ptr, ::git_diff_free};
     }
 
+    auto tree_to_workdir(repo_raw_ptr repo, tree_raw_ptr old_tree, diff_options_raw_cptr opts)
+      -> diff_ptr {
+      auto *ptr = diff_raw_ptr{nullptr};
+      auto ret  = ::git_diff_tree_to_workdir_with_index(&ptr, repo, old_tree, opts);
+      throw_if(ret);
+      return {ptr, ::git_diff_free};
+    }
+
     auto tree_to_tree(
       repo_raw_ptr repo,
       tree_raw_ptr old_tree,
@@ -545,6 +647,19 @@ namespace linter::git {
       return ::git_diff_get_delta(diff, idx);
     }
 
+    auto init_find_option(std::uint32_t flags) -> git_diff_find_options {
+      auto opts = git_diff_find_options{};
+      auto ret  = ::git_diff_find_options_init(&opts, GIT_DIFF_FIND_OPTIONS_VERSION);
+      throw_if(ret);
+      opts.flags = flags;
+      return opts;
+    }
+
+    void find_similar(diff_raw_ptr diff, const git_diff_find_options &opts) {
+      auto ret = ::git_diff_find_similar(diff, &opts);
+      throw_if(ret);
+    }
+
     auto for_each(
       diff_raw_ptr diff,
       diff_file_cb file_cb,
@@ -738,6 +853,13 @@ namespace linter::git {
       return oid;
     }
 
+    auto hash(std::string_view data) -> git_oid {
+      auto oid = git_oid{};
+      auto ret = ::git_odb_hash(&oid, data.data(), data.size(), GIT_OBJECT_BLOB);
+      throw_if(ret);
+      return oid;
+    }
+
   } // namespace oid
 
   namespace ref {
@@ -930,6 +1052,16 @@ namespace linter::git {
       return {oid, entry};
     }
 
+    auto entry_bypath(tree_raw_cptr tree, const std::string &path) -> tree_entry_ptr {
+      auto *entry = tree_entry_raw_ptr{nullptr};
+      auto ret    = ::git_tree_entry_bypath(&entry, tree, path.c_str());
+      if (ret == GIT_ENOTFOUND) {
+        return {nullptr, ::git_tree_entry_free};
+      }
+      throw_if(ret);
+      return {entry, ::git_tree_entry_free};
+    }
+
   } // namespace tree
 
   namespace status {
@@ -980,9 +1112,9 @@ namespace linter::git {
     }
 
     auto create_from_buffers(
-      const std::string &old_buffer,
+      std::string_view old_buffer,
       const std::string &old_as_path,
-      const std::string &new_buffer,
+      std::string_view new_buffer,
       const std::string &new_as_path,
       const diff_options &opts) -> patch_ptr {
       auto *patch = patch_raw_ptr{nullptr};
@@ -1114,20 +1246,28 @@ namespace linter::git {
     }
 
     auto get_raw_content(blob_raw_cptr blob) -> std::string {
+      return std::string{get_raw_view(blob)};
+    }
+
+    auto get_raw_view(blob_raw_cptr blob) -> std::string_view {
       const auto *ret = ::git_blob_rawcontent(blob);
       throw_if(ret == nullptr, "get raw content by blob error");
-      return static_cast<const char *>(ret);
+      return {static_cast<const char *>(ret), static_cast<std::size_t>(::git_blob_rawsize(blob))};
+    }
+
+    auto is_binary(blob_raw_cptr blob) -> bool {
+      return ::git_blob_is_binary(blob) == 1;
     }
 
     auto get_raw_content(repo_raw_ptr repo, tree_raw_cptr tree, const std::string &file_name)
       -> std::string {
       throw_if(tree == nullptr, "failed to get raw content sicne tree is a null pointer");
       throw_if(file_name.empty(), "failed to get raw content sicne file name is empty");
-      auto [entry_id, entry] = tree::entry_byname(tree, file_name);
+      auto entry = tree::entry_bypath(tree, file_name);
       if (entry == nullptr) {
         return "";
       }
-      auto blob = lookup(repo, entry_id);
+      auto blob = lookup(repo, ::git_tree_entry_id(entry.get()));
       return get_raw_content(blob.get());
     }
 
@@ -1137,6 +1277,25 @@ namespace linter::git {
       return get_raw_content(repo, tree.get(), file_name);
     }
 
+    auto get_view(repo_raw_ptr repo, commit_raw_cptr commit, const std::string &file_path)
+      -> blob_view {
+      auto tree = commit::tree(commit);
+      return get_view(repo, tree.get(), file_path);
+    }
+
+    auto get_view(repo_raw_ptr repo, tree_raw_cptr tree, const std::string &file_path)
+      -> blob_view {
+      throw_if(file_path.empty(), "failed to get raw content sicne file name is empty");
+      auto entry = tree::entry_bypath(tree, file_path);
+      if (entry == nullptr) {
+        return {};
+      }
+      auto view    = blob_view{};
+      view.blob    = lookup(repo, ::git_tree_entry_id(entry.get()));
+      view.content = get_raw_view(view.blob.get());
+      return view;
+    }
+
   } // namespace blob
 
 } // namespace linter::git
@@ -15,11 +15,14 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <git2/types.h>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -79,6 +82,7 @@ namespace linter::git {
   using signature_ptr   = std::unique_ptr<git_signature, decltype(::git_signature_free) *>;
   using status_list_ptr = std::unique_ptr<git_status_list, decltype(::git_status_list_free) *>;
   using patch_ptr       = std::unique_ptr<git_patch, decltype(::git_patch_free) *>;
+  using tree_entry_ptr  = std::unique_ptr<git_tree_entry, decltype(::git_tree_entry_free) *>;
 
   using repo_raw_ptr         = git_repository *;
   using config_raw_ptr       = git_config *;
@@ -359,9 +363,37 @@ namespace linter::git {
   auto object_t_str(object_t tp) -> std::string;
   auto repo_state_str(repo_state_t state) -> std::string;
 
-  /// Init the global state.
+  /// The global options of libgit2, which are left as default if not set.
+  /// Large repositories may need larger caches and mmap windows. See
+  /// https://libgit2.org/libgit2/#HEAD/group/libgit2/git_libgit2_opts
+  struct tuning {
+    /// The maximum bytes of all cached objects.
+    std::optional<std::size_t> cache_max_size;
+    /// Objects larger than these bytes aren't cached. Blobs aren't cached by
+    /// default of libgit2.
+    std::optional<std::size_t> blob_cache_limit;
+    std::optional<std::size_t> tree_cache_limit;
+    std::optional<std::size_t> commit_cache_limit;
+    /// The bytes of each mmap window on packfiles, and all of them.
+    std::optional<std::size_t> mwindow_size;
+    std::optional<std::size_t> mwindow_mapped_limit;
+    /// The maximum number of packfiles opened at the same time.
+    std::optional<std::size_t> mwindow_file_limit;
+    /// Verify the hash of each object read. Objects are read faster without it.
+    bool strict_hash_verification = true;
+  };
+
+  /// Init the global state and apply the given options.
   /// This must be used before git operations.
-  auto setup() -> int;
+  auto setup(const tuning &options = {}) -> int;
+
+  /// The bytes of all cached objects currently and at most.
+  struct cache_usage {
+    std::int64_t current = 0;
+    std::int64_t allowed = 0;
+  };
+
+  auto cached_memory() -> cache_usage;
 
   /// Shutdown the global state
   /// This must be used after all git operations have done.
@@ -379,6 +411,11 @@ namespace linter::git {
     /// Open a git repository.
     auto open(const std::string &repo_path) -> repo_ptr;
 
+    /// Write new objects of the repository to memory instead of its object
+    /// database, e.g. to create commits which only live as long as the
+    /// repository. Existing objects are still read from disk.
+    void use_memory_odb(repo_raw_ptr repo);
+
     /// Free a previously allocated repository. If you use repo_ptr instead of
     /// repo_raw_ptr, you didn't need to explicitly call this function.
     void free(repo_raw_ptr repo);
@@ -559,6 +596,12 @@ namespace linter::git {
     auto create_head(repo_raw_ptr repo, const std::string &message, tree_raw_cptr index_tree)
       -> std::tuple<git_oid, commit_ptr>;
 
+    /// Create a commit of the index whose parent is HEAD, without updating
+    /// any reference. The signature and time are fixed, so the same index
+    /// always makes the same commit. Call repo::use_memory_odb first to not
+    /// leave the trees and the commit in the object database.
+    auto create_staged(repo_raw_ptr repo) -> commit_ptr;
+
     /// Get the tree pointed to by a commit.
     auto tree(commit_raw_cptr commit) -> tree_ptr;
 
@@ -603,6 +646,9 @@ namespace linter::git {
     /// manumally.
     void free(commit_raw_ptr commit);
 
+    /// Get this commit's id.
+    auto id(commit_raw_cptr commit) -> oid_raw_cptr;
+
     /// Get this commit's id and convert it to string.
     auto id_str(commit_raw_cptr commit) -> std::string;
 
@@ -616,6 +662,11 @@ namespace linter::git {
     auto index_to_workdir(repo_raw_ptr repo, index_raw_ptr index, diff_options_raw_cptr opts)
       -> diff_ptr;
 
+    /// Create a diff between a tree and the workdir directory. The index is
+    /// used to skip files whose stat info is unchanged.
+    auto tree_to_workdir(repo_raw_ptr repo, tree_raw_ptr old_tree, diff_options_raw_cptr opts)
+      -> diff_ptr;
+
     /// Create a diff with the difference between two tree objects.
     auto tree_to_tree(
       repo_raw_ptr repo,
@@ -642,6 +693,14 @@ namespace linter::git {
     /// Return the diff delta for an entry in the diff list.
     auto get_delta(diff_raw_cptr diff, size_t idx) -> diff_delta_raw_cptr;
 
+    /// Initialize the options of similarity detection with given flags.
+    auto init_find_option(std::uint32_t flags) -> git_diff_find_options;
+
+    /// Transform a diff marking file renames, copies, etc.
+    /// This modifies a diff in place, replacing old entries that look like
+    /// renames or copies with new entries reflecting those changes.
+    void find_similar(diff_raw_ptr diff, const git_diff_find_options &opts);
+
     /// Loop over all deltas in a diff issuing callbacks.
     auto for_each(
       diff_raw_ptr diff,
@@ -684,6 +743,10 @@ namespace linter::git {
 
     /// Parse a hex formatted object id into a git_oid.
     auto from_str(const std::string &str) -> git_oid;
+
+    /// Determine the object id a buffer would have if it was written to the
+    /// object database as a blob. The buffer isn't written to the database.
+    auto hash(std::string_view data) -> git_oid;
   } // namespace oid
 
   namespace ref {
@@ -881,6 +944,10 @@ namespace linter::git {
     auto entry_byname(tree_raw_cptr tree, const std::string &filename)
       -> std::tuple<oid_raw_cptr, tree_entry_raw_cptr>;
 
+    /// Lookup a tree entry by its path relative to the given tree, which may
+    /// contain subdirectories. Return nullptr if not found.
+    auto entry_bypath(tree_raw_cptr tree, const std::string &path) -> tree_entry_ptr;
+
   } // namespace tree
 
   namespace status {
@@ -913,9 +980,9 @@ namespace linter::git {
 
     /// Directly generate a patch from the difference between two buffers.
     auto create_from_buffers(
-      const std::string &old_buffer,
+      std::string_view old_buffer,
       const std::string &old_as_path,
-      const std::string &new_buffer,
+      std::string_view new_buffer,
       const std::string &new_as_path,
       const diff_options &opts) -> patch_ptr;
 
@@ -980,6 +1047,16 @@ namespace linter::git {
     /// Get a buffer with the raw content of a blob.
     auto get_raw_content(blob_raw_cptr blob) -> std::string;
 
+    /// Get a view of the raw content of a blob, which is only valid while the
+    /// blob is alive.
+    auto get_raw_view(blob_raw_cptr blob) -> std::string_view;
+
+    /// Determine if the blob content is most certainly binary or not.
+    /// The heuristic used to guess if a file is binary is taken from core git:
+    /// Searching for NUL bytes and looking for a reasonable ratio of printable
+    /// to non-printable characters among the first 8000 bytes.
+    auto is_binary(blob_raw_cptr blob) -> bool;
+
     /// A utility to get raw content by file name. Return empty if file not found.
     auto get_raw_content(repo_raw_ptr repo, tree_raw_cptr tree, const std::string &file_name)
       -> std::string;
@@ -988,5 +1065,22 @@ namespace linter::git {
     auto get_raw_content(repo_raw_ptr repo, commit_raw_cptr commit, const std::string &file_name)
       -> std::string;
 
+    /// The raw content of a blob without copying it. The blob is owned by the
+    /// view, so the content stays valid as long as the view is alive.
+    struct blob_view {
+      blob_ptr blob{nullptr, ::git_blob_free};
+      std::string_view content;
+    };
+
+    /// A utility to get a view of raw content by file path. The content is
+    /// empty if file not found.
+    auto get_view(repo_raw_ptr repo, commit_raw_cptr commit, const std::string &file_path)
+      -> blob_view;
+
+    /// The same as above, but of a tree resolved by the caller, so getting
+    /// views of many files doesn't resolve the tree of the commit each time.
+    auto get_view(repo_raw_ptr repo, tree_raw_cptr tree, const std::string &file_path)
+      -> blob_view;
+
   } // namespace blob
 } // namespace linter::git
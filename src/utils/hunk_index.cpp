@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "hunk_index.h"
+
+#include <algorithm>
+
+namespace linter::git {
+  hunk_index::hunk_index(patch_raw_ptr patch) {
+    const auto num_hunks = patch::num_hunks(patch);
+    auto pos             = std::size_t{0};
+    for (auto hunk_idx = std::size_t{0}; hunk_idx < num_hunks; ++hunk_idx) {
+      auto [hunk, num_lines] = patch::get_hunk(patch, hunk_idx);
+      // The header of the first hunk is position 0.
+      if (hunk_idx != 0) {
+        ++pos;
+      }
+
+      auto entry      = hunk_entry{};
+      entry.new_start = hunk.new_start;
+      entry.positions.reserve(hunk.new_lines);
+      for (auto line_idx = std::size_t{0}; line_idx < num_lines; ++line_idx) {
+        auto line = patch::get_line_in_hunk(patch, hunk_idx, line_idx);
+        ++pos;
+        if (line.new_lineno > 0
+            && (line.origin == GIT_DIFF_LINE_CONTEXT || line.origin == GIT_DIFF_LINE_ADDITION)) {
+          entry.positions.push_back(pos);
+        }
+      }
+      if (!entry.positions.empty()) {
+        hunks_.push_back(std::move(entry));
+      }
+    }
+  }
+
+  auto hunk_index::position(std::size_t row) const -> std::optional<std::size_t> {
+    auto iter = std::ranges::upper_bound(hunks_, row, {}, &hunk_entry::new_start);
+    if (iter == hunks_.begin()) {
+      return std::nullopt;
+    }
+    --iter;
+    auto offset = row - iter->new_start;
+    if (offset >= iter->positions.size()) {
+      return std::nullopt;
+    }
+    return iter->positions[offset];
+  }
+
+  auto hunk_index::contains(std::size_t first_row, std::size_t last_row) const -> bool {
+    auto iter = std::ranges::upper_bound(hunks_, first_row, {}, &hunk_entry::new_start);
+    if (iter == hunks_.begin() || last_row < first_row) {
+      return false;
+    }
+    --iter;
+    return last_row - iter->new_start < iter->positions.size();
+  }
+
+  auto hunk_index::num_hunks() const -> std::size_t {
+    return hunks_.size();
+  }
+
+  // Positions of rows in a hunk are mostly consecutive, so each hunk is saved
+  // as runs of [first position, number of rows].
+  void to_json(nlohmann::json &json, const hunk_index &index) {
+    json = nlohmann::json::array();
+    for (const auto &entry: index.hunks_) {
+      auto runs = nlohmann::json::array();
+      for (auto idx = std::size_t{0}; idx < entry.positions.size();) {
+        auto end = idx + 1;
+        while (end < entry.positions.size()
+               && entry.positions[end] == entry.positions[end - 1] + 1) {
+          ++end;
+        }
+        runs.push_back({entry.positions[idx], end - idx});
+        idx = end;
+      }
+      json.push_back({entry.new_start, std::move(runs)});
+    }
+  }
+
+  void from_json(const nlohmann::json &json, hunk_index &index) {
+    index.hunks_.clear();
+    for (const auto &hunk: json) {
+      auto entry      = hunk_index::hunk_entry{};
+      entry.new_start = hunk.at(0).get<std::size_t>();
+      for (const auto &run: hunk.at(1)) {
+        auto first = run.at(0).get<std::size_t>();
+        auto size  = run.at(1).get<std::size_t>();
+        for (auto offset = std::size_t{0}; offset < size; ++offset) {
+          entry.positions.push_back(first + offset);
+        }
+      }
+      index.hunks_.push_back(std::move(entry));
+    }
+  }
+} // namespace linter::git
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "utils/git_utils.h"
+
+namespace linter::git {
+  /// Map rows of the new file into positions of a patch, which are used by
+  /// Github review comments. A position is the number of lines down from the
+  /// first hunk header. Following hunk headers, deleted lines and context
+  /// lines are counted as well. Built once by walking the lines of all hunks,
+  /// so mapping a row is a binary search over hunks.
+  class hunk_index {
+  public:
+    hunk_index() = default;
+
+    /// Due to libgit2 limitation, patch can't be const qualified.
+    explicit hunk_index(patch_raw_ptr patch);
+
+    /// Return the position of a row, std::nullopt if the row isn't in any hunk.
+    [[nodiscard]] auto position(std::size_t row) const -> std::optional<std::size_t>;
+
+    /// Whether the rows [first_row, last_row] are all in one hunk, so they
+    /// could be commented on together.
+    [[nodiscard]] auto contains(std::size_t first_row, std::size_t last_row) const -> bool;
+
+    /// The number of hunks which contain rows of the new file.
+    [[nodiscard]] auto num_hunks() const -> std::size_t;
+
+    /// Saved in result files, so reports could be made without the patch.
+    friend void to_json(nlohmann::json &json, const hunk_index &index);
+    friend void from_json(const nlohmann::json &json, hunk_index &index);
+
+  private:
+    struct hunk_entry {
+      std::size_t new_start = 0;
+      /// The position of each row from new_start.
+      std::vector<std::size_t> positions;
+    };
+
+    /// Sorted by new_start.
+    std::vector<hunk_entry> hunks_;
+  };
+} // namespace linter::git
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/json_cache.h"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+namespace linter {
+  namespace {
+    auto read_file(const std::filesystem::path &path) -> std::optional<std::string> {
+      auto file = std::ifstream{path, std::ios::binary};
+      if (!file.is_open()) {
+        return std::nullopt;
+      }
+      return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+  } // namespace
+
+  json_cache::json_cache(const std::string &cache_dir, std::string_view name) {
+    if (!cache_dir.empty()) {
+      dir = std::filesystem::path{cache_dir} / name;
+    }
+  }
+
+  auto json_cache::enabled() const -> bool {
+    return !dir.empty();
+  }
+
+  auto json_cache::load(const std::string &key) const -> std::optional<nlohmann::json> {
+    if (!enabled()) {
+      return std::nullopt;
+    }
+    auto content = read_file(dir / (key + ".json"));
+    if (!content) {
+      return std::nullopt;
+    }
+    auto value = nlohmann::json::parse(*content, nullptr, false);
+    if (value.is_discarded()) {
+      spdlog::warn("Ignore the corrupted cache entry {}", key);
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  void json_cache::store(const std::string &key, const nlohmann::json &value) const {
+    if (!enabled()) {
+      return;
+    }
+    auto ec = std::error_code{};
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+      spdlog::warn("Failed to create cache directory {}: {}", dir.string(), ec.message());
+      return;
+    }
+
+    // Results may carry bytes of files which aren't UTF-8, e.g. Latin-1 sources,
+    // which are replaced rather than failing the check of the file.
+    auto content = std::string{};
+    try {
+      content = value.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    } catch (const std::exception &err) {
+      spdlog::warn("Failed to serialize cache entry {}: {}", key, err.what());
+      return;
+    }
+
+    // Write to a temporary file first, so a half written entry is never seen.
+    // Each writer has its own one, since the cache directory may be shared by
+    // several processes.
+    static auto counter = std::atomic<std::uint64_t>{0};
+    auto path           = dir / (key + ".json");
+    auto temp_name      = std::format("{}.json.{}-{}.tmp", key, ::getpid(), counter.fetch_add(1));
+    auto temp           = dir / temp_name;
+    {
+      auto file = std::ofstream{temp, std::ios::binary | std::ios::trunc};
+      if (!file.is_open()) {
+        spdlog::warn("Failed to open cache entry {} to write", temp.string());
+        return;
+      }
+      file << content;
+      file.flush();
+      if (!file.good()) {
+        spdlog::warn("Failed to write cache entry {}", temp.string());
+        file.close();
+        std::filesystem::remove(temp, ec);
+        return;
+      }
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+      spdlog::warn("Failed to write cache entry {}: {}", path.string(), ec.message());
+      std::filesystem::remove(temp, ec);
+    }
+  }
+} // namespace linter
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+namespace linter {
+  /// An on-disk cache of json values. Each entry is a json file named by its
+  /// key under the directory of the given name, so the whole cache directory
+  /// could be saved and restored between CI runs, e.g. by actions/cache.
+  struct json_cache {
+    json_cache(const std::string &cache_dir, std::string_view name);
+
+    /// The cache is disabled if no cache directory is given.
+    [[nodiscard]] auto enabled() const -> bool;
+
+    /// Load the cached entry of the given key. Return std::nullopt if missed.
+    [[nodiscard]] auto load(const std::string &key) const -> std::optional<nlohmann::json>;
+
+    /// Store an entry. Failures are only logged since the cache is merely an
+    /// optimization.
+    void store(const std::string &key, const nlohmann::json &value) const;
+
+    std::filesystem::path dir;
+  };
+} // namespace linter
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "line_index.h"
+
+#include <algorithm>
+
+namespace linter {
+  line_index::line_index(std::string_view buffer)
+    : size(buffer.size()) {
+    starts.push_back(0);
+    for (auto pos = buffer.find('\n'); pos != std::string_view::npos;
+         pos      = buffer.find('\n', pos + 1)) {
+      starts.push_back(pos + 1);
+    }
+  }
+
+  auto line_index::position(std::size_t offset) const
+    -> std::optional<std::pair<std::size_t, std::size_t>> {
+    if (starts.empty() || offset > size) {
+      return std::nullopt;
+    }
+    auto iter = std::ranges::upper_bound(starts, offset);
+    auto row  = static_cast<std::size_t>(iter - starts.begin());
+    return std::pair{row, offset - starts[row - 1] + 1};
+  }
+
+  auto line_index::line_start(std::size_t row) const -> std::optional<std::size_t> {
+    if (row == 0 || row > starts.size()) {
+      return std::nullopt;
+    }
+    return starts[row - 1];
+  }
+
+  auto line_index::num_lines() const -> std::size_t {
+    return starts.size();
+  }
+} // namespace linter
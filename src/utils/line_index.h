@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace linter {
+  /// An index of the line starts of a buffer, which converts an offset into a
+  /// row and a column by binary search. Rows and columns start from 1 while
+  /// offsets start from 0.
+  struct line_index {
+    line_index() = default;
+    explicit line_index(std::string_view buffer);
+
+    /// Return the row and column of the given offset, or std::nullopt if the
+    /// offset is out of the buffer. The end of buffer is a valid position.
+    [[nodiscard]] auto position(std::size_t offset) const
+      -> std::optional<std::pair<std::size_t, std::size_t>>;
+
+    /// Return the offset of the first character of the given row, or
+    /// std::nullopt if the row doesn't exist.
+    [[nodiscard]] auto line_start(std::size_t row) const -> std::optional<std::size_t>;
+
+    [[nodiscard]] auto num_lines() const -> std::size_t;
+
+    std::vector<std::size_t> starts;
+    std::size_t size = 0;
+  };
+} // namespace linter
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+/// Log by the default logger only if the level is enabled, so arguments are
+/// neither evaluated nor formatted otherwise. Logs below SPDLOG_ACTIVE_LEVEL
+/// are compiled out, and the others are checked against the runtime level.
+/// Use them on hot paths or when arguments are expensive to make, e.g. a
+/// joined command line.
+#define LINTER_LOG(active_level, level, ...)                                                       \
+  do {                                                                                             \
+    if constexpr ((active_level) >= SPDLOG_ACTIVE_LEVEL) {                                         \
+      if (spdlog::should_log(level)) {                                                             \
+        spdlog::log(level, __VA_ARGS__);                                                           \
+      }                                                                                            \
+    }                                                                                              \
+  } while (false)
+
+#define LINTER_TRACE(...) LINTER_LOG(SPDLOG_LEVEL_TRACE, spdlog::level::trace, __VA_ARGS__)
+#define LINTER_DEBUG(...) LINTER_LOG(SPDLOG_LEVEL_DEBUG, spdlog::level::debug, __VA_ARGS__)
+#define LINTER_INFO(...)  LINTER_LOG(SPDLOG_LEVEL_INFO, spdlog::level::info, __VA_ARGS__)
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/output_sink.h"
+
+#include <algorithm>
+#include <format>
+#include <utility>
+
+namespace linter::shell {
+  line_splitter::line_splitter(line_callback on_line)
+    : on_line_(std::move(on_line)) {
+  }
+
+  void line_splitter::feed(std::string_view chunk) {
+    while (!chunk.empty()) {
+      auto end = chunk.find('\n');
+      if (end == std::string_view::npos) {
+        partial_.append(chunk);
+        return;
+      }
+      // Lines within a chunk are passed without copying.
+      if (partial_.empty()) {
+        emit(chunk.substr(0, end));
+      } else {
+        partial_.append(chunk.substr(0, end));
+        emit(partial_);
+        partial_.clear();
+      }
+      chunk.remove_prefix(end + 1);
+    }
+  }
+
+  void line_splitter::finish() {
+    if (!partial_.empty()) {
+      emit(partial_);
+      partial_.clear();
+    }
+  }
+
+  void line_splitter::emit(std::string_view line) {
+    if (line.ends_with('\r')) {
+      line.remove_suffix(1);
+    }
+    on_line_(line);
+  }
+
+  capped_output::capped_output(std::size_t max_size)
+    : max_size_(max_size) {
+  }
+
+  void capped_output::append(std::string_view chunk) {
+    auto size = std::min(chunk.size(), max_size_ - content_.size());
+    content_.append(chunk.substr(0, size));
+    dropped_ += chunk.size() - size;
+  }
+
+  auto capped_output::str() const -> std::string {
+    if (dropped_ == 0) {
+      return content_;
+    }
+    return std::format("{}\n... {} bytes are truncated", content_, dropped_);
+  }
+
+  auto chunk_queue::sink() -> output_sink {
+    return [this](std::string_view chunk) {
+      auto lock = std::lock_guard{mutex_};
+      chunks_.emplace_back(chunk);
+      ready_.notify_one();
+    };
+  }
+
+  void chunk_queue::close() {
+    auto lock = std::lock_guard{mutex_};
+    closed_   = true;
+    ready_.notify_one();
+  }
+
+  auto chunk_queue::take() -> std::vector<std::string> {
+    auto lock = std::unique_lock{mutex_};
+    ready_.wait(lock, [this] { return closed_ || !chunks_.empty(); });
+    return std::exchange(chunks_, {});
+  }
+
+} // namespace linter::shell
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace linter::shell {
+  /// Receive an output of a child process chunk by chunk as it arrives from
+  /// the pipe, rather than accumulating the whole output in memory.
+  using output_sink = std::function<void(std::string_view chunk)>;
+
+  /// Split chunks of an output into lines. Only an unfinished line is kept
+  /// between chunks. The trailing carriage return of a line is dropped.
+  class line_splitter {
+  public:
+    using line_callback = std::function<void(std::string_view line)>;
+
+    explicit line_splitter(line_callback on_line);
+
+    void feed(std::string_view chunk);
+
+    /// Pass the last line if it doesn't end with a newline.
+    void finish();
+
+  private:
+    void emit(std::string_view line);
+
+    line_callback on_line_;
+    std::string partial_;
+  };
+
+  /// Keep the head of an output up to a size limit, so the raw output is still
+  /// available to debug without holding a huge output.
+  class capped_output {
+  public:
+    explicit capped_output(std::size_t max_size);
+
+    void append(std::string_view chunk);
+
+    /// The kept content, followed by a note of the dropped size if truncated.
+    [[nodiscard]] auto str() const -> std::string;
+
+  private:
+    std::size_t max_size_;
+    std::string content_;
+    std::size_t dropped_ = 0;
+  };
+
+  /// Hand chunks of an output over from the runner thread to the thread which
+  /// consumes them. The runner thread only copies chunks, so parsing a huge
+  /// output doesn't hold up the outputs of other child processes.
+  class chunk_queue {
+  public:
+    /// The sink to be given to the child process. It never blocks.
+    auto sink() -> output_sink;
+
+    /// No more chunk will be pushed, e.g. since the child process exited.
+    void close();
+
+    /// Wait for chunks and take all of them. Return nothing once closed and
+    /// all chunks are taken.
+    auto take() -> std::vector<std::string>;
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<std::string> chunks_;
+    bool closed_ = false;
+  };
+
+} // namespace linter::shell
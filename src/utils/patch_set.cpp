@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "patch_set.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <format>
+#include <thread>
+#include <utility>
+
+#include "utils/git_error.h"
+#include "utils/trace.h"
+
+namespace linter::git {
+  namespace {
+    constexpr auto min_deltas_per_thread = std::size_t{64};
+
+    // The filter may look up blobs, e.g. to detect binary files, which is the
+    // slowest part of enumerating a large diff. So deltas are filtered by
+    // several threads, each takes the next delta not filtered yet.
+    auto filter_deltas(diff_raw_ptr diff, const patch_set::delta_filter &filter)
+      -> std::vector<char> {
+      auto num_deltas = diff::num_deltas(diff);
+      auto kept       = std::vector<char>(num_deltas, 1);
+      if (!filter) {
+        return kept;
+      }
+
+      auto next  = std::atomic<std::size_t>{0};
+      auto mutex = std::mutex{};
+      auto error = std::exception_ptr{};
+      auto work  = [&] {
+        for (auto idx = next++; idx < num_deltas; idx = next++) {
+          try {
+            kept[idx] = filter(*diff::get_delta(diff, idx)) ? 1 : 0;
+          } catch (...) {
+            auto lock = std::scoped_lock{mutex};
+            if (!error) {
+              error = std::current_exception();
+            }
+          }
+        }
+      };
+      auto num_threads = std::min<std::size_t>(std::max(1U, std::thread::hardware_concurrency()),
+                                               num_deltas / min_deltas_per_thread + 1);
+      {
+        auto threads = std::vector<std::jthread>{};
+        for (auto idx = std::size_t{1}; idx < num_threads; ++idx) {
+          threads.emplace_back(work);
+        }
+        work();
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      return kept;
+    }
+  } // namespace
+
+  patch_set::patch_set(diff_ptr diff, const delta_filter &filter)
+    : diff_(std::move(diff)) {
+    auto kept = filter_deltas(diff_.get(), filter);
+    for (auto idx = std::size_t{0}; idx < kept.size(); ++idx) {
+      if (kept[idx] == 0) {
+        continue;
+      }
+      const auto *delta = diff::get_delta(diff_.get(), idx);
+      files_.emplace_back(delta->new_file.path);
+      indexes_.emplace(files_.back(), entry{.delta_idx = idx, .patch_idx = patches_.size()});
+      patches_.emplace_back(nullptr, ::git_patch_free);
+    }
+    hunks_.resize(patches_.size());
+  }
+
+  patch_set::patch_set(std::vector<std::pair<std::string, hunk_index>> hunks) {
+    for (auto &[file, index]: hunks) {
+      files_.push_back(std::move(file));
+      indexes_.emplace(files_.back(), entry{.delta_idx = 0, .patch_idx = patches_.size()});
+      patches_.emplace_back(nullptr, ::git_patch_free);
+      hunks_.emplace_back(std::move(index));
+    }
+  }
+
+  patch_set::patch_set(patch_set &&other) noexcept
+    : diff_(std::move(other.diff_))
+    , files_(std::move(other.files_))
+    , indexes_(std::move(other.indexes_))
+    , patches_(std::move(other.patches_))
+    , hunks_(std::move(other.hunks_)) {
+  }
+
+  auto patch_set::operator=(patch_set &&other) noexcept -> patch_set & {
+    diff_    = std::move(other.diff_);
+    files_   = std::move(other.files_);
+    indexes_ = std::move(other.indexes_);
+    patches_ = std::move(other.patches_);
+    hunks_   = std::move(other.hunks_);
+    return *this;
+  }
+
+  auto patch_set::files() const -> const std::vector<std::string> & {
+    return files_;
+  }
+
+  auto patch_set::contains(const std::string &file) const -> bool {
+    return indexes_.contains(file);
+  }
+
+  auto patch_set::size() const -> std::size_t {
+    return files_.size();
+  }
+
+  auto patch_set::at(const std::string &file) const -> patch_raw_ptr {
+    auto iter = indexes_.find(file);
+    throw_if(iter == indexes_.end(), std::format("no patch of {} in the diff", file));
+
+    auto lock   = std::scoped_lock{mutex_};
+    auto &patch = patches_[iter->second.patch_idx];
+    if (patch == nullptr) {
+      throw_if(diff_ == nullptr, std::format("the patch of {} isn't kept", file));
+      auto scope = trace::scope{"git", std::format("patch {}", file)};
+      patch      = patch::create_from_diff(diff_.get(), iter->second.delta_idx);
+    }
+    return patch.get();
+  }
+
+  auto patch_set::hunks(const std::string &file) const -> const hunk_index & {
+    auto iter = indexes_.find(file);
+    throw_if(iter == indexes_.end(), std::format("no patch of {} in the diff", file));
+    {
+      auto lock = std::scoped_lock{mutex_};
+      if (const auto &hunk = hunks_[iter->second.patch_idx]) {
+        return *hunk;
+      }
+    }
+
+    auto *patch = at(file);
+    auto lock   = std::scoped_lock{mutex_};
+    auto &hunk  = hunks_[iter->second.patch_idx];
+    if (!hunk) {
+      hunk.emplace(patch);
+    }
+    return *hunk;
+  }
+
+  auto needs_check(repo_raw_ptr repo, const diff_delta &delta) -> bool {
+    if (delta.status == GIT_DELTA_DELETED || delta.new_file.mode == GIT_FILEMODE_COMMIT) {
+      return false;
+    }
+    // A copy is a file never checked at its new path, so only renames are
+    // dropped.
+    if (delta.status == GIT_DELTA_RENAMED && delta.similarity == 100) {
+      return false;
+    }
+    if ((delta.flags & GIT_DIFF_FLAG_BINARY) != 0) {
+      return false;
+    }
+    if ((delta.flags & GIT_DIFF_FLAG_NOT_BINARY) != 0) {
+      return true;
+    }
+    auto blob = blob::lookup(repo, &delta.new_file.id);
+    return !blob::is_binary(blob.get());
+  }
+} // namespace linter::git
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/git_utils.h"
+#include "utils/hunk_index.h"
+
+namespace linter::git {
+  /// The patches of a diff keyed by the new path of each delta. Indexing the
+  /// deltas is cheap, so it's done up front. However, creating the patch of a
+  /// delta loads and diffs both blobs, so it's deferred until the first time
+  /// the patch is used. Files which are never reported on, such as those
+  /// filtered out by tools, never pay for it.
+  ///
+  /// It's safe to get patches from multiple threads. Creation is serialized
+  /// since libgit2 updates the shared diff while creating a patch from it.
+  class patch_set {
+  public:
+    /// Decide whether a delta is kept in the patch set. It's called by several
+    /// threads for a large diff, so it must be thread safe.
+    using delta_filter = std::function<bool(const diff_delta &)>;
+
+    patch_set() = default;
+    explicit patch_set(diff_ptr diff, const delta_filter &filter = {});
+
+    /// Restore a patch set from the hunk indexes saved in result files. It has
+    /// no diff, so only hunks of the given files are available.
+    explicit patch_set(std::vector<std::pair<std::string, hunk_index>> hunks);
+
+    patch_set(patch_set &&other) noexcept;
+    auto operator=(patch_set &&other) noexcept -> patch_set &;
+
+    /// The new paths of all deltas in the order of diff.
+    [[nodiscard]] auto files() const -> const std::vector<std::string> &;
+
+    [[nodiscard]] auto contains(const std::string &file) const -> bool;
+
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /// Get the patch of a file, create it if needed. Throw if not found or the
+    /// patch set is restored from hunk indexes.
+    [[nodiscard]] auto at(const std::string &file) const -> patch_raw_ptr;
+
+    /// Get the hunk index of a file, build it if needed. It's shared by all
+    /// reporters. Throw if not found.
+    [[nodiscard]] auto hunks(const std::string &file) const -> const hunk_index &;
+
+  private:
+    struct entry {
+      std::size_t delta_idx;
+      std::size_t patch_idx;
+    };
+
+    diff_ptr diff_{nullptr, ::git_diff_free};
+    std::vector<std::string> files_;
+    std::unordered_map<std::string, entry> indexes_;
+    mutable std::vector<patch_ptr> patches_;
+    mutable std::vector<std::optional<hunk_index>> hunks_;
+    mutable std::mutex mutex_;
+  };
+
+  /// Return whether the content of a delta needs to be checked. Deleted files,
+  /// submodules, binary files and files renamed without content changes don't
+  /// need to, so they needn't be passed to tools at all. Copies are kept since
+  /// they are new files. Similarity must have been detected for renames to be
+  /// known.
+  auto needs_check(repo_raw_ptr repo, const diff_delta &delta) -> bool;
+} // namespace linter::git
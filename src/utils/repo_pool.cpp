@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "repo_pool.h"
+
+#include <utility>
+
+namespace linter::git {
+  repo_pool::lease::lease(const repo_pool &pool, std::unique_ptr<handle> value)
+    : pool_(&pool)
+    , value_(std::move(value)) {
+  }
+
+  repo_pool::lease::~lease() {
+    if (value_) {
+      pool_->release(std::move(value_));
+    }
+  }
+
+  repo_pool::repo_pool(std::string repo_path,
+                       const git_oid &target,
+                       const git_oid &source,
+                       bool staged)
+    : repo_path_(std::move(repo_path))
+    , target_(target)
+    , source_(source)
+    , staged_(staged) {
+  }
+
+  auto repo_pool::acquire() const -> lease {
+    {
+      auto lock = std::lock_guard{mutex_};
+      if (!idle_.empty()) {
+        auto value = std::move(idle_.back());
+        idle_.pop_back();
+        return lease{*this, std::move(value)};
+      }
+    }
+
+    // Opened out of the lock, so threads don't wait for each other.
+    auto value    = std::make_unique<handle>();
+    value->repo   = repo::open(repo_path_);
+    value->target = commit::lookup(value->repo.get(), &target_);
+    if (staged_) {
+      // The staged commit only lives in the memory of the repository which
+      // created it, so it's created again from the same index.
+      repo::use_memory_odb(value->repo.get());
+      value->source = commit::create_staged(value->repo.get());
+      throw_unless(oid::equal(*commit::id(value->source.get()), source_),
+                   "the index is changed while checking staged changes");
+    } else {
+      value->source = commit::lookup(value->repo.get(), &source_);
+    }
+    value->source_tree = commit::tree(value->source.get());
+    return lease{*this, std::move(value)};
+  }
+
+  auto repo_pool::repo_path() const -> const std::string & {
+    return repo_path_;
+  }
+
+  auto repo_pool::target_id() const -> const git_oid & {
+    return target_;
+  }
+
+  auto repo_pool::source_id() const -> const git_oid & {
+    return source_;
+  }
+
+  void repo_pool::release(std::unique_ptr<handle> value) const {
+    auto lock = std::lock_guard{mutex_};
+    idle_.push_back(std::move(value));
+  }
+} // namespace linter::git
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils/git_utils.h"
+
+namespace linter::git {
+  /// Repository handles used by several threads. libgit2 objects mustn't be
+  /// used by several threads at once, so rather than sharing the repository
+  /// and commits of the runtime context, each thread leases a handle opened
+  /// from the immutable path and commit ids. A returned handle is reused by the
+  /// next lease, so only as many repositories are opened as threads using them
+  /// at the same time.
+  class repo_pool {
+  public:
+    /// The repository and the commits of the checked revisions.
+    struct handle {
+      repo_ptr repo{nullptr, ::git_repository_free};
+      commit_ptr target{nullptr, ::git_commit_free};
+      commit_ptr source{nullptr, ::git_commit_free};
+      tree_ptr source_tree{nullptr, ::git_tree_free};
+    };
+
+    /// A handle owned by one thread until the lease is destroyed.
+    class lease {
+    public:
+      lease(const repo_pool &pool, std::unique_ptr<handle> value);
+      lease(lease &&other) noexcept = default;
+      lease(const lease &)          = delete;
+      auto operator=(lease &&) -> lease & = delete;
+      auto operator=(const lease &) -> lease & = delete;
+      ~lease();
+
+      auto operator->() const -> handle * {
+        return value_.get();
+      }
+
+      auto operator*() const -> handle & {
+        return *value_;
+      }
+
+    private:
+      const repo_pool *pool_;
+      std::unique_ptr<handle> value_;
+    };
+
+    /// If staged is set, source is the commit created of the index by
+    /// commit::create_staged, which each handle creates again in memory.
+    repo_pool(std::string repo_path,
+              const git_oid &target,
+              const git_oid &source,
+              bool staged = false);
+
+    /// Lease an idle handle, or open a new one if there's none. Thread safe.
+    [[nodiscard]] auto acquire() const -> lease;
+
+    [[nodiscard]] auto repo_path() const -> const std::string &;
+    [[nodiscard]] auto target_id() const -> const git_oid &;
+    [[nodiscard]] auto source_id() const -> const git_oid &;
+
+  private:
+    void release(std::unique_ptr<handle> value) const;
+
+    std::string repo_path_;
+    git_oid target_;
+    git_oid source_;
+    bool staged_;
+    mutable std::mutex mutex_;
+    mutable std::vector<std::unique_ptr<handle>> idle_;
+  };
+} // namespace linter::git
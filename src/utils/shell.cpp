@@ -15,135 +15,507 @@
  */
 #include "shell.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define BOOST_PROCESS_V2_SEPARATE_COMPILATION
 #include <boost/asio/error.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/read.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/readable_pipe.hpp>
+#include <boost/asio/writable_pipe.hpp>
+#include <boost/asio/write.hpp>
 #include <boost/process/v2.hpp>
 #include <boost/process/v2/src.hpp>
 #include <boost/process/v2/start_dir.hpp>
 
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace linter::shell {
   namespace bp = boost::process::v2;
 
+  namespace {
+    // The state of one child process shared by its completion handlers. All
+    // handlers run on the runner thread, so no synchronization is needed.
+    struct execution {
+      execution(boost::asio::io_context &context,
+                std::string_view cmd,
+                const execute_config &config,
+                callback callback)
+        : command(cmd)
+        , in(context)
+        , out(context)
+        , err(context)
+        , input(config.std_in)
+        , out_sink(config.std_out_sink)
+        , err_sink(config.std_err_sink)
+        , cb(std::move(callback))
+        , timer(context)
+        , pending(input ? 4 : 3) {
+      }
+
+      std::string command;
+      boost::asio::writable_pipe in;
+      boost::asio::readable_pipe out;
+      boost::asio::readable_pipe err;
+      std::optional<bp::process> proc;
+      result res{};
+      std::exception_ptr error;
+      std::optional<std::string> input;
+      output_sink out_sink;
+      output_sink err_sink;
+      callback cb;
+
+      // Kills the child process at its deadline unless it exited before.
+      boost::asio::steady_timer timer;
+      bool exited = false;
+
+      // Writing of stdin if any, reading of stdout, reading of stderr and
+      // waiting for exit.
+      int pending;
+
+      // The wall time of the child process is traced from launch to the end
+      // of draining its outputs.
+      std::optional<trace::event> trace_event;
+
+      void finish_one() {
+        if (--pending != 0) {
+          return;
+        }
+        if (trace_event) {
+          trace_event->duration  = trace::now() - trace_event->start;
+          trace_event->thread_id = trace::current_thread_id();
+          trace::record(*std::move(trace_event));
+        }
+        cb(error, std::move(res));
+      }
+
+      void set_error(const std::string &msg) {
+        if (!error) {
+          error = std::make_exception_ptr(std::runtime_error{msg});
+        }
+      }
+    };
+
+    using execution_ptr = std::shared_ptr<execution>;
+
+    // Launch the child process in a new process group, so its descendants are
+    // killed together with it when it times out.
+    struct new_process_group {
+      template <class Launcher>
+      auto on_exec_setup(Launcher & /*launcher*/,
+                         const bp::filesystem::path & /*executable*/,
+                         const char *const *& /*cmd_line*/) -> bp::error_code {
+        ::setpgid(0, 0);
+        return {};
+      }
+    };
+
+    template <class... Inits>
+    auto launch(boost::asio::io_context &context,
+                std::string_view command,
+                const options &opts,
+                const execute_config &config,
+                execution &exec,
+                Inits &&...inits) -> bp::process {
+      auto stdio = exec.input ? bp::process_stdio{.in = exec.in, .out = exec.out, .err = exec.err}
+                              : bp::process_stdio{.in = {}, .out = exec.out, .err = exec.err};
+      if (!config.env.empty() && !config.start_dir.empty()) {
+        return bp::process{context,
+                           command,
+                           opts,
+                           stdio,
+                           bp::process_environment{config.env},
+                           bp::process_start_dir{config.start_dir},
+                           inits...};
+      }
+      if (!config.env.empty()) {
+        return bp::process{
+          context, command, opts, stdio, bp::process_environment{config.env}, inits...};
+      }
+      if (!config.start_dir.empty()) {
+        return bp::process{
+          context, command, opts, stdio, bp::process_start_dir{config.start_dir}, inits...};
+      }
+      return bp::process{context, command, opts, stdio, inits...};
+    }
+
+    void async_drain(const execution_ptr &exec,
+                     boost::asio::readable_pipe &pipe,
+                     std::string &buffer,
+                     std::string_view name) {
+      boost::asio::async_read(
+        pipe,
+        boost::asio::dynamic_buffer(buffer),
+        [exec, name](const boost::system::error_code &ec, std::size_t /*size*/) {
+          if (ec && ec != boost::asio::error::eof) {
+            exec->set_error(std::format("Read {} message of {} faild since {}",
+                                        name,
+                                        exec->command,
+                                        ec.message()));
+          }
+          exec->finish_one();
+        });
+    }
+
+    // The size of each read when an output is streamed to a sink.
+    constexpr auto stream_chunk_size = std::size_t{64} * 1024;
+
+    // Pass the output to the sink chunk by chunk, so only one chunk is held in
+    // memory no matter how large the output is.
+    void async_stream(const execution_ptr &exec,
+                      boost::asio::readable_pipe &pipe,
+                      const output_sink &sink,
+                      std::shared_ptr<std::string> chunk,
+                      std::string_view name) {
+      auto buffer = boost::asio::buffer(*chunk);
+      pipe.async_read_some(
+        buffer,
+        [exec, &pipe, &sink, chunk = std::move(chunk), name](const boost::system::error_code &ec,
+                                                             std::size_t size) mutable {
+          if (size > 0 && !exec->error) {
+            try {
+              sink(std::string_view{chunk->data(), size});
+            } catch (const std::exception &err) {
+              exec->set_error(std::format("Handle {} message of {} failed since {}",
+                                          name,
+                                          exec->command,
+                                          err.what()));
+            }
+          }
+          if (!ec) {
+            async_stream(exec, pipe, sink, std::move(chunk), name);
+            return;
+          }
+          if (ec != boost::asio::error::eof) {
+            exec->set_error(std::format("Read {} message of {} faild since {}",
+                                        name,
+                                        exec->command,
+                                        ec.message()));
+          }
+          exec->finish_one();
+        });
+    }
+
+    void async_stream(const execution_ptr &exec,
+                      boost::asio::readable_pipe &pipe,
+                      const output_sink &sink,
+                      std::string_view name) {
+      async_stream(exec, pipe, sink, std::make_shared<std::string>(stream_chunk_size, '\0'), name);
+    }
+
+    void async_feed(const execution_ptr &exec) {
+      boost::asio::async_write(
+        exec->in,
+        boost::asio::buffer(*exec->input),
+        [exec](const boost::system::error_code &ec, std::size_t /*size*/) {
+          // The child process may exit without reading all of its input.
+          if (ec && ec != boost::asio::error::broken_pipe) {
+            exec->set_error(
+              std::format("Write stdin of {} faild since {}", exec->command, ec.message()));
+          }
+          auto close_ec = boost::system::error_code{};
+          exec->in.close(close_ec);
+          exec->finish_one();
+        });
+    }
+
+    void set_exited(const execution_ptr &exec) {
+      exec->exited = true;
+      exec->timer.cancel();
+    }
+
+    void async_reap(const execution_ptr &exec) {
+      exec->proc->async_wait([exec](const boost::system::error_code &ec, int exit_code) {
+        set_exited(exec);
+        if (ec) {
+          exec->set_error(
+            std::format("Wait for {} failed since {}", exec->command, ec.message()));
+        }
+        exec->res.exit_code = exit_code;
+        exec->finish_one();
+      });
+    }
+
+    auto to_ms(const timeval &time) -> double {
+      return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_usec) / 1000.0;
+    }
+
+    // The CPU time of each child process is traced, so slow tools could be
+    // told from busy machines.
+    void record_cpu_time(execution &exec, const rusage &usage) {
+      if (exec.trace_event) {
+        exec.trace_event->args.emplace_back("user_ms", to_ms(usage.ru_utime));
+        exec.trace_event->args.emplace_back("system_ms", to_ms(usage.ru_stime));
+      }
+    }
+
+    // The resource usage of a child process is lost once it's reaped, so the
+    // exit is waited by a pidfd and the peak RSS and CPU time are read by
+    // waitid with WNOWAIT before the process is reaped. The process is reaped
+    // directly if pidfd isn't supported, and then they're unknown.
+    void async_wait_exit(const execution_ptr &exec) {
+#if defined(SYS_pidfd_open) && defined(SYS_waitid)
+      auto pid = exec->proc->id();
+      auto fd  = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+      if (fd >= 0) {
+        using descriptor = boost::asio::posix::stream_descriptor;
+        auto pidfd       = std::make_shared<descriptor>(exec->in.get_executor(), fd);
+        pidfd->async_wait(descriptor::wait_read,
+                          [exec, pidfd, pid](const boost::system::error_code &ec) {
+                            auto info  = siginfo_t{};
+                            auto usage = rusage{};
+                            if (!ec
+                                && ::syscall(
+                                     SYS_waitid, P_PID, pid, &info, WEXITED | WNOWAIT, &usage)
+                                     == 0) {
+                              // In kilobytes on Linux.
+                              exec->res.peak_rss = static_cast<std::uint64_t>(usage.ru_maxrss)
+                                                 * 1024;
+                              record_cpu_time(*exec, usage);
+                            }
+                            set_exited(exec);
+                            async_reap(exec);
+                          });
+        return;
+      }
+#endif
+      async_reap(exec);
+    }
+
+    // Kill the child process and its process group if it has one.
+    void kill_process(const execution &exec) {
+      auto pid = exec.proc->id();
+      if (::kill(-pid, SIGKILL) != 0) {
+        // The child process may not have made its process group yet.
+        ::kill(pid, SIGKILL);
+      }
+    }
+
+    // The outputs are drained until the killed processes close the pipes, so
+    // what's printed before the deadline is kept.
+    void async_kill_at(const execution_ptr &exec, std::chrono::steady_clock::time_point deadline) {
+      exec->timer.expires_at(deadline);
+      exec->timer.async_wait([exec](const boost::system::error_code &ec) {
+        if (ec || exec->exited) {
+          return;
+        }
+        exec->res.timed_out = true;
+        kill_process(*exec);
+      });
+    }
+
+  } // namespace
+
+  struct runner::impl {
+    boost::asio::io_context context;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> guard{
+      context.get_executor()};
+    std::thread thread{[this] { context.run(); }};
+
+    // The ticks of steady clock since epoch, 0 means no deadline.
+    std::atomic<std::chrono::steady_clock::rep> deadline{0};
+
+    // The launched child processes to be killed by kill_all. Only touched on
+    // the runner thread.
+    std::vector<std::weak_ptr<execution>> launched;
+
+    auto deadline_of(const execute_config &config) const
+      -> std::optional<std::chrono::steady_clock::time_point> {
+      auto ret = std::optional<std::chrono::steady_clock::time_point>{};
+      if (auto ticks = deadline.load(); ticks != 0) {
+        ret.emplace(std::chrono::steady_clock::duration{ticks});
+      }
+      if (config.timeout.count() > 0) {
+        auto own = std::chrono::steady_clock::now() + config.timeout;
+        ret      = ret ? std::min(*ret, own) : own;
+      }
+      return ret;
+    }
+  };
+
+  runner::runner()
+    : impl_(std::make_unique<impl>()) {
+  }
+
+  runner::~runner() {
+    impl_->guard.reset();
+    impl_->thread.join();
+  }
+
+  auto runner::instance() -> runner & {
+    static auto instance = runner{};
+    return instance;
+  }
+
+  void runner::async_execute(std::string_view command,
+                             const options &opts,
+                             const execute_config &config,
+                             callback cb) {
+    auto &context = impl_->context;
+    auto exec     = std::make_shared<execution>(context, command, config, std::move(cb));
+    if (trace::enabled()) {
+      auto evt     = trace::event{};
+      evt.category = "process";
+      evt.name     = std::filesystem::path{command}.filename().string();
+      evt.detail   = opts | std::views::join_with(' ') | std::ranges::to<std::string>();
+      evt.start    = trace::now();
+      exec->trace_event.emplace(std::move(evt));
+    }
+    auto deadline = impl_->deadline_of(config);
+
+    // The process is launched and its pipes are touched only on the runner
+    // thread, so is the callback invoked if it couldn't be launched.
+    boost::asio::post(context, [&context, impl = impl_.get(), exec, opts, config, deadline] {
+      try {
+        if (deadline) {
+          exec->proc.emplace(
+            launch(context, exec->command, opts, config, *exec, new_process_group{}));
+        } else {
+          exec->proc.emplace(launch(context, exec->command, opts, config, *exec));
+        }
+      } catch (...) {
+        exec->cb(std::current_exception(), {});
+        return;
+      }
+      std::erase_if(impl->launched, [](const auto &weak) { return weak.expired(); });
+      impl->launched.push_back(exec);
+
+      if (deadline) {
+        async_kill_at(exec, *deadline);
+      }
+      if (exec->input) {
+        async_feed(exec);
+      }
+      if (exec->out_sink) {
+        async_stream(exec, exec->out, exec->out_sink, "stdout");
+      } else {
+        async_drain(exec, exec->out, exec->res.std_out, "stdout");
+      }
+      if (exec->err_sink) {
+        async_stream(exec, exec->err, exec->err_sink, "stderr");
+      } else {
+        async_drain(exec, exec->err, exec->res.std_err, "stderr");
+      }
+      async_wait_exit(exec);
+    });
+  }
+
+  auto runner::async_execute(std::string_view command,
+                             const options &opts,
+                             const execute_config &config) -> std::future<result> {
+    auto promise = std::make_shared<std::promise<result>>();
+    auto future  = promise->get_future();
+    async_execute(command, opts, config, [promise](std::exception_ptr error, result res) {
+      if (error) {
+        promise->set_exception(std::move(error));
+      } else {
+        promise->set_value(std::move(res));
+      }
+    });
+    return future;
+  }
+
+  void runner::set_deadline(std::chrono::steady_clock::time_point deadline) {
+    impl_->deadline = deadline.time_since_epoch().count();
+  }
+
+  void runner::kill_all() {
+    boost::asio::post(impl_->context, [impl = impl_.get()] {
+      for (const auto &weak: std::exchange(impl->launched, {})) {
+        auto exec = weak.lock();
+        if (exec == nullptr || exec->exited) {
+          continue;
+        }
+        exec->res.killed = true;
+        kill_process(*exec);
+      }
+    });
+  }
+
+  void async_execute(std::string_view command,
+                     const options &opts,
+                     const execute_config &config,
+                     callback cb) {
+    runner::instance().async_execute(command, opts, config, std::move(cb));
+  }
+
+  auto async_execute(std::string_view command, const options &opts, const execute_config &config)
+    -> std::future<result> {
+    return runner::instance().async_execute(command, opts, config);
+  }
+
   auto execute(std::string_view command, const options &opts) -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err});
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts).get();
   }
 
   auto execute(std::string_view command, const options &opts, std::string_view start_dir)
     -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err},
-      bp::process_start_dir{start_dir});
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts, {.env = {}, .start_dir = std::string{start_dir}}).get();
   }
 
   auto execute(std::string_view command, const options &opts, const envrionment &env) -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err},
-      bp::process_environment{env});
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts, {.env = env, .start_dir = {}}).get();
   }
 
   auto execute(std::string_view command,
                const options &opts,
                const envrionment &env,
                std::string_view start_dir) -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err},
-      bp::process_environment{env},
-      bp::process_start_dir(start_dir));
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             std::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts, {.env = env, .start_dir = std::string{start_dir}}).get();
   }
 
   auto which(std::string command) -> result {
-    constexpr auto which = std::string_view{"/usr/bin/which"};
-    auto res             = execute(which, {std::move(command)});
-    res.std_out          = trim(res.std_out);
-    return res;
+    auto is_executable = [](const std::filesystem::path &path) {
+      auto ec = std::error_code{};
+      return std::filesystem::is_regular_file(path, ec) && ::access(path.c_str(), X_OK) == 0;
+    };
+
+    // Like /usr/bin/which, a command containing slashes isn't searched.
+    if (command.contains('/')) {
+      if (is_executable(command)) {
+        return {.exit_code = 0, .std_out = std::move(command), .std_err = {}};
+      }
+      auto message = std::format("{} isn't executable", command);
+      return {.exit_code = 1, .std_out = {}, .std_err = std::move(message)};
+    }
+
+    const auto *path_env = std::getenv("PATH");
+    auto paths           = std::string_view{path_env == nullptr ? "" : path_env};
+    for (auto dir: paths | std::views::split(':')) {
+      // An empty directory in PATH means the current directory.
+      auto candidate = std::filesystem::path{std::string_view{dir.begin(), dir.end()}} / command;
+      if (is_executable(candidate)) {
+        return {.exit_code = 0, .std_out = candidate.string(), .std_err = {}};
+      }
+    }
+    return {.exit_code = 1, .std_out = {}, .std_err = std::format("no {} in PATH", command)};
   }
 
 } // namespace linter::shell
@@ -15,20 +15,120 @@
  */
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "utils/output_sink.h"
+
 namespace linter::shell {
   struct result {
     int exit_code;
     std::string std_out;
     std::string std_err;
+    /// The peak resident set size of the child process in bytes, 0 if it
+    /// couldn't be measured.
+    std::uint64_t peak_rss = 0;
+    /// Set if the child process was killed since it didn't exit in time. The
+    /// outputs read before that are kept.
+    bool timed_out = false;
+    /// Set if the child process was killed by runner::kill_all.
+    bool killed = false;
+  };
+
+  /// Thrown by tools whose child process timed out, so the checked files are
+  /// recorded as timed out rather than failed.
+  struct timeout_error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  /// Thrown by tools whose child process was killed by runner::kill_all, so
+  /// the checked files are recorded as skipped rather than failed.
+  struct killed_error : std::runtime_error {
+    using std::runtime_error::runtime_error;
   };
 
   using envrionment = std::unordered_map<std::string, std::string>;
   using options     = std::vector<std::string>;
 
+  /// Additional settings used to launch a child process. The child process
+  /// inherits the setting from cpp-linter if the corresponding field is empty.
+  struct execute_config {
+    envrionment env;
+    std::string start_dir;
+    /// Written to the stdin of the child process which is closed afterwards.
+    std::optional<std::string> std_in;
+    /// If set, the stdout of the child process is passed to it as it arrives
+    /// instead of kept in the result. Invoked on the runner thread, so it
+    /// mustn't block.
+    output_sink std_out_sink;
+    /// The same as std_out_sink but for stderr.
+    output_sink std_err_sink;
+    /// The child process and its descendants are killed if it doesn't exit in
+    /// the given time. 0 means only limited by the deadline of runner.
+    std::chrono::milliseconds timeout{0};
+  };
+
+  /// Called once the child process exited and both of its stdout and stderr
+  /// have been drained. The error is set if the child process couldn't be
+  /// launched or its outputs couldn't be read.
+  using callback = std::function<void(std::exception_ptr error, result res)>;
+
+  /// A process runner which drives all child processes on one shared
+  /// io_context. The stdout and stderr of a child process are drained
+  /// concurrently, so a child process never blocks on a full pipe, and any
+  /// number of child processes can be in flight at the same time.
+  class runner {
+  public:
+    static auto instance() -> runner &;
+
+    /// Launch a child process and return immediately. The callback is
+    /// invoked on the runner thread, so it mustn't block.
+    void async_execute(std::string_view command,
+                       const options &opts,
+                       const execute_config &config,
+                       callback cb);
+
+    /// Launch a child process and return a future of its result.
+    auto async_execute(std::string_view command, const options &opts, const execute_config &config)
+      -> std::future<result>;
+
+    /// Kill the child processes launched from now on if they're still running
+    /// at the given time. Those launched after it are killed at once.
+    void set_deadline(std::chrono::steady_clock::time_point deadline);
+
+    /// Kill the child processes running now, e.g. once fail fast stops the
+    /// check. Their callbacks are still invoked with the outputs read before.
+    void kill_all();
+
+    runner(const runner &)            = delete;
+    runner &operator=(const runner &) = delete;
+
+  private:
+    runner();
+    ~runner();
+
+    struct impl;
+    std::unique_ptr<impl> impl_;
+  };
+
+  void async_execute(std::string_view command,
+                     const options &opts,
+                     const execute_config &config,
+                     callback cb);
+  auto async_execute(std::string_view command,
+                     const options &opts,
+                     const execute_config &config = {}) -> std::future<result>;
+
   auto execute(std::string_view command, const options &opts) -> result;
   auto execute(std::string_view command, const options &opts, std::string_view start_dir) -> result;
   auto execute(std::string_view command, const options &opts, const envrionment &env) -> result;
@@ -37,5 +137,7 @@ namespace linter::shell {
                const envrionment &env,
                std::string_view start_dir) -> result;
 
+  /// Find the full path of a command by PATH like /usr/bin/which, but without
+  /// spawning a process. The exit code is 0 if found.
   auto which(std::string command) -> result;
 } // namespace linter::shell
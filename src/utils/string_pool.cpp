@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/string_pool.h"
+
+#include <algorithm>
+
+namespace linter {
+  namespace {
+    // Strings larger than a quarter of block get their own blocks, so not
+    // much space of a block is wasted.
+    constexpr auto block_size = std::size_t{64} * 1024;
+  } // namespace
+
+  auto string_pool::instance() -> string_pool & {
+    static auto pool = string_pool{};
+    return pool;
+  }
+
+  auto string_pool::intern(std::string_view str) -> std::string_view {
+    auto lock = std::lock_guard{mutex_};
+    if (auto iter = interned_.find(str); iter != interned_.end()) {
+      return *iter;
+    }
+    auto stored = store_unlocked(str);
+    interned_.insert(stored);
+    return stored;
+  }
+
+  auto string_pool::store(std::string_view str) -> std::string_view {
+    auto lock = std::lock_guard{mutex_};
+    return store_unlocked(str);
+  }
+
+  auto string_pool::size() const -> std::size_t {
+    auto lock = std::lock_guard{mutex_};
+    return size_;
+  }
+
+  void string_pool::clear() {
+    auto lock = std::lock_guard{mutex_};
+    interned_.clear();
+    blocks_.clear();
+    block_left_ = 0;
+    size_       = 0;
+  }
+
+  auto string_pool::store_unlocked(std::string_view str) -> std::string_view {
+    if (str.empty()) {
+      return {};
+    }
+    size_ += str.size();
+    if (str.size() > block_size / 4) {
+      // Insert before the current block, so the space left of it is kept.
+      auto block = std::make_unique<char[]>(str.size());
+      std::ranges::copy(str, block.get());
+      auto iter = blocks_.insert(blocks_.empty() ? blocks_.end() : blocks_.end() - 1,
+                                 std::move(block));
+      return {iter->get(), str.size()};
+    }
+    if (str.size() > block_left_) {
+      blocks_.push_back(std::make_unique<char[]>(block_size));
+      block_left_ = block_size;
+    }
+    auto *begin  = blocks_.back().get() + (block_size - block_left_);
+    block_left_ -= str.size();
+    std::ranges::copy(str, begin);
+    return {begin, str.size()};
+  }
+
+} // namespace linter
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace linter {
+  /// Storage of strings living until the program exits, so results could refer
+  /// to them by std::string_view rather than owning copies. Strings are packed
+  /// into large blocks to avoid one allocation per string. Repeated strings,
+  /// such as file names and check names, are interned to be stored once.
+  /// All member functions are thread safe.
+  class string_pool {
+  public:
+    string_pool() = default;
+
+    /// The pool shared by all results of one run.
+    static auto instance() -> string_pool &;
+
+    /// Store a string once no matter how many times it's interned.
+    auto intern(std::string_view str) -> std::string_view;
+
+    /// Store a string without looking up the stored ones. Used for strings
+    /// which are rarely repeated.
+    auto store(std::string_view str) -> std::string_view;
+
+    /// The number of bytes of all stored strings.
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /// Drop all stored strings. Views into the pool dangle afterwards, so it's
+    /// only called once nothing refers to the pool, e.g. between two checks.
+    void clear();
+
+    string_pool(const string_pool &)            = delete;
+    string_pool &operator=(const string_pool &) = delete;
+
+  private:
+    struct string_hash {
+      using is_transparent = void;
+
+      auto operator()(std::string_view str) const -> std::size_t {
+        return std::hash<std::string_view>{}(str);
+      }
+    };
+
+    auto store_unlocked(std::string_view str) -> std::string_view;
+
+    mutable std::mutex mutex_;
+    std::unordered_set<std::string_view, string_hash, std::equal_to<>> interned_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t block_left_ = 0;
+    std::size_t size_       = 0;
+  };
+
+} // namespace linter
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include <sys/resource.h>
+
+#include <nlohmann/json.hpp>
+
+#include "utils/util.h"
+
+namespace linter::trace {
+  namespace {
+    struct recorder {
+      std::atomic<bool> enabled{false};
+      std::chrono::steady_clock::time_point epoch;
+      std::mutex mutex;
+      std::vector<event> events;
+      std::map<std::string, std::int64_t> counters;
+    };
+
+    auto get_recorder() -> recorder & {
+      static auto instance = recorder{};
+      return instance;
+    }
+
+    auto to_ms(std::chrono::microseconds duration) -> double {
+      return static_cast<double>(duration.count()) / 1000.0;
+    }
+
+    auto to_ms(const timeval &time) -> double {
+      return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_usec) / 1000.0;
+    }
+
+    struct cpu_time {
+      double user_ms;
+      double system_ms;
+    };
+
+    auto get_cpu_time(int who) -> cpu_time {
+      auto usage = rusage{};
+      ::getrusage(who, &usage);
+      return {.user_ms = to_ms(usage.ru_utime), .system_ms = to_ms(usage.ru_stime)};
+    }
+  } // namespace
+
+  void enable() {
+    auto &rec = get_recorder();
+    rec.epoch = std::chrono::steady_clock::now();
+    rec.enabled.store(true);
+  }
+
+  auto enabled() -> bool {
+    return get_recorder().enabled.load(std::memory_order_relaxed);
+  }
+
+  auto now() -> std::chrono::microseconds {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()
+                                                                 - get_recorder().epoch);
+  }
+
+  auto current_thread_id() -> std::size_t {
+    static auto next     = std::atomic<std::size_t>{0};
+    thread_local auto id = next++;
+    return id;
+  }
+
+  void record(event evt) {
+    auto &rec = get_recorder();
+    if (!rec.enabled.load(std::memory_order_relaxed)) {
+      return;
+    }
+    auto lock = std::scoped_lock{rec.mutex};
+    rec.events.push_back(std::move(evt));
+  }
+
+  auto events() -> std::vector<event> {
+    auto &rec = get_recorder();
+    auto ret  = std::vector<event>{};
+    {
+      auto lock = std::scoped_lock{rec.mutex};
+      ret       = rec.events;
+    }
+    std::ranges::stable_sort(ret, {}, &event::start);
+    return ret;
+  }
+
+  void set_counter(const std::string &name, std::int64_t value) {
+    auto &rec = get_recorder();
+    if (!rec.enabled.load(std::memory_order_relaxed)) {
+      return;
+    }
+    auto lock          = std::scoped_lock{rec.mutex};
+    rec.counters[name] = value;
+  }
+
+  auto counters() -> std::vector<std::pair<std::string, std::int64_t>> {
+    auto &rec = get_recorder();
+    auto lock = std::scoped_lock{rec.mutex};
+    return {rec.counters.begin(), rec.counters.end()};
+  }
+
+  void write_chrome_trace(const std::string &path) {
+    auto trace_events = nlohmann::json::array();
+    for (const auto &evt: events()) {
+      auto item    = nlohmann::json{
+        {"name", evt.name},
+        {"cat", evt.category},
+        {"ph", "X"},
+        {"ts", evt.start.count()},
+        {"dur", evt.duration.count()},
+        {"pid", 1},
+        {"tid", evt.thread_id}
+      };
+      if (!evt.detail.empty()) {
+        item["args"]["detail"] = evt.detail;
+      }
+      for (const auto &[name, value]: evt.args) {
+        item["args"][name] = value;
+      }
+      trace_events.push_back(std::move(item));
+    }
+
+    auto self     = get_cpu_time(RUSAGE_SELF);
+    auto children = get_cpu_time(RUSAGE_CHILDREN);
+    auto trace    = nlohmann::json{
+      {"traceEvents", std::move(trace_events)},
+      {"displayTimeUnit", "ms"},
+      {"otherData",
+       {{"self_user_ms", self.user_ms},
+        {"self_system_ms", self.system_ms},
+        {"children_user_ms", children.user_ms},
+        {"children_system_ms", children.system_ms}}}
+    };
+    for (const auto &[name, value]: counters()) {
+      trace["otherData"][name] = value;
+    }
+
+    auto file = std::ofstream{path, std::ios::trunc};
+    throw_unless(file.is_open(), std::format("failed to open trace file {} to write", path));
+    file << trace.dump();
+  }
+
+  auto make_summary(std::size_t num_slowest) -> std::string {
+    auto all = events();
+
+    // Sorted by name so the table is stable between runs.
+    auto totals = std::map<std::string, std::pair<std::size_t, std::chrono::microseconds>>{};
+    for (const auto &evt: all) {
+      auto &[count, total]  = totals[evt.category];
+      count                += 1;
+      total                += evt.duration;
+    }
+
+    auto summary  = std::string{"## Timing\n\n"};
+    summary      += "| Category | Count | Total (ms) |\n";
+    summary      += "|----------|-------|------------|\n";
+    for (const auto &[category, value]: totals) {
+      summary += std::format("| {} | {} | {:.1f} |\n", category, value.first, to_ms(value.second));
+    }
+
+    std::ranges::stable_sort(all, std::ranges::greater{}, &event::duration);
+    all.resize(std::min(all.size(), num_slowest));
+    summary += "\n| Slowest | Category | Time (ms) |\n";
+    summary += "|---------|----------|-----------|\n";
+    for (const auto &evt: all) {
+      summary += std::format("| {} | {} | {:.1f} |\n", evt.name, evt.category, to_ms(evt.duration));
+    }
+
+    if (auto values = counters(); !values.empty()) {
+      summary += "\n| Counter | Value |\n";
+      summary += "|---------|-------|\n";
+      for (const auto &[name, value]: values) {
+        summary += std::format("| {} | {} |\n", name, value);
+      }
+    }
+
+    auto self      = get_cpu_time(RUSAGE_SELF);
+    auto children  = get_cpu_time(RUSAGE_CHILDREN);
+    summary       += std::format("\nCPU time (ms): cpp-linter user {:.1f} system {:.1f}, "
+                                 "child processes user {:.1f} system {:.1f}\n",
+                           self.user_ms,
+                           self.system_ms,
+                           children.user_ms,
+                           children.system_ms);
+    return summary;
+  }
+
+  scope::scope(std::string_view category, std::string name, std::string detail)
+    : enabled_(enabled()) {
+    if (!enabled_) {
+      return;
+    }
+    event_.category  = category;
+    event_.name      = std::move(name);
+    event_.detail    = std::move(detail);
+    event_.start     = now();
+    event_.thread_id = current_thread_id();
+  }
+
+  scope::~scope() {
+    if (!enabled_) {
+      return;
+    }
+    event_.duration = now() - event_.start;
+    record(std::move(event_));
+  }
+} // namespace linter::trace
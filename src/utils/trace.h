@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace linter::trace {
+  /// A finished phase, such as computing the diff, running a tool on a file or
+  /// sending a request to Github.
+  struct event {
+    std::string category;
+    std::string name;
+    /// Additional information shown in the trace viewer, e.g. a command line.
+    std::string detail;
+    /// Numbers shown with the detail, e.g. the CPU time of a child process.
+    std::vector<std::pair<std::string, double>> args;
+    /// Since tracing was enabled.
+    std::chrono::microseconds start{0};
+    std::chrono::microseconds duration{0};
+    std::size_t thread_id = 0;
+  };
+
+  /// Start recording events. Scopes are no-ops until then.
+  void enable();
+
+  [[nodiscard]] auto enabled() -> bool;
+
+  /// The time since tracing was enabled.
+  [[nodiscard]] auto now() -> std::chrono::microseconds;
+
+  /// A small id of the calling thread, which reads better than a hash of
+  /// std::thread::id in trace viewers.
+  [[nodiscard]] auto current_thread_id() -> std::size_t;
+
+  /// Record an event. It's safe to be called from multiple threads.
+  void record(event evt);
+
+  /// Return all recorded events ordered by start time.
+  [[nodiscard]] auto events() -> std::vector<event>;
+
+  /// Set a named value measured once per run, e.g. the bytes of objects
+  /// cached by libgit2. It's ignored if tracing isn't enabled.
+  void set_counter(const std::string &name, std::int64_t value);
+
+  /// Return all counters ordered by name.
+  [[nodiscard]] auto counters() -> std::vector<std::pair<std::string, std::int64_t>>;
+
+  /// Write recorded events as Chrome trace-event JSON, which could be opened
+  /// by chrome://tracing or https://ui.perfetto.dev. The CPU time of
+  /// cpp-linter and all its child processes read from rusage and counters are
+  /// written as metadata.
+  void write_chrome_trace(const std::string &path);
+
+  /// Make a markdown summary of the total time of each category, the slowest
+  /// events, counters and the CPU time from rusage.
+  [[nodiscard]] auto make_summary(std::size_t num_slowest = 10) -> std::string;
+
+  /// Record the lifetime of itself as an event if tracing is enabled.
+  class scope {
+  public:
+    scope(std::string_view category, std::string name, std::string detail = {});
+    ~scope();
+
+    scope(const scope &)            = delete;
+    scope &operator=(const scope &) = delete;
+
+  private:
+    bool enabled_;
+    event event_;
+  };
+} // namespace linter::trace
@@ -18,9 +18,10 @@
 #include <concepts>
 #include <ranges>
 #include <stdexcept>
+#include <string>
 #include <string_view>
-
-#include <boost/regex.hpp>
+#include <utility>
+#include <vector>
 
 namespace linter {
   constexpr auto trim_left(std::string_view str) -> std::string_view {
@@ -85,11 +86,6 @@ namespace linter {
     }
   }
 
-  inline bool filter_file(const std::string &iregex, const std::string &file) {
-    auto regex = boost::regex{iregex, boost::regex::icase};
-    return !boost::regex_match(file, regex);
-  }
-
   inline auto concat(const std::vector<std::string> &strs, char delim = '\n') -> std::string {
     return strs | std::views::join_with(delim) | std::ranges::to<std::string>();
   }
@@ -0,0 +1,244 @@
+// An end-to-end benchmark of cpp-linter. It generates a repository with the
+// given number of commits and changed files, then runs cpp-linter on it in
+// local mode with stub clang tools of the given latency. Real clang tools are
+// much slower and vary too much, so the stubs make the time spent by
+// cpp-linter itself, e.g. scheduling and caching, visible.
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "utils/git_utils.h"
+
+using namespace linter; // NOLINT
+
+extern char **environ; // NOLINT
+
+namespace {
+  namespace fs = std::filesystem;
+
+  struct bench_config {
+    std::size_t num_commits = 2;
+    std::size_t num_files   = 1000;
+    std::size_t file_lines  = 200;
+    std::size_t latency_ms  = 5;
+    std::size_t num_runs    = 1;
+    std::vector<std::string> extra_args;
+  };
+
+  void WriteFile(const fs::path &path, const std::string &content) {
+    fs::create_directories(path.parent_path());
+    auto file = std::ofstream{path, std::ios::trunc};
+    file << content;
+  }
+
+  // The stubs answer --version and print what cpp-linter parses as "no
+  // problems", i.e. an empty replacements document for each file.
+  void WriteStubs(const fs::path &dir, std::size_t latency_ms) {
+    auto latency = std::format("{}.{:03}", latency_ms / 1000, latency_ms % 1000);
+    WriteFile(dir / "clang-format",
+              std::format("#!/bin/sh\n"
+                          "[ \"$1\" = --version ] && echo 'clang-format version 18.1.3' && exit 0\n"
+                          "sleep {}\n"
+                          "for arg in \"$@\"; do\n"
+                          "  case \"$arg\" in --assume-filename=*|[!-]*)\n"
+                          "    echo \"<?xml version='1.0'?>\"\n"
+                          "    echo \"<replacements xml:space='preserve'></replacements>\";;\n"
+                          "  esac\n"
+                          "done\n",
+                          latency));
+    WriteFile(dir / "clang-tidy",
+              std::format("#!/bin/sh\n"
+                          "[ \"$1\" = --version ] && echo 'LLVM version 18.1.3' && exit 0\n"
+                          "sleep {}\n",
+                          latency));
+    for (const auto *name: {"clang-format", "clang-tidy"}) {
+      fs::permissions(dir / name, fs::perms::owner_all, fs::perm_options::add);
+    }
+  }
+
+  auto MakeSource(std::size_t file_idx, std::size_t lines, std::size_t commit_idx) -> std::string {
+    auto source = std::format("// file {} of commit {}\n", file_idx, commit_idx);
+    for (auto idx = std::size_t{0}; idx < lines; ++idx) {
+      source += std::format("auto value{} = compute({}, {});\n", idx, idx, file_idx);
+    }
+    return source;
+  }
+
+  // Return the ids of the first and the last commit. Every commit changes all
+  // files, so all of them are changed between the two.
+  auto MakeRepo(const fs::path &dir, const bench_config &config)
+    -> std::pair<std::string, std::string> {
+    auto repo   = git::repo::init(dir.string(), false);
+    auto origin = git::repo::config(repo.get());
+    git::config::set_string(origin.get(), "user.name", "cpp-linter");
+    git::config::set_string(origin.get(), "user.email", "cpp-linter@email.com");
+
+    auto files = std::vector<std::string>{};
+    for (auto idx = std::size_t{0}; idx < config.num_files; ++idx) {
+      files.push_back(std::format("src/dir{}/file{}.cpp", idx % 32, idx));
+    }
+
+    auto ids = std::vector<std::string>{};
+    for (auto commit_idx = std::size_t{0}; commit_idx < config.num_commits; ++commit_idx) {
+      for (auto idx = std::size_t{0}; idx < files.size(); ++idx) {
+        WriteFile(dir / files[idx], MakeSource(idx, config.file_lines, commit_idx));
+      }
+      auto [index_oid, index] = git::index::add_files(repo.get(), files);
+      auto [commit_oid, commit] =
+        git::commit::create_head(repo.get(), std::format("Commit {}", commit_idx), index.get());
+      ids.push_back(git::commit::id_str(commit.get()));
+    }
+    return {ids.front(), ids.back()};
+  }
+
+  struct run_result {
+    int exit_code = 0;
+    double wall_ms = 0;
+    long peak_rss_kb = 0;
+  };
+
+  auto Run(const std::vector<std::string> &args, const fs::path &stub_dir) -> run_result {
+    auto argv = std::vector<char *>{};
+    for (const auto &arg: args) {
+      argv.push_back(const_cast<char *>(arg.c_str())); // NOLINT
+    }
+    argv.push_back(nullptr);
+
+    // Stubs are found by PATH. cpp-linter runs in local mode only if it
+    // isn't on Github Actions.
+    auto env_strs = std::vector<std::string>{
+      std::format("PATH={}:{}", stub_dir.string(), std::getenv("PATH")),
+      std::format("HOME={}", fs::temp_directory_path().string())};
+    auto envp = std::vector<char *>{};
+    for (auto &str: env_strs) {
+      envp.push_back(str.data());
+    }
+    envp.push_back(nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    auto pid   = pid_t{};
+    if (::posix_spawn(&pid, argv[0], nullptr, nullptr, argv.data(), envp.data()) != 0) {
+      throw std::runtime_error{std::format("failed to spawn {}", args[0])};
+    }
+    auto status = 0;
+    auto usage  = rusage{};
+    ::wait4(pid, &status, 0, &usage);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return {.exit_code   = WIFEXITED(status) ? WEXITSTATUS(status) : -1,
+            .wall_ms     = std::chrono::duration<double, std::milli>(elapsed).count(),
+            .peak_rss_kb = usage.ru_maxrss};
+  }
+
+  // The total time of each category of trace events. Events of tasks run
+  // concurrently, so their total may exceed the wall time.
+  auto SummarizeTrace(const fs::path &path) -> std::map<std::string, double> {
+    auto file  = std::ifstream{path};
+    auto trace = nlohmann::json::parse(file, nullptr, false);
+    auto ret   = std::map<std::string, double>{};
+    if (trace.is_discarded()) {
+      return ret;
+    }
+    for (const auto &evt: trace["traceEvents"]) {
+      ret[evt["cat"].get<std::string>()] += evt["dur"].get<double>() / 1000.0;
+    }
+    return ret;
+  }
+
+  auto ParseConfig(int argc, char **argv) -> std::optional<bench_config> {
+    namespace po = boost::program_options;
+    auto config  = bench_config{};
+    auto desc    = po::options_description{"cpp-linter end-to-end benchmark options"};
+    // clang-format off
+    desc.add_options()
+      ("help",                                                   "Produce help message")
+      ("commits",    po::value(&config.num_commits),             "The number of commits, at least 2")
+      ("files",      po::value(&config.num_files),               "The number of changed files")
+      ("file-lines", po::value(&config.file_lines),              "The number of lines of each file")
+      ("latency-ms", po::value(&config.latency_ms),              "The latency of each stub tool invocation")
+      ("runs",       po::value(&config.num_runs),                "The number of runs on the same repository. "
+                                                                 "Runs after the first reuse the result cache")
+      ("args",       po::value(&config.extra_args)->multitoken(), "Additional cpp-linter options, e.g. "
+                                                                 "--args=--clang-tidy-batch-size=8")
+    ;
+    // clang-format on
+    auto variables = po::variables_map{};
+    po::store(po::parse_command_line(argc, argv, desc), variables);
+    po::notify(variables);
+    if (variables.contains("help") || config.num_commits < 2) {
+      std::cout << desc << "\n";
+      return std::nullopt;
+    }
+    return config;
+  }
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  auto config = ParseConfig(argc, argv);
+  if (!config) {
+    return 0;
+  }
+
+  const auto work_dir = fs::temp_directory_path() / "cpp-linter-bench-e2e";
+  fs::remove_all(work_dir);
+  const auto repo_dir  = work_dir / "repo";
+  const auto stub_dir  = work_dir / "stubs";
+  const auto cache_dir = work_dir / "cache";
+  WriteStubs(stub_dir, config->latency_ms);
+
+  git::setup();
+  auto setup_start      = std::chrono::steady_clock::now();
+  auto [target, source] = MakeRepo(repo_dir, *config);
+  std::println("Generated {} commits of {} files in {:.0f} ms",
+               config->num_commits,
+               config->num_files,
+               std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()
+                                                         - setup_start)
+                 .count());
+  git::shutdown();
+
+  for (auto run = std::size_t{0}; run < config->num_runs; ++run) {
+    const auto trace_file = work_dir / std::format("trace-{}.json", run);
+    auto args             = std::vector<std::string>{CPP_LINTER_BINARY,
+                                                     "--log-level=error",
+                                                     "--repo-path=" + repo_dir.string(),
+                                                     "--target=" + target,
+                                                     "--source=" + source,
+                                                     "--event-name=push",
+                                                     "--cache-dir=" + cache_dir.string(),
+                                                     "--trace-file=" + trace_file.string(),
+                                                     "--enable-clang-format=true",
+                                                     "--enable-clang-tidy=true"};
+    args.insert(args.end(), config->extra_args.begin(), config->extra_args.end());
+
+    auto result = Run(args, stub_dir);
+    std::println("Run {}: exit code {}, {:.0f} ms, {:.1f} files/s, peak RSS {} KiB",
+                 run,
+                 result.exit_code,
+                 result.wall_ms,
+                 static_cast<double>(config->num_files) * 1000.0 / result.wall_ms,
+                 result.peak_rss_kb);
+    for (const auto &[category, total_ms]: SummarizeTrace(trace_file)) {
+      std::println("  {:<10} {:>10.1f} ms", category, total_ms);
+    }
+  }
+  fs::remove_all(work_dir);
+  return 0;
+}
@@ -0,0 +1,207 @@
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "github/review_comment.h"
+#include "tools/clang_format/general/replacements.h"
+#include "tools/clang_tidy/general/parser.h"
+#include "utils/git_utils.h"
+#include "utils/hunk_index.h"
+#include "utils/line_index.h"
+
+using namespace linter; // NOLINT
+
+namespace {
+  // The sizes of synthetic corpora, close to the largest outputs seen on CI:
+  // a clang-tidy log of about 50 MB and a formatter upgrade of a big file.
+  constexpr auto num_diagnostics  = std::size_t{300000};
+  constexpr auto num_replacements = std::size_t{10000};
+  constexpr auto num_lines        = std::size_t{100000};
+  constexpr auto num_comments     = std::size_t{10000};
+
+  auto MakeHeader(std::size_t idx) -> std::string {
+    return std::format("/home/runner/work/repo/src/file{}.cpp:{}:{}: warning: variable 'n' "
+                       "is not initialized [cppcoreguidelines-init-variables]",
+                       idx % 64,
+                       idx + 1,
+                       idx % 80 + 1);
+  }
+
+  auto MakeStdout(std::size_t num) -> std::string {
+    auto out = std::string{};
+    for (auto idx = std::size_t{0}; idx < num; ++idx) {
+      out += MakeHeader(idx) + "\n";
+      out += "  int n;\n";
+      out += "      ^\n";
+      out += "        = 0\n";
+    }
+    return out;
+  }
+
+  auto MakeStderr(std::size_t num) -> std::string {
+    auto err = std::string{};
+    for (auto idx = std::size_t{0}; idx < num; ++idx) {
+      err += "Error while processing /home/runner/work/repo/src/file.cpp.\n";
+    }
+    err += std::format("{} warnings and 2 errors generated.\n", num);
+    err += "Suppressed 12 warnings (10 in non-user code, 2 NOLINT).\n";
+    return err;
+  }
+
+  auto MakeReplacementsXml(std::size_t num) -> std::string {
+    auto xml = std::string{"<?xml version='1.0'?>\n<replacements xml:space='preserve' "
+                           "incomplete_format='false'>\n"};
+    for (auto idx = std::size_t{0}; idx < num; ++idx) {
+      xml += std::format("<replacement offset='{}' length='{}'>&#10;  </replacement>\n",
+                         idx * 40,
+                         idx % 3);
+    }
+    return xml + "</replacements>\n";
+  }
+
+  auto MakeSource(std::size_t num, std::size_t changed_every) -> std::string {
+    auto source = std::string{};
+    for (auto idx = std::size_t{0}; idx < num; ++idx) {
+      auto changed = changed_every != 0 && idx % changed_every == 0;
+      source      += std::format("  auto value{} = compute({});{}\n", idx, idx, changed ? " " : "");
+    }
+    return source;
+  }
+
+  // Recorded corpora are read from the directory given by the environment
+  // variable CPP_LINTER_BENCH_CORPUS. Files are picked by extension: clang-tidy
+  // stdout and stderr end with .stdout and .stderr, replacements xml of
+  // clang-format ends with .xml.
+  auto ReadCorpus(std::string_view extension) -> std::vector<std::pair<std::string, std::string>> {
+    auto corpus     = std::vector<std::pair<std::string, std::string>>{};
+    const auto *dir = std::getenv("CPP_LINTER_BENCH_CORPUS");
+    if (dir == nullptr) {
+      return corpus;
+    }
+    for (const auto &entry: std::filesystem::directory_iterator{dir}) {
+      if (entry.path().extension() != extension) {
+        continue;
+      }
+      auto file    = std::ifstream{entry.path(), std::ios::binary};
+      auto content = std::string{std::istreambuf_iterator<char>{file}, {}};
+      corpus.emplace_back(entry.path().filename().string(), std::move(content));
+    }
+    return corpus;
+  }
+} // namespace
+
+TEST_CASE("Benchmark clang-tidy parsers", "[clang-tidy][!benchmark]") {
+  auto headers = std::vector<std::string>{};
+  for (auto idx = std::size_t{0}; idx < num_comments; ++idx) {
+    headers.push_back(MakeHeader(idx));
+  }
+  const auto std_out = MakeStdout(num_diagnostics);
+  const auto std_err = MakeStderr(num_diagnostics);
+
+  BENCHMARK("parse_diagnostic_header") {
+    auto parsed = std::size_t{0};
+    for (const auto &header: headers) {
+      parsed += tool::clang_tidy::parse_diagnostic_header(header).has_value() ? 1 : 0;
+    }
+    return parsed;
+  };
+
+  BENCHMARK("parse_stdout") {
+    return tool::clang_tidy::parse_stdout(std_out);
+  };
+
+  BENCHMARK("parse_stderr") {
+    return tool::clang_tidy::parse_stderr(std_err);
+  };
+}
+
+TEST_CASE("Benchmark clang-format parsers", "[clang-format][!benchmark]") {
+  const auto xml    = MakeReplacementsXml(num_replacements);
+  const auto source = MakeSource(num_lines, 0);
+
+  BENCHMARK("parse_replacements_xml") {
+    return tool::clang_format::parse_replacements_xml(xml);
+  };
+
+  BENCHMARK("line_index") {
+    return line_index{source};
+  };
+
+  const auto lines = line_index{source};
+  BENCHMARK("line_index::position") {
+    auto rows = std::size_t{0};
+    for (auto offset = std::size_t{0}; offset < source.size(); offset += 40) {
+      rows += lines.position(offset)->first;
+    }
+    return rows;
+  };
+}
+
+TEST_CASE("Benchmark review comments", "[git2][!benchmark]") {
+  git::setup();
+  const auto before = MakeSource(num_lines, 0);
+  const auto after  = MakeSource(num_lines, 10);
+  auto opts         = git::diff::init_option();
+  auto patch        = git::patch::create_from_buffers(before, "file.cpp", after, "file.cpp", opts);
+
+  BENCHMARK("hunk_index") {
+    return git::hunk_index{patch.get()};
+  };
+
+  const auto hunks = git::hunk_index{patch.get()};
+  BENCHMARK("hunk_index::position") {
+    auto mapped = std::size_t{0};
+    for (auto row = std::size_t{1}; row <= num_lines; ++row) {
+      mapped += hunks.position(row).has_value() ? 1 : 0;
+    }
+    return mapped;
+  };
+
+  auto comments = github::review_comments{};
+  for (auto idx = std::size_t{0}; idx < num_comments; ++idx) {
+    comments.push_back({.path     = std::format("src/file{}.cpp", idx % 64),
+                        .position = idx,
+                        .body     = "```suggestion\n  auto value = compute();\n```"});
+  }
+  BENCHMARK("make_review_str") {
+    return github::make_review_str(comments);
+  };
+  BENCHMARK("make_review_strs") {
+    return github::make_review_strs(comments);
+  };
+  git::shutdown();
+}
+
+TEST_CASE("Benchmark recorded corpora", "[corpus][!benchmark]") {
+  auto std_outs = ReadCorpus(".stdout");
+  auto std_errs = ReadCorpus(".stderr");
+  auto xmls     = ReadCorpus(".xml");
+  if (std_outs.empty() && std_errs.empty() && xmls.empty()) {
+    SKIP("CPP_LINTER_BENCH_CORPUS isn't set or has no corpus");
+  }
+
+  for (const auto &[name, content]: std_outs) {
+    BENCHMARK(std::format("parse_stdout {}", name)) {
+      return tool::clang_tidy::parse_stdout(content);
+    };
+  }
+  for (const auto &[name, content]: std_errs) {
+    BENCHMARK(std::format("parse_stderr {}", name)) {
+      return tool::clang_tidy::parse_stderr(content);
+    };
+  }
+  for (const auto &[name, content]: xmls) {
+    BENCHMARK(std::format("parse_replacements_xml {}", name)) {
+      return tool::clang_format::parse_replacements_xml(content);
+    };
+  }
+}
@@ -0,0 +1,120 @@
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "tools/clang_format/general/replacements.h"
+
+using namespace linter::tool::clang_format; // NOLINT
+
+TEST_CASE("Parse replacements written by clang-format", "[clang-format][replacements]") {
+  auto xml = std::string{"<?xml version='1.0'?>\n"
+                         "<replacements xml:space='preserve' incomplete_format='false'>\n"
+                         "<replacement offset='12' length='1'>&#10;  </replacement>\n"
+                         "<replacement offset='40' length='3'>a &lt; b &amp;&amp; c</replacement>\n"
+                         "<replacement offset='50' length='2'></replacement>\n"
+                         "</replacements>\n"};
+  auto replacements = parse_replacements_xml(xml);
+  REQUIRE(replacements.size() == 3);
+  REQUIRE(replacements[0].offset == 12);
+  REQUIRE(replacements[0].length == 1);
+  REQUIRE(replacements[0].data == "\n  ");
+  REQUIRE(replacements[1].offset == 40);
+  REQUIRE(replacements[1].length == 3);
+  REQUIRE(replacements[1].data == "a < b && c");
+  REQUIRE(replacements[2].offset == 50);
+  REQUIRE(replacements[2].data.empty());
+}
+
+TEST_CASE("Parse replacements of a well formatted file", "[clang-format][replacements]") {
+  REQUIRE(parse_replacements_xml("<?xml version='1.0'?>\n"
+                                 "<replacements xml:space='preserve' incomplete_format='false'>\n"
+                                 "</replacements>\n")
+            .empty());
+  REQUIRE(parse_replacements_xml("<replacements/>").empty());
+}
+
+TEST_CASE("Parse one of several replacements documents", "[clang-format][replacements]") {
+  auto output = std::string{"<?xml version='1.0'?>\n"
+                            "<replacements xml:space='preserve' incomplete_format='false'>\n"
+                            "<replacement offset='1' length='0'>&#x20;</replacement>\n"
+                            "</replacements>\n"
+                            "<?xml version='1.0'?>\n"};
+  auto first        = std::string_view{output}.substr(0, output.rfind("<?xml"));
+  auto replacements = parse_replacements_xml(first);
+  REQUIRE(replacements.size() == 1);
+  REQUIRE(replacements[0].data == " ");
+}
+
+TEST_CASE("Parse replacements xml written in another way", "[clang-format][replacements]") {
+  auto replacements = parse_replacements_xml(
+    "<replacements>\n"
+    "  <!-- not written by clang-format -->\n"
+    "  <replacement length=\"2\" offset=\"7\">x</replacement>\n"
+    "</replacements>\n");
+  REQUIRE(replacements.size() == 1);
+  REQUIRE(replacements[0].offset == 7);
+  REQUIRE(replacements[0].length == 2);
+  REQUIRE(replacements[0].data == "x");
+}
+
+TEST_CASE("Parse malformed replacements xml", "[clang-format][replacements]") {
+  REQUIRE_THROWS(parse_replacements_xml(""));
+  REQUIRE_THROWS(parse_replacements_xml("<replacements><replacement offset='1'>"));
+  REQUIRE_THROWS(parse_replacements_xml("<other></other>"));
+}
+
+TEST_CASE("Apply replacements to a part of source code", "[clang-format][replacements]") {
+  auto source       = std::string{"int  a;\nint b ;\n"};
+  auto replacements = replacements_t{{.offset = 3, .length = 2, .data = " "},
+                                     {.offset = 13, .length = 1, .data = ""}};
+  REQUIRE(apply_replacements(source, replacements) == "int a;\nint b;\n");
+  REQUIRE(apply_replacements(std::string_view{source}.substr(8), {&replacements[1], 1}, 8)
+          == "int b;\n");
+  REQUIRE_THROWS(apply_replacements(std::string_view{source}.substr(8), replacements, 8));
+}
+
+TEST_CASE("Make suggestions of whole lines from replacements", "[clang-format][replacements]") {
+  auto source = std::string{"int  a;\nint b ;\nint c;\n\n\nint d;"};
+
+  SECTION("Replacements of different lines") {
+    auto suggestions = make_suggestions(source,
+                                        {{.offset = 3, .length = 2, .data = " "},
+                                         {.offset = 13, .length = 1, .data = ""}});
+    REQUIRE(suggestions.size() == 2);
+    REQUIRE(suggestions[0].first_row == 1);
+    REQUIRE(suggestions[0].last_row == 1);
+    REQUIRE(suggestions[0].text == "int a;\n");
+    REQUIRE(suggestions[1].first_row == 2);
+    REQUIRE(suggestions[1].last_row == 2);
+    REQUIRE(suggestions[1].text == "int b;\n");
+  }
+
+  SECTION("Replacements of the same line are merged") {
+    auto suggestions = make_suggestions(source,
+                                        {{.offset = 11, .length = 1, .data = "  "},
+                                         {.offset = 13, .length = 1, .data = ""}});
+    REQUIRE(suggestions.size() == 1);
+    REQUIRE(suggestions[0].first_row == 2);
+    REQUIRE(suggestions[0].text == "int  b;\n");
+  }
+
+  SECTION("Replacement removing a new line") {
+    // Remove one of the empty lines 4 and 5, line 6 isn't changed.
+    auto suggestions = make_suggestions(source, {{.offset = 22, .length = 3, .data = "\n\n"}});
+    REQUIRE(suggestions.size() == 1);
+    REQUIRE(suggestions[0].first_row == 3);
+    REQUIRE(suggestions[0].last_row == 5);
+    REQUIRE(suggestions[0].text == "int c;\n\n");
+  }
+
+  SECTION("Insertion at the end of file") {
+    auto suggestions = make_suggestions(source, {{.offset = 31, .length = 0, .data = "\n"}});
+    REQUIRE(suggestions.size() == 1);
+    REQUIRE(suggestions[0].first_row == 6);
+    REQUIRE(suggestions[0].text == "int d;\n");
+  }
+
+  SECTION("Replacement out of source code") {
+    REQUIRE_THROWS(make_suggestions(source, {{.offset = 32, .length = 0, .data = ""}}));
+  }
+}
@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tools/clang_tidy/general/baseline.h"
+#include "tools/clang_tidy/general/parser.h"
+
+using namespace linter::tool::clang_tidy; // NOLINT
+
+TEST_CASE("Remove diagnostics existing in baseline", "[clang-tidy][baseline]") {
+  auto baseline = parse_stdout("/src/a.cpp:3:7: warning: variable 'n' is not initialized [init]\n"
+                               "  int n;\n"
+                               "      ^\n"
+                               "/src/a.cpp:9:7: warning: variable 'm' is not initialized [init]\n"
+                               "  int m;\n"
+                               "      ^\n");
+
+  // One line is inserted at the top, and a new diagnostic is introduced.
+  auto diags = parse_stdout("/src/a.cpp:4:7: warning: variable 'n' is not initialized [init]\n"
+                            "  int n;\n"
+                            "      ^\n"
+                            "/src/a.cpp:6:7: warning: variable 'k' is not initialized [init]\n"
+                            "  int k;\n"
+                            "      ^\n"
+                            "/src/a.cpp:10:7: warning: variable 'm' is not initialized [init]\n"
+                            "    int m;\n"
+                            "        ^\n");
+
+  auto remained = remove_baseline(diags, baseline);
+  REQUIRE(remained.size() == 1);
+  REQUIRE(remained[0].header.row_idx == 6);
+
+  // Each diagnostic of baseline matches only once.
+  auto duplicated = diags;
+  duplicated.push_back(diags[0]);
+  remained = remove_baseline(duplicated, baseline);
+  REQUIRE(remained.size() == 2);
+  REQUIRE(remained[1].header.row_idx == 4);
+
+  REQUIRE(remove_baseline(diags, {}).size() == 3);
+}
+
+TEST_CASE("Match diagnostics without source lines by rows", "[clang-tidy][baseline]") {
+  // Diagnostics read from exported fixes have no details.
+  auto make_diag = [](std::uint32_t row, std::string_view brief) {
+    auto diag                   = diagnostic{};
+    diag.header.row_idx         = row;
+    diag.header.brief           = brief;
+    diag.header.diagnostic_type = "[init]";
+    return diag;
+  };
+  auto baseline = diagnostics{make_diag(3, " n "), make_diag(40, " n ")};
+
+  // Ten lines are inserted at the top.
+  auto diags    = diagnostics{make_diag(13, " n "), make_diag(30, " n "), make_diag(50, " n ")};
+  auto remained = remove_baseline(diags, baseline, [](std::size_t row) { return row - 10; });
+  REQUIRE(remained.size() == 1);
+  REQUIRE(remained[0].header.row_idx == 30);
+
+  // Without the mapper, only rows nearby are matched.
+  remained = remove_baseline(diags, baseline);
+  REQUIRE(remained.size() == 3);
+}
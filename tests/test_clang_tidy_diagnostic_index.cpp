@@ -0,0 +1,63 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tools/clang_tidy/general/diagnostic_index.h"
+#include "tools/clang_tidy/general/parser.h"
+
+using namespace linter::tool::clang_tidy; // NOLINT
+
+TEST_CASE("Drop header diagnostics reported by former translation units",
+          "[clang-tidy][diagnostic_index]") {
+  auto index = diagnostic_index{};
+  auto first = parse_stdout("/src/a.h:3:7: warning: variable 'n' is not initialized [init]\n"
+                            "  int n;\n"
+                            "      ^\n"
+                            "/src/a.cpp:9:7: warning: variable 'm' is not initialized [init]\n"
+                            "  int m;\n"
+                            "      ^\n");
+  REQUIRE(index.drop_reported(first) == 0);
+  REQUIRE(first.size() == 2);
+
+  // The header diagnostic is reported again by another translation unit, and
+  // another check reports the same location.
+  auto second = parse_stdout("/src/a.h:3:7: warning: variable 'n' is not initialized [init]\n"
+                             "  int n;\n"
+                             "      ^\n"
+                             "/src/a.h:3:7: warning: 'n' is never used [unused]\n"
+                             "  int n;\n"
+                             "      ^\n"
+                             "/src/b.cpp:9:7: warning: variable 'm' is not initialized [init]\n"
+                             "  int m;\n"
+                             "      ^\n");
+  REQUIRE(index.drop_reported(second) == 1);
+  REQUIRE(second.size() == 2);
+  REQUIRE(second[0].header.diagnostic_type == "[unused]");
+  REQUIRE(second[1].header.file_name == "/src/b.cpp");
+  REQUIRE(index.size() == 4);
+}
+
+TEST_CASE("Give dropped diagnostics back to files kept by fastly exit",
+          "[clang-tidy][diagnostic_index]") {
+  auto header = "/src/a.h:3:7: warning: variable 'n' is not initialized [init]\n"
+                "  int n;\n"
+                "      ^\n";
+  auto results = std::vector<std::optional<per_file_result>>(2);
+  auto dropped = std::vector<diagnostics>(2);
+
+  // The second file finishes first and keeps the header diagnostic, then the
+  // first file fails, after which fastly exit drops the second one.
+  auto index = diagnostic_index{};
+  results[1].emplace();
+  results[1]->diags = parse_stdout(header);
+  REQUIRE(index.drop_reported(results[1]->diags, &dropped[1]) == 0);
+  results[0].emplace();
+  results[0]->diags = parse_stdout(header);
+  REQUIRE(index.drop_reported(results[0]->diags, &dropped[0]) == 1);
+  REQUIRE(results[0]->diags.empty());
+  REQUIRE(dropped[0].size() == 1);
+
+  auto kept = deduplicate_kept(results, dropped, 0);
+  REQUIRE(results[0]->diags.size() == 1);
+  REQUIRE(results[0]->diags[0].header.file_name == "/src/a.h");
+  REQUIRE(dropped[0].empty());
+  REQUIRE(kept.size() == 1);
+}
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "tools/clang_tidy/general/parser.h"
+#include "utils/string_pool.h"
+
+using namespace linter::tool::clang_tidy; // NOLINT
+
+namespace {
+  constexpr auto num_diagnostics = std::size_t{20000};
+
+  auto MakeStdout(std::size_t num) -> std::string {
+    auto out = std::string{};
+    for (auto idx = std::size_t{0}; idx < num; ++idx) {
+      out += std::format("/home/runner/work/repo/src/file{}.cpp:{}:{}: warning: variable 'n' "
+                         "is not initialized [cppcoreguidelines-init-variables]\n",
+                         idx % 64,
+                         idx + 1,
+                         idx % 80 + 1);
+      out += "  int n;\n";
+      out += "      ^\n";
+      out += "        = 0\n";
+    }
+    return out;
+  }
+
+  auto MakeStderr(std::size_t num) -> std::string {
+    auto err = std::string{};
+    for (auto idx = std::size_t{0}; idx < num; ++idx) {
+      err += "Error while processing /home/runner/work/repo/src/file.cpp.\n";
+    }
+    err += std::format("{} warnings and 2 errors generated.\n", num);
+    err += "Suppressed 12 warnings (10 in non-user code, 2 NOLINT).\n";
+    err += "3 warnings treated as errors\n";
+    return err;
+  }
+
+  // The diagnostic which owned all of its strings, kept to compare with.
+  struct owning_diagnostic {
+    std::string file_name;
+    std::string row_idx;
+    std::string col_idx;
+    std::string serverity;
+    std::string brief;
+    std::string diagnostic_type;
+    std::string details;
+  };
+
+  // The parser of the former layout, which copied each field of a header
+  // and appended each line of details to its diagnostic.
+  auto parse_owning_header(std::string_view line) -> std::optional<owning_diagnostic> {
+    auto parts = std::array<std::string_view, 5>{};
+    for (auto idx = std::size_t{0}; idx < parts.size() - 1; ++idx) {
+      auto colon = line.find(':');
+      if (colon == std::string_view::npos) {
+        return std::nullopt;
+      }
+      parts[idx] = line.substr(0, colon);
+      line.remove_prefix(colon + 1);
+    }
+    if (line.find(':') != std::string_view::npos) {
+      return std::nullopt;
+    }
+    parts.back() = line;
+
+    auto [file_name, row_idx, col_idx, serverity, diagnostic_type] = parts;
+    serverity.remove_prefix(std::min(serverity.find_first_not_of(' '), serverity.size()));
+    auto is_digits = [](std::string_view str) {
+      return !str.empty() && std::ranges::all_of(str, [](char c) { return std::isdigit(c) != 0; });
+    };
+    if (!is_digits(row_idx) || !is_digits(col_idx)) {
+      return std::nullopt;
+    }
+    if (serverity != "warning" && serverity != "info" && serverity != "error") {
+      return std::nullopt;
+    }
+    auto square_brackets = diagnostic_type.find('[');
+    if (square_brackets == std::string_view::npos
+        || diagnostic_type.size() < 3
+        || diagnostic_type.back() != ']') {
+      return std::nullopt;
+    }
+    auto brief = diagnostic_type.substr(0, square_brackets);
+    auto type  = diagnostic_type.substr(square_brackets);
+    return owning_diagnostic{.file_name       = std::string{file_name},
+                             .row_idx         = std::string{row_idx},
+                             .col_idx         = std::string{col_idx},
+                             .serverity       = std::string{serverity},
+                             .brief           = std::string{brief},
+                             .diagnostic_type = std::string{type},
+                             .details         = {}};
+  }
+
+  auto parse_owning_stdout(std::string_view std_out) -> std::vector<owning_diagnostic> {
+    auto ret = std::vector<owning_diagnostic>{};
+    while (!std_out.empty()) {
+      auto end  = std::min(std_out.find('\n'), std_out.size());
+      auto line = std_out.substr(0, end);
+      if (auto header = parse_owning_header(line)) {
+        ret.push_back(std::move(*header));
+      } else if (!ret.empty()) {
+        ret.back().details.append(line).push_back('\n');
+      }
+      std_out.remove_prefix(std::min(end + 1, std_out.size()));
+    }
+    return ret;
+  }
+
+  // The bytes allocated on heap by a string, zero if it's a small string.
+  auto heap_size(const std::string &str) -> std::size_t {
+    return str.capacity() > std::string{}.capacity() ? str.capacity() + 1 : 0;
+  }
+
+  auto footprint(const std::vector<owning_diagnostic> &diags) -> std::size_t {
+    auto ret = diags.size() * sizeof(owning_diagnostic);
+    for (const auto &diag: diags) {
+      for (const auto *str: {&diag.file_name,
+                             &diag.row_idx,
+                             &diag.col_idx,
+                             &diag.serverity,
+                             &diag.brief,
+                             &diag.diagnostic_type,
+                             &diag.details}) {
+        ret += heap_size(*str);
+      }
+    }
+    return ret;
+  }
+} // namespace
+
+TEST_CASE("Parse clang-tidy diagnostic header", "[clang-tidy][parser]") {
+  auto header = parse_diagnostic_header(
+    "/src/a.cpp:12:3: error: use of undeclared identifier 'x' [clang-diagnostic-error]");
+  REQUIRE(header.has_value());
+  REQUIRE(header->file_name == "/src/a.cpp");
+  REQUIRE(header->row_idx == 12);
+  REQUIRE(header->col_idx == 3);
+  REQUIRE(header->serverity == "error");
+  REQUIRE(header->brief == " use of undeclared identifier 'x' ");
+  REQUIRE(header->diagnostic_type == "[clang-diagnostic-error]");
+
+  REQUIRE_FALSE(parse_diagnostic_header("  int n;").has_value());
+  REQUIRE_FALSE(parse_diagnostic_header("/src/a.cpp:x:3: error: brief [type]").has_value());
+  REQUIRE_FALSE(parse_diagnostic_header("/src/a.cpp:1:3: note: brief [type]").has_value());
+}
+
+TEST_CASE("Parse clang-tidy outputs", "[clang-tidy][parser]") {
+  auto diags = parse_stdout(MakeStdout(3));
+  REQUIRE(diags.size() == 3);
+  REQUIRE(diags[2].header.row_idx == 3);
+  REQUIRE(diags[2].details == "  int n;\n      ^\n        = 0\n");
+  // Repeated strings are interned.
+  REQUIRE(diags[0].header.diagnostic_type.data() == diags[2].header.diagnostic_type.data());
+
+  auto stat = parse_stderr(MakeStderr(3));
+  REQUIRE(stat.warnings == 3);
+  REQUIRE(stat.errors == 2);
+  REQUIRE(stat.total_suppressed_warnings == 12);
+  REQUIRE(stat.non_user_code_warnings == 10);
+  REQUIRE(stat.no_lint_warnings == 2);
+  REQUIRE(stat.warnings_treated_as_errors == 3);
+
+  auto single = parse_stderr("1 warning generated.\nSuppressed 1 warning (1 in non-user code).\n");
+  REQUIRE(single.warnings == 1);
+  REQUIRE(single.total_suppressed_warnings == 1);
+  REQUIRE(single.non_user_code_warnings == 1);
+}
+
+TEST_CASE("Parse clang-tidy exported fixes", "[clang-tidy][parser]") {
+  constexpr auto yaml = R"(---
+MainSourceFile:  '/src/a.cpp'
+Diagnostics:
+  - DiagnosticName:  readability-braces-around-statements
+    DiagnosticMessage:
+      Message:         'statement should be inside braces'
+      FilePath:        '/src/a.cpp'
+      FileOffset:      30
+      Replacements:
+        - FilePath:        '/src/a.cpp'
+          Offset:          30
+          Length:          0
+          ReplacementText: ' {'
+        - FilePath:        '/src/a.cpp'
+          Offset:          42
+          Length:          0
+          ReplacementText: "\n}"
+    Level:           Warning
+    BuildDirectory:  '/build'
+  - DiagnosticName:  clang-diagnostic-error
+    DiagnosticMessage:
+      Message:         'use of undeclared identifier ''x'': a:b'
+      FilePath:        'C:\src\b.cpp'
+      FileOffset:      7
+      Replacements:    []
+    Level:           Error
+...
+)";
+
+  auto diags = parse_export_fixes(yaml);
+  REQUIRE(diags.size() == 2);
+  REQUIRE(diags[0].header.diagnostic_type == "[readability-braces-around-statements]");
+  REQUIRE(diags[0].header.brief == " statement should be inside braces ");
+  REQUIRE(diags[0].header.file_name == "/src/a.cpp");
+  REQUIRE(diags[0].header.serverity == "warning");
+  REQUIRE(diags[0].file_offset == 30);
+  REQUIRE(diags[0].fixes.size() == 2);
+  REQUIRE(diags[0].fixes[0].replacement_text == " {");
+  REQUIRE(diags[0].fixes[1].offset == 42);
+  REQUIRE(diags[0].fixes[1].replacement_text == "\n}");
+
+  REQUIRE(diags[1].header.brief == " use of undeclared identifier 'x': a:b ");
+  REQUIRE(diags[1].header.file_name == "C:\\src\\b.cpp");
+  REQUIRE(diags[1].header.serverity == "error");
+  REQUIRE(diags[1].fixes.empty());
+}
+
+TEST_CASE("Parse clang-tidy check profile", "[clang-tidy][parser]") {
+  auto std_err = std::string{R"(===-------------------------------------------------------------------------===
+                          clang-tidy checks profiling
+===-------------------------------------------------------------------------===
+  Total Execution Time: 0.0300 seconds (0.0310 wall clock)
+
+   ---User Time---   --System Time--   --User+System--   ---Wall Time---  --- Name ---
+   0.0150 ( 50.0%)   0.0050 ( 50.0%)   0.0200 ( 66.7%)   0.0210 ( 67.7%)  modernize-use-using
+   0.0080 ( 50.0%)   0.0020 ( 50.0%)   0.0100 ( 33.3%)   0.0100 ( 32.3%)  readability-braces
+   0.0230 (100.0%)   0.0070 (100.0%)   0.0300 (100.0%)   0.0310 (100.0%)  Total
+
+2 warnings generated.
+   ---User Time---   ---Wall Time---  --- Name ---
+   0.0100 (100.0%)   0.0400 (100.0%)  bugprone-foo
+)"};
+
+  auto profiles = parse_check_profile(std_err);
+  REQUIRE(profiles.size() == 2);
+  REQUIRE(profiles[0].size() == 2);
+  REQUIRE(profiles[0][0].name == "modernize-use-using");
+  REQUIRE(profiles[0][0].wall == 0.0210);
+  REQUIRE(profiles[0][0].cpu == 0.0200);
+  REQUIRE(profiles[0][1].name == "readability-braces");
+  REQUIRE(profiles[1].size() == 1);
+  REQUIRE(profiles[1][0].wall == 0.0400);
+  REQUIRE(profiles[1][0].cpu == 0.0100);
+  REQUIRE(parse_stderr(std_err).warnings == 2);
+}
+
+TEST_CASE("Store diagnostics compactly", "[clang-tidy][parser]") {
+  // Strings interned by other tests would be left out of the footprint.
+  auto &pool = linter::string_pool::instance();
+  pool.clear();
+  auto std_out = MakeStdout(num_diagnostics);
+  auto diags   = parse_stdout(std_out);
+  auto compact = diags.size() * sizeof(diagnostic) + pool.size();
+  auto owning  = parse_owning_stdout(std_out);
+  REQUIRE(owning.size() == diags.size());
+  REQUIRE(owning.back().details == diags.back().details);
+  REQUIRE(diags.size() == num_diagnostics);
+  REQUIRE(compact * 2 < footprint(owning));
+}
+
+TEST_CASE("Benchmark clang-tidy output parsers", "[clang-tidy][parser][!benchmark]") {
+  const auto std_out = MakeStdout(num_diagnostics);
+  const auto std_err = MakeStderr(num_diagnostics);
+
+  BENCHMARK("parse_stdout") {
+    return parse_stdout(std_out);
+  };
+
+  // The former layout which owned all strings of diagnostics.
+  BENCHMARK("parse_stdout into owning strings") {
+    return parse_owning_stdout(std_out);
+  };
+
+  BENCHMARK("parse_stderr") {
+    return parse_stderr(std_err);
+  };
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "tools/clang_tidy/general/compile_database.h"
+
+using namespace linter::tool::clang_tidy; // NOLINT
+
+namespace {
+  void write_file(const std::filesystem::path &path, std::string_view content) {
+    std::filesystem::create_directories(path.parent_path());
+    auto file = std::ofstream{path};
+    file << content;
+  }
+
+  auto read_includes(const std::filesystem::path &path)
+    -> std::optional<std::vector<include_directive>> {
+    auto file = std::ifstream{path};
+    if (!file.is_open()) {
+      return std::nullopt;
+    }
+    return parse_includes(std::string{std::istreambuf_iterator<char>{file}, {}});
+  }
+} // namespace
+
+TEST_CASE("Parse compile commands", "[compile_database]") {
+  auto commands = parse_compile_commands(R"([
+    {"directory": "/repo/build", "file": "../src/a.cpp",
+     "command": "c++ -I../include -isystem /usr/include/x -I \"../with space\" -c ../src/a.cpp"},
+    {"directory": "/repo/build", "file": "/repo/src/b.cpp",
+     "arguments": ["c++", "-iquote", "quote", "-idirafter/after", "-Iinc", "-c", "b.cpp"]}
+  ])");
+  REQUIRE(commands.size() == 2);
+  REQUIRE(commands[0].file == "/repo/src/a.cpp");
+  REQUIRE(commands[0].include_dirs
+          == std::vector<std::filesystem::path>{"/repo/include",
+                                                "/repo/with space",
+                                                "/usr/include/x"});
+  REQUIRE(commands[0].quote_dirs.empty());
+  REQUIRE(commands[1].file == "/repo/src/b.cpp");
+  REQUIRE(commands[1].quote_dirs == std::vector<std::filesystem::path>{"/repo/build/quote"});
+  REQUIRE(commands[1].include_dirs
+          == std::vector<std::filesystem::path>{"/repo/build/inc", "/after"});
+}
+
+TEST_CASE("Make the compilation database of a copy", "[compile_database]") {
+  auto content = R"([
+    {"directory": "/repo/build", "file": "../src/a.cpp",
+     "command": "c++ -I../include -c ../src/a.cpp -o a.o"},
+    {"directory": "/repo/build", "file": "/repo/lib/b.cpp",
+     "arguments": ["c++", "-DLIB", "-c", "/repo/lib/b.cpp"]}
+  ])";
+
+  auto copy = nlohmann::json::parse(make_copy_database(content, "/repo/src/a.cpp", "/tmp/a.cpp"));
+  REQUIRE(copy.size() == 1);
+  REQUIRE(copy[0]["directory"] == "/repo/build");
+  REQUIRE(copy[0]["file"] == "/tmp/a.cpp");
+  REQUIRE(copy[0]["arguments"].get<std::vector<std::string>>()
+          == std::vector<std::string>{
+            "c++", "-iquote", "/repo/src", "-I../include", "-c", "-o", "a.o", "/tmp/a.cpp"});
+
+  // A file not in the database borrows the command of the nearest one.
+  copy = nlohmann::json::parse(make_copy_database(content, "/repo/lib/c.h", "/tmp/c.h"));
+  REQUIRE(copy[0]["arguments"].get<std::vector<std::string>>()
+          == std::vector<std::string>{"c++", "-iquote", "/repo/lib", "-DLIB", "-c", "/tmp/c.h"});
+
+  copy = nlohmann::json::parse(make_copy_database("", "/repo/src/a.cpp", "/tmp/a.cpp"));
+  REQUIRE(copy[0]["arguments"].get<std::vector<std::string>>()
+          == std::vector<std::string>{"clang-tool", "-iquote", "/repo/src", "/tmp/a.cpp"});
+}
+
+TEST_CASE("Parse include directives", "[compile_database]") {
+  auto directives = parse_includes("#include <vector>\n"
+                                   "  #  include \"a.h\" // comment\n"
+                                   "#include_next <b.h>\n"
+                                   "#include MACRO\n"
+                                   "#define X 1\n"
+                                   "int x; // #include \"c.h\"\n");
+  REQUIRE(directives.size() == 3);
+  REQUIRE(directives[0].name == "vector");
+  REQUIRE_FALSE(directives[0].quoted);
+  REQUIRE(directives[1].name == "a.h");
+  REQUIRE(directives[1].quoted);
+  REQUIRE(directives[2].name == "b.h");
+}
+
+TEST_CASE("Find translation units affected by headers", "[compile_database]") {
+  auto root = std::filesystem::temp_directory_path() / "cpp-linter-test-compile-database";
+  std::filesystem::remove_all(root);
+  write_file(root / "include/common.h", "#pragma once\n#include \"detail.h\"\n");
+  write_file(root / "include/detail.h", "#pragma once\n#include \"common.h\"\n");
+  write_file(root / "include/other.h", "#pragma once\n#include <vector>\n");
+  write_file(root / "src/local.h", "#pragma once\n");
+  write_file(root / "src/a.cpp", "#include <common.h>\n#include \"local.h\"\n");
+  write_file(root / "src/b.cpp", "#include \"other.h\"\n");
+  write_file(root / "src/c.cpp", "#include \"missing.h\"\n");
+
+  auto command = [&](std::string_view file) {
+    return compile_command{.file = root / "src" / file, .include_dirs = {root / "include"}};
+  };
+  auto graph = include_graph{
+    {command("a.cpp"), command("b.cpp"), command("c.cpp")},
+    root,
+    read_includes
+  };
+  REQUIRE(graph.num_units() == 3);
+
+  auto affected = [&](std::vector<std::filesystem::path> headers) {
+    return graph.affected_units(headers);
+  };
+  REQUIRE(affected({root / "include/detail.h"})
+          == std::vector<std::filesystem::path>{root / "src/a.cpp"});
+  REQUIRE(affected({root / "src/local.h"})
+          == std::vector<std::filesystem::path>{root / "src/a.cpp"});
+  REQUIRE(affected({root / "include/other.h", root / "include/../include/common.h"})
+          == std::vector<std::filesystem::path>{root / "src/a.cpp", root / "src/b.cpp"});
+  REQUIRE(affected({root / "include/unused.h"}).empty());
+  std::filesystem::remove_all(root);
+}
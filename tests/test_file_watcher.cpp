@@ -0,0 +1,41 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/file_watcher.h"
+
+using namespace linter; // NOLINT
+
+namespace {
+  const auto root = std::filesystem::temp_directory_path() / "test_file_watcher";
+
+  void write_file(const std::string &file, const std::string &content) {
+    auto stream = std::ofstream{root / file};
+    stream << content;
+  }
+} // namespace
+
+TEST_CASE("Watch saved files", "[file_watcher]") {
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / "src" / ".git");
+  auto watcher = file_watcher{root.string(), {".git"}};
+
+  auto writer = std::jthread{[] {
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    write_file("src/a.cpp", "a");
+    write_file("src/.git/index", "skipped");
+    std::filesystem::create_directories(root / "include");
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    write_file("include/b.h", "b");
+    write_file("src/a.cpp", "aa");
+  }};
+  auto files = watcher.wait(std::chrono::milliseconds{200});
+  REQUIRE(files == std::vector<std::string>{"include/b.h", "src/a.cpp"});
+
+  std::filesystem::remove_all(root);
+}
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cctype>
 #include <filesystem>
+#include <format>
 #include <fstream>
 #include <git2/diff.h>
 #include <ios>
@@ -11,6 +13,8 @@
 
 #include "catch2/catch_test_macros.hpp"
 #include "utils/git_utils.h"
+#include "utils/patch_set.h"
+#include "utils/repo_pool.h"
 
 using namespace linter;
 using namespace std::string_literals;
@@ -342,6 +346,260 @@ intu3;
   REQUIRE(lines.size() == 2);
 }
 
+TEST_CASE("Create patches lazily", "[git2][patch]") {
+  RefreshRepoDir();
+  const auto files = std::vector<std::string>{"file1.cpp", "file2.cpp"};
+  CreateTempFilesWithSameContent(files, "hello world\n");
+  auto [repo, commit1] = InitRepoWithACommit(files);
+
+  AppendToFile("file1.cpp", "hello world2\n");
+  AppendToFile("file2.cpp", "hello world2\n");
+  auto [index_oid2, index2]   = git::index::add_files(repo.get(), files);
+  auto [commit_oid2, commit2] = git::commit::create_head(repo.get(), "Two", index2.get());
+
+  auto patches = git::patch_set{git::diff::get(*repo, *commit1, *commit2)};
+  REQUIRE(patches.size() == 2);
+  REQUIRE(patches.contains("file1.cpp"));
+  REQUIRE_FALSE(patches.contains("file3.cpp"));
+  REQUIRE_THROWS(patches.at("file3.cpp"));
+
+  auto *patch = patches.at("file1.cpp");
+  REQUIRE(patch == patches.at("file1.cpp"));
+  REQUIRE(git::patch::num_hunks(patch) == 1);
+
+  RemoveRepoDir();
+}
+
+TEST_CASE("Drop deltas which needn't be checked", "[git2][patch]") {
+  RefreshRepoDir();
+  const auto files = std::vector<std::string>{"file1.cpp"};
+  CreateTempFilesWithSameContent(files, "hello world\n");
+  auto [repo, commit1] = InitRepoWithACommit(files);
+
+  AppendToFile("file1.cpp", "hello world2\n");
+  CreateTempFile("file2.bin", std::string{"hello\0world", 11});
+  auto [index_oid2, index2]   = git::index::add_files(repo.get(), {"file1.cpp", "file2.bin"});
+  auto [commit_oid2, commit2] = git::commit::create_head(repo.get(), "Two", index2.get());
+
+  auto diff = git::diff::get(*repo, *commit1, *commit2);
+  git::diff::find_similar(diff.get(), git::diff::init_find_option(GIT_DIFF_FIND_RENAMES));
+  auto patches = git::patch_set{std::move(diff), [&](const git::diff_delta& delta) {
+                                  return git::needs_check(repo.get(), delta);
+                                }};
+  REQUIRE(patches.files() == std::vector<std::string>{"file1.cpp"});
+
+  RemoveRepoDir();
+}
+
+TEST_CASE("Keep copied files and drop unchanged renames", "[git2][patch]") {
+  RefreshRepoDir();
+  CreateTempFile("file1.cpp", "hello world\n");
+  CreateTempFile("file2.cpp", "hello git\n");
+  auto [repo, commit1] = InitRepoWithACommit({"file1.cpp", "file2.cpp"});
+
+  AppendToFile("file1.cpp", "hello world2\n");
+  CreateTempFile("file3.cpp", "hello world\n");
+  std::filesystem::rename(temp_repo_dir / "file2.cpp", temp_repo_dir / "file4.cpp");
+  auto index = git::repo::index(repo.get());
+  REQUIRE(::git_index_remove_bypath(index.get(), "file2.cpp") == 0);
+  auto [index_oid2, index2] =
+    git::index::add_files(repo.get(), {"file1.cpp", "file3.cpp", "file4.cpp"});
+  auto [commit_oid2, commit2] = git::commit::create_head(repo.get(), "Two", index2.get());
+
+  auto diff = git::diff::get(*repo, *commit1, *commit2);
+  git::diff::find_similar(diff.get(),
+                          git::diff::init_find_option(GIT_DIFF_FIND_RENAMES | GIT_DIFF_FIND_COPIES));
+  auto patches = git::patch_set{std::move(diff), [&](const git::diff_delta& delta) {
+                                  return git::needs_check(repo.get(), delta);
+                                }};
+  REQUIRE(patches.files() == std::vector<std::string>{"file1.cpp", "file3.cpp"});
+
+  RemoveRepoDir();
+}
+
+TEST_CASE("Drop deltas of a large diff by several threads", "[git2][patch]") {
+  RefreshRepoDir();
+  auto files = std::vector<std::string>{};
+  for (auto idx = 0; idx < 300; ++idx) {
+    files.push_back(std::format("file{:03}.cpp", idx));
+  }
+  CreateTempFilesWithSameContent(files, "hello world\n");
+  auto [repo, commit1] = InitRepoWithACommit(files);
+
+  auto binaries = std::vector<std::string>{};
+  for (auto idx = 0; idx < 300; ++idx) {
+    if (idx % 3 == 0) {
+      CreateTempFile(files[idx], std::string{"hello\0world", 11});
+      binaries.push_back(files[idx]);
+    } else {
+      AppendToFile(files[idx], "hello world2\n");
+    }
+  }
+  auto [index_oid2, index2]   = git::index::add_files(repo.get(), files);
+  auto [commit_oid2, commit2] = git::commit::create_head(repo.get(), "Two", index2.get());
+
+  auto patches = git::patch_set{git::diff::get(*repo, *commit1, *commit2),
+                                [&](const git::diff_delta& delta) {
+                                  return git::needs_check(repo.get(), delta);
+                                }};
+  auto expected = files;
+  std::erase_if(expected, [&](const auto& file) { return std::ranges::contains(binaries, file); });
+  REQUIRE(patches.files() == expected);
+
+  RemoveRepoDir();
+}
+
+TEST_CASE("Hash buffer as blob", "[git2][oid]") {
+  auto oid = git::oid::hash("hello\n");
+  REQUIRE(git::oid::to_str(oid).starts_with("ce013625030ba8dba906f756967f9e9ca394464a"));
+}
+
+TEST_CASE("Lookup tree entry by path", "[git2][tree]") {
+  RefreshRepoDir();
+  std::filesystem::create_directory(temp_repo_dir / "dir");
+  const auto files = std::vector<std::string>{"dir/file1.cpp"};
+  CreateTempFilesWithSameContent(files, "hello\n");
+  auto [repo, commit] = InitRepoWithACommit(files);
+  auto tree           = git::commit::tree(commit.get());
+
+  auto entry = git::tree::entry_bypath(tree.get(), "dir/file1.cpp");
+  REQUIRE(entry != nullptr);
+  REQUIRE(git::oid::equal(*git::tree::entry_id(entry.get()), git::oid::hash("hello\n")));
+  REQUIRE(git::tree::entry_bypath(tree.get(), "dir/file2.cpp") == nullptr);
+
+  RemoveRepoDir();
+}
+
+TEST_CASE("Map rows into positions of patch", "[git2][patch]") {
+  auto before = "a\nb\nc\nd\ne\nf\ng\nh\n"s;
+  auto after  = "a\nB\nc\nd\ne\nf\nG\nh\n"s;
+
+  auto opts          = git::diff::init_option();
+  opts.context_lines = 0;
+  auto patch         = git::patch::create_from_buffers(before, "name", after, "name", opts);
+
+  auto hunks = git::hunk_index{patch.get()};
+  REQUIRE(hunks.num_hunks() == 2);
+  REQUIRE(hunks.position(2) == 2);
+  REQUIRE(hunks.position(7) == 5);
+  REQUIRE_FALSE(hunks.position(1).has_value());
+  REQUIRE_FALSE(hunks.position(3).has_value());
+  REQUIRE_FALSE(hunks.position(8).has_value());
+}
+
+TEST_CASE("Check whether rows are in one hunk", "[git2][patch]") {
+  auto before = "a\nb\nc\nd\ne\nf\ng\nh\n"s;
+  auto after  = "a\nB\nC\nd\ne\nf\nG\nh\n"s;
+
+  auto opts          = git::diff::init_option();
+  opts.context_lines = 0;
+  auto patch         = git::patch::create_from_buffers(before, "name", after, "name", opts);
+
+  auto hunks = git::hunk_index{patch.get()};
+  REQUIRE(hunks.contains(2, 3));
+  REQUIRE(hunks.contains(7, 7));
+  REQUIRE_FALSE(hunks.contains(1, 2));
+  REQUIRE_FALSE(hunks.contains(3, 4));
+  REQUIRE_FALSE(hunks.contains(2, 7));
+}
+
+TEST_CASE("View blob content with embedded NUL", "[git2][blob]") {
+  RefreshRepoDir();
+  const auto files = std::vector<std::string>{"file1.cpp"};
+  CreateTempFilesWithSameContent(files, "hello\0world"s);
+  auto [repo, commit] = InitRepoWithACommit(files);
+
+  auto view = git::blob::get_view(repo.get(), commit.get(), "file1.cpp");
+  REQUIRE(view.content == "hello\0world"sv);
+  REQUIRE(git::blob::get_raw_content(repo.get(), commit.get(), "file1.cpp") == "hello\0world"s);
+  REQUIRE(git::blob::get_view(repo.get(), commit.get(), "file2.cpp").content.empty());
+
+  RemoveRepoDir();
+}
+
+TEST_CASE("Restore patch set from saved hunk indexes", "[git2][patch]") {
+  auto before = "a\nb\nc\nd\ne\nf\ng\nh\n"s;
+  auto after  = "a\nB\nB2\nc\nd\ne\nf\nG\nh\n"s;
+
+  auto opts          = git::diff::init_option();
+  opts.context_lines = 1;
+  auto patch         = git::patch::create_from_buffers(before, "name", after, "name", opts);
+  auto hunks         = git::hunk_index{patch.get()};
+
+  auto saved = nlohmann::json(hunks).dump();
+  auto files = std::vector<std::pair<std::string, git::hunk_index>>{};
+  files.emplace_back("name", nlohmann::json::parse(saved).get<git::hunk_index>());
+  auto restored = git::patch_set{std::move(files)};
+  REQUIRE(restored.contains("name"));
+  REQUIRE_THROWS(restored.at("name"));
+  const auto &index = restored.hunks("name");
+  REQUIRE(index.num_hunks() == hunks.num_hunks());
+  for (auto row = std::size_t{0}; row <= 10; ++row) {
+    REQUIRE(index.position(row) == hunks.position(row));
+  }
+}
+
+TEST_CASE("Lease repository handles from a pool", "[git2][repo]") {
+  RefreshRepoDir();
+  const auto files = std::vector<std::string>{"file1.cpp"};
+  CreateTempFilesWithSameContent(files, "hello\n");
+  auto [repo, commit] = InitRepoWithACommit(files);
+  const auto &id      = *git::commit::id(commit.get());
+  auto pool           = git::repo_pool{temp_repo_dir.string(), id, id};
+
+  auto *first_repo = git::repo_raw_ptr{nullptr};
+  {
+    auto first  = pool.acquire();
+    auto second = pool.acquire();
+    REQUIRE(first->repo.get() != second->repo.get());
+    REQUIRE(git::commit::id_str(first->source.get()) == git::commit::id_str(commit.get()));
+    auto view = git::blob::get_view(second->repo.get(), second->source_tree.get(), "file1.cpp");
+    REQUIRE(view.content == "hello\n");
+    first_repo = first->repo.get();
+  }
+  // Returned handles are reused.
+  auto again = pool.acquire();
+  auto other = pool.acquire();
+  REQUIRE((again->repo.get() == first_repo || other->repo.get() == first_repo));
+
+  RemoveRepoDir();
+}
+
+TEST_CASE("Create a commit of the staged changes", "[git2][commit][index]") {
+  RefreshRepoDir();
+  const auto files = std::vector<std::string>{"file1.cpp"};
+  CreateTempFilesWithSameContent(files, "hello\n");
+  auto [repo, head] = InitRepoWithACommit(files);
+  AppendToFile("file1.cpp", "staged\n");
+  git::index::add_files(repo.get(), files);
+  AppendToFile("file1.cpp", "unstaged\n");
+
+  git::repo::use_memory_odb(repo.get());
+  auto staged = git::commit::create_staged(repo.get());
+  REQUIRE(git::commit::parent_count(staged.get()) == 1);
+  REQUIRE(git::commit::id_str(git::commit::parent(staged.get(), 0).get())
+          == git::commit::id_str(head.get()));
+  auto content = git::blob::get_raw_content(repo.get(), staged.get(), "file1.cpp");
+  REQUIRE(content == "hello\nstaged\n");
+
+  // HEAD isn't moved and the same index always makes the same commit.
+  REQUIRE(git::commit::id_str(git::repo::head_commit(repo.get()).get())
+          == git::commit::id_str(head.get()));
+  auto again = git::commit::create_staged(repo.get());
+  REQUIRE(git::commit::id_str(again.get()) == git::commit::id_str(staged.get()));
+
+  // Nothing is written to the object database, so other repositories create
+  // the commit again.
+  const auto &head_id   = *git::commit::id(head.get());
+  const auto &staged_id = *git::commit::id(staged.get());
+  auto other            = git::repo::open(temp_repo_dir.string());
+  REQUIRE_THROWS(git::commit::lookup(other.get(), &staged_id));
+  auto pool = git::repo_pool{temp_repo_dir.string(), head_id, staged_id, true};
+  REQUIRE(git::commit::id_str(pool.acquire()->source.get()) == git::commit::id_str(staged.get()));
+
+  RemoveRepoDir();
+}
+
 int main(int argc, char* argv[]) {
   git::setup();
   int result = Catch::Session().run(argc, argv);
@@ -0,0 +1,28 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "utils/line_index.h"
+
+using namespace linter; // NOLINT
+
+TEST_CASE("Convert offsets into positions", "[line_index]") {
+  auto index = line_index{"ab\n\ncd\n"};
+  REQUIRE(index.num_lines() == 4);
+  REQUIRE(index.position(0) == std::pair<std::size_t, std::size_t>{1, 1});
+  REQUIRE(index.position(2) == std::pair<std::size_t, std::size_t>{1, 3});
+  REQUIRE(index.position(3) == std::pair<std::size_t, std::size_t>{2, 1});
+  REQUIRE(index.position(5) == std::pair<std::size_t, std::size_t>{3, 2});
+  REQUIRE(index.position(7) == std::pair<std::size_t, std::size_t>{4, 1});
+  REQUIRE_FALSE(index.position(8).has_value());
+}
+
+TEST_CASE("Get line starts", "[line_index]") {
+  auto index = line_index{"ab\ncd"};
+  REQUIRE(index.line_start(1) == 0);
+  REQUIRE(index.line_start(2) == 3);
+  REQUIRE_FALSE(index.line_start(0).has_value());
+  REQUIRE_FALSE(index.line_start(3).has_value());
+
+  auto empty = line_index{""};
+  REQUIRE(empty.num_lines() == 1);
+  REQUIRE(empty.position(0) == std::pair<std::size_t, std::size_t>{1, 1});
+}
@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/output_sink.h"
+
+using namespace linter::shell; // NOLINT
+
+TEST_CASE("Split chunks into lines", "[output_sink]") {
+  auto lines    = std::vector<std::string>{};
+  auto splitter = line_splitter{[&](std::string_view line) { lines.emplace_back(line); }};
+  splitter.feed("ab");
+  splitter.feed("c\r\nd\n\ne");
+  REQUIRE(lines == std::vector<std::string>{"abc", "d", ""});
+  splitter.feed("f");
+  splitter.finish();
+  REQUIRE(lines == std::vector<std::string>{"abc", "d", "", "ef"});
+
+  // Nothing is passed for the end of a finished line.
+  splitter.feed("g\n");
+  splitter.finish();
+  REQUIRE(lines.back() == "g");
+  REQUIRE(lines.size() == 5);
+}
+
+TEST_CASE("Cap kept output", "[output_sink]") {
+  auto output = capped_output{4};
+  output.append("ab");
+  REQUIRE(output.str() == "ab");
+  output.append("cdef");
+  output.append("gh");
+  REQUIRE(output.str() == "abcd\n... 4 bytes are truncated");
+
+  auto none = capped_output{0};
+  none.append("abc");
+  REQUIRE(none.str() == "\n... 3 bytes are truncated");
+}
+
+TEST_CASE("Hand chunks over to another thread", "[output_sink]") {
+  auto queue    = chunk_queue{};
+  auto producer = std::thread{[sink = queue.sink(), &queue] {
+    for (const auto *chunk: {"ab", "c\n", "d"}) {
+      sink(chunk);
+    }
+    queue.close();
+  }};
+  auto output = std::string{};
+  for (auto chunks = queue.take(); !chunks.empty(); chunks = queue.take()) {
+    for (const auto &chunk: chunks) {
+      output += chunk;
+    }
+  }
+  producer.join();
+  REQUIRE(output == "abc\nd");
+  REQUIRE(queue.take().empty());
+}
@@ -0,0 +1,55 @@
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "tools/base_option.h"
+#include "tools/path_filter.h"
+
+using namespace linter::tool; // NOLINT
+
+TEST_CASE("Match files by extensions", "[path_filter]") {
+  auto filter = path_filter{option_base{}.source_filter_iregex};
+  REQUIRE(filter.matches("src/main.cpp"));
+  REQUIRE(filter.matches("src/MAIN.CPP"));
+  REQUIRE(filter.matches("include/a.c++"));
+  REQUIRE(filter.matches("b.h"));
+  REQUIRE(filter.matches(".cpp"));
+  REQUIRE_FALSE(filter.matches("cpp"));
+  REQUIRE_FALSE(filter.matches("src/main.cpp.orig"));
+  REQUIRE_FALSE(filter.matches("README.md"));
+
+  auto single = path_filter{R"(.*\.py)"};
+  REQUIRE(single.matches("tools/run.py"));
+  REQUIRE_FALSE(single.matches("tools/run.pyc"));
+}
+
+TEST_CASE("Match files by a literal path", "[path_filter]") {
+  auto filter = path_filter{R"(src/main\.cpp)"};
+  REQUIRE(filter.matches("src/main.cpp"));
+  REQUIRE(filter.matches("SRC/Main.cpp"));
+  REQUIRE_FALSE(filter.matches("src/mainXcpp"));
+  REQUIRE_FALSE(filter.matches("a/src/main.cpp"));
+}
+
+TEST_CASE("Match files by a regex", "[path_filter]") {
+  auto filter = path_filter{R"(src/.*\.(cpp|h))"};
+  REQUIRE(filter.matches("src/a/b.cpp"));
+  REQUIRE(filter.matches("SRC/b.H"));
+  REQUIRE_FALSE(filter.matches("test/b.cpp"));
+
+  // Not matched by extension although it looks like one.
+  auto suffix = path_filter{R"(.*\.(cpp|h)x)"};
+  REQUIRE(suffix.matches("a.cppx"));
+  REQUIRE_FALSE(suffix.matches("a.cpp"));
+}
+
+TEST_CASE("Classify files by several filters at once", "[path_filter]") {
+  auto files   = std::vector<std::string>{"a.cpp", "b.md", "c.h", "d.py"};
+  auto classes = classify_files(files, {R"(.*\.(cpp|h))", R"(.*\.py)"});
+  REQUIRE(classes.size() == 2);
+  REQUIRE(classes[0].matched == std::vector<std::string>{"a.cpp", "c.h"});
+  REQUIRE(classes[0].ignored == std::vector<std::string>{"b.md", "d.py"});
+  REQUIRE(classes[1].matched == std::vector<std::string>{"d.py"});
+  REQUIRE(&compiled_path_filter(R"(.*\.py)") == &compiled_path_filter(R"(.*\.py)"));
+}
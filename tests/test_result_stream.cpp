@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "tools/result_stream.h"
+
+using namespace linter;       // NOLINT
+using namespace linter::tool; // NOLINT
+
+namespace {
+  auto read_lines(const std::filesystem::path &file) -> std::vector<std::string> {
+    auto in    = std::ifstream{file};
+    auto lines = std::vector<std::string>{};
+    for (auto line = std::string{}; std::getline(in, line);) {
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  auto make_result(std::string file, bool passed) -> per_file_result_base {
+    return {.passed = passed, .file_path = std::move(file), .tool_stdout = {}, .tool_stderr = {}};
+  }
+
+  auto make_diagnostic(std::string path, std::uint32_t line) -> github::annotation {
+    return {.path             = std::move(path),
+            .start_line       = line,
+            .end_line         = line,
+            .annotation_level = "warning",
+            .title            = "clang-tidy [misc-unused]",
+            .message          = "unused variable",
+            .raw_details      = {}};
+  }
+} // namespace
+
+TEST_CASE("Write results as JSON Lines once the buffer is full", "[result_stream]") {
+  auto file = std::filesystem::temp_directory_path() / "cpp-linter-test-result-stream.jsonl";
+  auto stream = result_stream{file.string(), result_stream::format_t::jsonl, 1};
+  stream.add("clang-format", make_result("a.cpp", true), {});
+
+  // Written before closed since the buffer is full.
+  auto lines = read_lines(file);
+  REQUIRE(lines.size() == 1);
+  auto record = nlohmann::json::parse(lines[0]);
+  REQUIRE(record["type"] == "file");
+  REQUIRE(record["tool"] == "clang-format");
+  REQUIRE(record["file"] == "a.cpp");
+  REQUIRE(record["passed"] == true);
+
+  stream.add("clang-tidy", make_result("b.cpp", false), {make_diagnostic("b.cpp", 3)});
+  stream.close();
+  stream.add("clang-tidy", make_result("c.cpp", false), {});
+
+  lines = read_lines(file);
+  REQUIRE(lines.size() == 3);
+  REQUIRE(nlohmann::json::parse(lines[1])["diagnostics"] == 1);
+  auto diagnostic = nlohmann::json::parse(lines[2]);
+  REQUIRE(diagnostic["type"] == "diagnostic");
+  REQUIRE(diagnostic["path"] == "b.cpp");
+  REQUIRE(diagnostic["start_line"] == 3);
+  std::filesystem::remove(file);
+}
+
+TEST_CASE("Write results once the flush interval passed", "[result_stream]") {
+  auto file   = std::filesystem::temp_directory_path() / "cpp-linter-test-result-interval.jsonl";
+  auto stream = result_stream{file.string(),
+                              result_stream::format_t::jsonl,
+                              result_stream::default_buffer_size,
+                              std::chrono::milliseconds{0}};
+  stream.add("clang-format", make_result("a.cpp", true), {});
+  REQUIRE(read_lines(file).size() == 1);
+  stream.close();
+  std::filesystem::remove(file);
+}
+
+TEST_CASE("Write diagnostics as SARIF results", "[result_stream]") {
+  auto file = std::filesystem::temp_directory_path() / "cpp-linter-test-result-stream.sarif";
+  {
+    auto stream = result_stream{file.string(), parse_result_format("sarif")};
+    stream.add("clang-tidy", make_result("a.cpp", false), {make_diagnostic("a.cpp", 1)});
+    stream.add("clang-tidy", make_result("b.cpp", true), {});
+    stream.add("clang-tidy", make_result("c.cpp", false), {make_diagnostic("c.cpp", 7)});
+  }
+
+  auto in      = std::ifstream{file};
+  auto sarif   = nlohmann::json::parse(in);
+  auto results = sarif["runs"][0]["results"];
+  REQUIRE(sarif["version"] == "2.1.0");
+  REQUIRE(results.size() == 2);
+  REQUIRE(results[1]["level"] == "warning");
+  REQUIRE(results[1]["ruleId"] == "misc-unused");
+  auto rules = sarif["runs"][0]["tool"]["driver"]["rules"];
+  REQUIRE(rules.size() == 1);
+  REQUIRE(rules[0]["id"] == "misc-unused");
+  auto location = results[1]["locations"][0]["physicalLocation"];
+  REQUIRE(location["artifactLocation"]["uri"] == "c.cpp");
+  REQUIRE(location["region"]["startLine"] == 7);
+  REQUIRE_THROWS(parse_result_format("xml"));
+  std::filesystem::remove(file);
+}
@@ -0,0 +1,370 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "tools/scheduler.h"
+
+using namespace linter::tool; // NOLINT
+
+namespace {
+  struct fake_result {
+    bool passed = false;
+  };
+
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(fake_result, passed)
+
+  auto make_tasks(std::initializer_list<std::pair<const char *, std::uint64_t>> costs)
+    -> std::vector<tool_task> {
+    auto tasks = std::vector<tool_task>{};
+    for (auto [name, cost]: costs) {
+      tasks.push_back({.cost = cost, .name = name, .run = [] {}});
+    }
+    return tasks;
+  }
+
+  auto names_of(const std::vector<tool_task> &tasks) -> std::vector<std::string> {
+    auto names = std::vector<std::string>{};
+    for (const auto &task: tasks) {
+      names.push_back(task.name);
+    }
+    std::ranges::sort(names);
+    return names;
+  }
+} // namespace
+
+TEST_CASE("Run the most costly task first", "[scheduler]") {
+  auto mutex = std::mutex{};
+  auto order = std::vector<int>{};
+  auto tasks = std::vector<tool_task>{};
+  for (auto [id, cost]: {std::pair{1, 10}, std::pair{2, 30}, std::pair{3, 20}}) {
+    tasks.push_back({.cost = static_cast<std::uint64_t>(cost), .run = [&, id] {
+      auto lock = std::lock_guard{mutex};
+      order.push_back(id);
+    }});
+  }
+  run_tasks(std::move(tasks), 1);
+  REQUIRE(order == std::vector<int>{2, 3, 1});
+}
+
+TEST_CASE("Rethrow the exception of tasks", "[scheduler]") {
+  auto tasks = std::vector<tool_task>{};
+  tasks.push_back({.cost = 0, .run = [] { throw std::runtime_error{"failed"}; }});
+  REQUIRE_THROWS_AS(run_tasks(std::move(tasks), 4), std::runtime_error);
+}
+
+TEST_CASE("Merge results by the order of files", "[scheduler]") {
+  auto files  = std::vector<std::string>{"a.cpp", "b.cpp", "c.cpp"};
+  auto slots  = file_slots<fake_result>{files.size()};
+  auto merged = std::vector<std::size_t>{};
+  slots.set(2, {.passed = true});
+  slots.set(1, {.passed = false});
+  slots.set(0, {.passed = true});
+  REQUIRE(slots.after_failed(2));
+  REQUIRE_FALSE(slots.after_failed(1));
+
+  SECTION("Merge all files") {
+    auto result = multi_files_result_base<fake_result>{};
+    slots.merge(files, result, false, false, "tool", [&](auto idx, const auto &) {
+      merged.push_back(idx);
+    });
+    REQUIRE(merged == std::vector<std::size_t>{0, 1, 2});
+    REQUIRE(result.passes.size() == 2);
+    REQUIRE(result.fails.contains("b.cpp"));
+    REQUIRE_FALSE(result.final_passed);
+    REQUIRE_FALSE(result.fastly_exited);
+  }
+
+  SECTION("Stop at the first failed file") {
+    auto result = multi_files_result_base<fake_result>{};
+    slots.merge(files, result, true, false, "tool", [&](auto idx, const auto &) {
+      merged.push_back(idx);
+    });
+    REQUIRE(merged == std::vector<std::size_t>{0, 1});
+    REQUIRE(result.fastly_exited);
+  }
+}
+
+TEST_CASE("Record timed out files apart from failed ones", "[scheduler]") {
+  auto files  = std::vector<std::string>{"a.cpp", "b.cpp"};
+  auto slots  = file_slots<fake_result>{files.size()};
+  auto result = multi_files_result_base<fake_result>{};
+  slots.set(0, {.passed = true});
+  slots.set_timed_out(1);
+
+  SECTION("Fail the result by default") {
+    slots.merge(files, result, false, false, "tool", [](auto, const auto &) {});
+    REQUIRE_FALSE(result.final_passed);
+    REQUIRE(result.fails.empty());
+  }
+
+  SECTION("Pass the result if timed out files are allowed") {
+    slots.merge(files, result, false, true, "tool", [](auto, const auto &) {});
+    REQUIRE(result.final_passed);
+  }
+  REQUIRE(result.passes.contains("a.cpp"));
+  REQUIRE(result.timed_out == std::vector<std::string>{"b.cpp"});
+}
+
+TEST_CASE("Publish failed results as soon as they're set", "[scheduler]") {
+  auto slots      = file_slots<fake_result>{3};
+  auto published  = std::vector<bool>{};
+  slots.on_failed = [&](const fake_result &res) { published.push_back(res.passed); };
+  slots.set(0, {.passed = true});
+  slots.set(2, {.passed = false});
+  REQUIRE(published == std::vector<bool>{false});
+  REQUIRE(slots.results[2].has_value());
+}
+
+TEST_CASE("Keep results whose consumers throw", "[scheduler]") {
+  auto slots       = file_slots<fake_result>{1};
+  slots.on_checked = [](const fake_result &) { throw std::runtime_error{"disk full"}; };
+  slots.on_failed  = [](const fake_result &) { throw std::runtime_error{"disk full"}; };
+  REQUIRE_NOTHROW(slots.set(0, {.passed = false}));
+  REQUIRE(slots.results[0].has_value());
+  REQUIRE(slots.any_failed());
+}
+
+TEST_CASE("Skip files not checked since another tool failed", "[scheduler]") {
+  auto files  = std::vector<std::string>{"a.cpp", "b.cpp"};
+  auto slots  = file_slots<fake_result>{files.size()};
+  auto result = multi_files_result_base<fake_result>{};
+  slots.set(0, {.passed = true});
+  slots.set_skipped(1);
+  REQUIRE_FALSE(slots.any_failed());
+  slots.merge(files, result, false, false, "tool", [](auto, const auto &) {});
+  REQUIRE(result.fastly_exited);
+  REQUIRE_FALSE(result.final_passed);
+  REQUIRE(result.passes.contains("a.cpp"));
+}
+
+TEST_CASE("Pass a shard whose files all pass", "[scheduler]") {
+  auto root = std::filesystem::temp_directory_path() / "test_scheduler_passed_shard";
+  std::filesystem::create_directories(root);
+  for (auto [file, size]: {std::pair{"a.cpp", 4}, std::pair{"b.cpp", 3}, std::pair{"c.cpp", 2}}) {
+    std::ofstream{root / file} << std::string(size, 'x');
+  }
+  auto files = std::vector<std::string>{"a.cpp", "b.cpp", "c.cpp"};
+  for (auto shard_index = 0U; shard_index < 2; ++shard_index) {
+    auto shard  = select_shard_files(files, root.string(), shard_index, 2);
+    auto slots  = file_slots<fake_result>{shard.size()};
+    auto result = multi_files_result_base<fake_result>{};
+    for (auto idx = std::size_t{0}; idx < shard.size(); ++idx) {
+      slots.set(idx, {.passed = true});
+    }
+    slots.merge(shard, result, false, false, "tool", [](auto, const auto &) {});
+    REQUIRE(result.final_passed);
+    REQUIRE_FALSE(result.fastly_exited);
+    REQUIRE(result.passes.size() == shard.size());
+  }
+  std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Start no more task once cancelled", "[scheduler]") {
+  auto cancelled = std::atomic<bool>{false};
+  auto ran       = std::atomic<int>{0};
+  auto skipped   = std::atomic<int>{0};
+  auto tasks     = std::vector<tool_task>{};
+  for (auto cost: {3U, 2U, 1U}) {
+    auto task = tool_task{};
+    task.cost = cost;
+    task.name = std::to_string(cost);
+    task.run  = [&] {
+      ++ran;
+      cancelled.store(true);
+    };
+    task.skip = [&] { ++skipped; };
+    tasks.push_back(std::move(task));
+  }
+  auto measures = run_tasks(std::move(tasks), 1, 0, &cancelled);
+  REQUIRE(ran == 1);
+  REQUIRE(skipped == 2);
+  REQUIRE(measures.durations.size() == 1);
+  REQUIRE(measures.durations.contains("3"));
+}
+
+TEST_CASE("Measure the durations of tasks", "[scheduler]") {
+  auto durations = run_tasks(make_tasks({{"a", 1}, {"b", 2}}), 2);
+  REQUIRE(durations.size() == 2);
+  REQUIRE(durations.contains("a"));
+  REQUIRE(durations.contains("b"));
+}
+
+TEST_CASE("Admit tasks by the memory budget", "[scheduler]") {
+  auto running     = std::atomic<int>{0};
+  auto max_running = std::atomic<int>{0};
+  auto make_task   = [&](std::uint64_t memory) {
+    auto task   = tool_task{.cost = 1, .name = {}, .run = [&] {
+      auto now = ++running;
+      auto cur = max_running.load();
+      while (now > cur && !max_running.compare_exchange_weak(cur, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      --running;
+    }};
+    task.memory = memory;
+    return task;
+  };
+
+  SECTION("Run tasks one by one if only one fits") {
+    auto tasks = std::vector<tool_task>{};
+    for (auto idx = 0; idx < 4; ++idx) {
+      tasks.push_back(make_task(60));
+    }
+    run_tasks(std::move(tasks), 4, 100);
+    REQUIRE(max_running == 1);
+  }
+
+  SECTION("Run tasks larger than the budget alone") {
+    auto tasks = std::vector<tool_task>{};
+    tasks.push_back(make_task(500));
+    tasks.push_back(make_task(10));
+    run_tasks(std::move(tasks), 2, 100);
+    REQUIRE(max_running == 1);
+  }
+
+  SECTION("Estimate tasks unknown by the known ones") {
+    auto tasks = std::vector<tool_task>{};
+    tasks.push_back(make_task(80));
+    tasks.push_back(make_task(0));
+    tasks.push_back(make_task(0));
+    run_tasks(std::move(tasks), 3, 100);
+    REQUIRE(max_running == 1);
+  }
+}
+
+TEST_CASE("Limit the running tasks of each owner", "[scheduler]") {
+  auto running     = std::array<std::atomic<int>, 2>{};
+  auto max_running = std::array<std::atomic<int>, 2>{};
+  auto tasks       = std::vector<tool_task>{};
+  for (auto idx = 0; idx < 8; ++idx) {
+    auto owner = static_cast<std::size_t>(idx % 2);
+    auto task  = tool_task{.cost = 1, .name = {}, .run = [&, owner] {
+      auto now = ++running[owner];
+      auto cur = max_running[owner].load();
+      while (now > cur && !max_running[owner].compare_exchange_weak(cur, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      --running[owner];
+    }};
+    task.owner = owner;
+    tasks.push_back(std::move(task));
+  }
+  auto owner_jobs = std::vector<std::size_t>{1, 4};
+  run_tasks(std::move(tasks), 4, 0, nullptr, owner_jobs);
+  REQUIRE(max_running[0] == 1);
+  REQUIRE(max_running[1] > 1);
+}
+
+TEST_CASE("Measure the peak memory of tasks", "[scheduler]") {
+  record_task_memory(100);
+  auto tasks = make_tasks({{"a", 1}, {"b", 2}});
+  tasks[0].run = [] {
+    record_task_memory(10);
+    record_task_memory(30);
+    record_task_memory(20);
+  };
+  auto measures = run_tasks(std::move(tasks), 2, 0);
+  REQUIRE(measures.durations.size() == 2);
+  REQUIRE(measures.memories == task_memories{{"a", 30}});
+
+  auto next = make_tasks({{"a", 1}, {"b", 2}});
+  apply_task_memories(next, measures.memories);
+  REQUIRE(next[0].memory == 30);
+  REQUIRE(next[1].memory == 0);
+}
+
+TEST_CASE("Replace estimated costs by measured durations", "[scheduler]") {
+  auto tasks = make_tasks({{"a", 100}, {"b", 200}, {"c", 50}});
+
+  SECTION("Scale the costs of tasks not measured") {
+    apply_task_durations(tasks, {{"a", 10}, {"b", 20}});
+    REQUIRE(tasks[0].cost == 10);
+    REQUIRE(tasks[1].cost == 20);
+    REQUIRE(tasks[2].cost == 5);
+  }
+
+  SECTION("Keep the costs if nothing measured") {
+    apply_task_durations(tasks, {{"d", 10}});
+    REQUIRE(tasks[2].cost == 50);
+  }
+}
+
+TEST_CASE("Partition tasks into shards", "[scheduler]") {
+  auto costs = {
+    std::pair{"a", std::uint64_t{70}},
+    std::pair{"b", std::uint64_t{50}},
+    std::pair{"c", std::uint64_t{40}},
+    std::pair{"d", std::uint64_t{30}},
+    std::pair{"e", std::uint64_t{10}}
+  };
+
+  SECTION("Balance shards by costs") {
+    REQUIRE(names_of(select_shard(make_tasks(costs), 0, 2)) == std::vector<std::string>{"a", "d"});
+    REQUIRE(names_of(select_shard(make_tasks(costs), 1, 2))
+            == std::vector<std::string>{"b", "c", "e"});
+  }
+
+  SECTION("Don't depend on the order of tasks") {
+    auto reversed = make_tasks(costs);
+    std::ranges::reverse(reversed);
+    REQUIRE(names_of(select_shard(std::move(reversed), 0, 2))
+            == names_of(select_shard(make_tasks(costs), 0, 2)));
+  }
+
+  SECTION("Every task belongs to one shard") {
+    auto all = std::vector<std::string>{};
+    for (auto idx = std::size_t{0}; idx < 3; ++idx) {
+      std::ranges::move(names_of(select_shard(make_tasks(costs), idx, 3)), std::back_inserter(all));
+    }
+    std::ranges::sort(all);
+    REQUIRE(all == std::vector<std::string>{"a", "b", "c", "d", "e"});
+  }
+}
+
+TEST_CASE("Partition files into shards", "[scheduler]") {
+  auto root = std::filesystem::temp_directory_path() / "cpp-linter-test-shard-files";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+  auto sizes = {std::pair{"a.cpp", 70}, std::pair{"b.cpp", 50}, std::pair{"c.cpp", 40}};
+  for (auto [name, size]: sizes) {
+    auto file = std::ofstream{root / name};
+    file << std::string(size, 'x');
+  }
+  auto files = std::vector<std::string>{"c.cpp", "b.cpp", "a.cpp", "d.cpp"};
+
+  REQUIRE(select_shard_files(files, root.string(), 0, 1) == files);
+  REQUIRE(select_shard_files(files, root.string(), 0, 2)
+          == std::vector<std::string>{"a.cpp", "d.cpp"});
+  REQUIRE(select_shard_files(files, root.string(), 1, 2)
+          == std::vector<std::string>{"c.cpp", "b.cpp"});
+  std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Merge results of shards", "[scheduler]") {
+  auto first        = multi_files_result_base<fake_result>{};
+  first.passes["a"] = {.passed = true};
+  first.ignored     = {"x"};
+  auto second       = multi_files_result_base<fake_result>{};
+  second.fails["b"] = {.passed = false};
+  second.ignored    = {"x", "y"};
+  second.timed_out  = {"z"};
+  auto serialized   = nlohmann::json(second);
+
+  auto merged = multi_files_result_base<fake_result>{};
+  merge_results(merged, nlohmann::json(first).get<multi_files_result_base<fake_result>>(), true);
+  REQUIRE(merged.final_passed);
+  merge_results(merged, serialized.get<multi_files_result_base<fake_result>>(), true);
+  REQUIRE_FALSE(merged.final_passed);
+  REQUIRE(merged.passes.contains("a"));
+  REQUIRE(merged.fails.contains("b"));
+  REQUIRE(merged.ignored == std::vector<std::string>{"x", "y"});
+  REQUIRE(merged.timed_out == std::vector<std::string>{"z"});
+}
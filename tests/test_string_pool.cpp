@@ -0,0 +1,46 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "utils/string_pool.h"
+
+using namespace linter; // NOLINT
+
+TEST_CASE("Intern strings", "[string_pool]") {
+  auto pool   = string_pool{};
+  auto first  = pool.intern(std::string{"/src/a.cpp"});
+  auto second = pool.intern("/src/a.cpp");
+  REQUIRE(first == "/src/a.cpp");
+  REQUIRE(first.data() == second.data());
+  REQUIRE(pool.intern("/src/b.cpp") == "/src/b.cpp");
+  REQUIRE(pool.size() == 20);
+
+  // Stored strings aren't looked up.
+  auto stored = pool.store("/src/a.cpp");
+  REQUIRE(stored == first);
+  REQUIRE(stored.data() != first.data());
+  REQUIRE(pool.intern("").empty());
+}
+
+TEST_CASE("Store strings larger than a block", "[string_pool]") {
+  auto pool  = string_pool{};
+  auto small = pool.store("abc");
+  auto large = pool.store(std::string(1024 * 1024, 'x'));
+  auto next  = pool.store("def");
+  REQUIRE(large.size() == 1024 * 1024);
+  REQUIRE(large.find_first_not_of('x') == std::string_view::npos);
+  // Small strings are still packed into the same block.
+  REQUIRE(next.data() == small.data() + small.size());
+  REQUIRE(small == "abc");
+  REQUIRE(next == "def");
+}
+
+TEST_CASE("Clear stored strings", "[string_pool]") {
+  auto pool = string_pool{};
+  pool.intern("/src/a.cpp");
+  pool.store("abc");
+  pool.clear();
+  REQUIRE(pool.size() == 0);
+  REQUIRE(pool.intern("/src/a.cpp") == "/src/a.cpp");
+  REQUIRE(pool.size() == 10);
+}
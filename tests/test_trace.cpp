@@ -0,0 +1,33 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+#include "utils/trace.h"
+
+using namespace linter; // NOLINT
+
+TEST_CASE("Record scopes only if enabled", "[trace]") {
+  {
+    auto scope = trace::scope{"git", "before enabled"};
+  }
+  trace::set_counter("before enabled", 1);
+  REQUIRE(trace::events().empty());
+  REQUIRE(trace::counters().empty());
+
+  trace::enable();
+  trace::set_counter("git_cached_bytes", 42);
+  {
+    auto outer = trace::scope{"check", "outer"};
+    auto inner = trace::scope{"task", "inner", "detail"};
+  }
+  auto events = trace::events();
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0].start <= events[1].start);
+  REQUIRE(std::ranges::any_of(events, [](const auto &evt) { return evt.detail == "detail"; }));
+
+  auto summary = trace::make_summary();
+  REQUIRE(summary.contains("| check | 1 |"));
+  REQUIRE(summary.contains("| task | 1 |"));
+  REQUIRE(summary.contains("| git_cached_bytes | 42 |"));
+  REQUIRE(summary.contains("CPU time"));
+}